@@ -39,6 +39,8 @@
 #include <linux/version.h>
 #include <linux/if_arp.h> /* ARPHRD_ETHER */
 #include <linux/etherdevice.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
 
 #include "../globals.h"
 #include "ecdev.h"
@@ -49,6 +51,19 @@
 
 #define EC_GEN_RX_BUF_SIZE 1600
 
+/** Maximum number of received frames waiting for the next poll, if the
+ * packet socket is bypassed.
+ */
+#define EC_GEN_RX_QUEUE_SIZE 256
+
+/** Number of preallocated transmit frames, if the packet socket is bypassed.
+ *
+ * A frame can be reused, as soon as the stack released it. This has to cover
+ * the frames of a few cycles, that the queueing discipline or the driver may
+ * still hold.
+ */
+#define EC_GEN_TX_POOL_SIZE 32
+
 /*****************************************************************************/
 
 int __init ec_gen_init_module(void);
@@ -63,6 +78,12 @@ MODULE_DESCRIPTION("EtherCAT master generic Ethernet device module");
 MODULE_LICENSE("GPL");
 MODULE_VERSION(EC_MASTER_VERSION);
 
+static bool bypass_socket; /**< Bypass the packet socket. */
+
+module_param_named(bypass_socket, bypass_socket, bool, S_IRUGO);
+MODULE_PARM_DESC(bypass_socket, "Pass frames to and from the driver directly"
+        " instead of using a packet socket");
+
 /** \endcond */
 
 struct list_head generic_devices;
@@ -74,6 +95,16 @@ typedef struct {
     struct socket *socket;
     ec_device_t *ecdev;
     uint8_t *rx_buf;
+    struct packet_type packet_type; /**< Receive hook, if the socket is
+                                      bypassed. */
+    int packet_type_added; /**< \a packet_type is registered. */
+    struct sk_buff_head rx_queue; /**< Received frames, if the socket is
+                                    bypassed. */
+    struct sk_buff *tx_pool[EC_GEN_TX_POOL_SIZE]; /**< Transmit frames, if
+                                                    the socket is bypassed.
+                                                    */
+    unsigned int tx_pool_next; /**< Next frame of \a tx_pool to try. */
+    unsigned int tx_headroom; /**< Headroom of the \a tx_pool frames. */
 } ec_gen_device_t;
 
 typedef struct {
@@ -148,6 +179,11 @@ int ec_gen_device_init(
     dev->ecdev = NULL;
     dev->socket = NULL;
     dev->rx_buf = NULL;
+    dev->packet_type_added = 0;
+    skb_queue_head_init(&dev->rx_queue);
+    memset(dev->tx_pool, 0x00, sizeof(dev->tx_pool));
+    dev->tx_pool_next = 0;
+    dev->tx_headroom = 0;
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
     dev->netdev = alloc_netdev(sizeof(ec_gen_device_t *), &null,
@@ -181,6 +217,8 @@ void ec_gen_device_clear(
         ec_gen_device_t *dev
         )
 {
+    unsigned int i;
+
     if (dev->ecdev) {
         ecdev_close(dev->ecdev);
         ecdev_withdraw(dev->ecdev);
@@ -188,6 +226,16 @@ void ec_gen_device_clear(
     if (dev->socket) {
         sock_release(dev->socket);
     }
+    if (dev->packet_type_added) {
+        dev_remove_pack(&dev->packet_type);
+    }
+    skb_queue_purge(&dev->rx_queue);
+    for (i = 0; i < EC_GEN_TX_POOL_SIZE; i++) {
+        if (dev->tx_pool[i]) {
+            // the stack may still hold a reference
+            kfree_skb(dev->tx_pool[i]);
+        }
+    }
     free_netdev(dev->netdev);
 
     if (dev->rx_buf) {
@@ -245,6 +293,72 @@ int ec_gen_device_create_socket(
 
 /*****************************************************************************/
 
+/** Receive hook, if the packet socket is bypassed.
+ *
+ * Called by the network stack for every EtherCAT frame received on the used
+ * interface. The frame is queued as is and handed to the master in place by
+ * the next ec_gen_device_poll().
+ */
+static int ec_gen_packet_rcv(
+        struct sk_buff *skb,
+        struct net_device *netdev,
+        struct packet_type *pt,
+        struct net_device *orig_dev
+        )
+{
+    ec_gen_device_t *dev =
+        container_of(pt, ec_gen_device_t, packet_type);
+
+    skb = skb_share_check(skb, GFP_ATOMIC);
+    if (!skb) {
+        return NET_RX_DROP;
+    }
+
+    if (skb_queue_len(&dev->rx_queue) >= EC_GEN_RX_QUEUE_SIZE
+            || skb_linearize(skb)) {
+        kfree_skb(skb);
+        return NET_RX_DROP;
+    }
+
+    skb_queue_tail(&dev->rx_queue, skb);
+    return NET_RX_SUCCESS;
+}
+
+/*****************************************************************************/
+
+/** Registers the receive hook, if the packet socket is bypassed.
+ */
+int ec_gen_device_create_hook(
+        ec_gen_device_t *dev,
+        ec_gen_interface_desc_t *desc
+        )
+{
+    unsigned int i;
+
+    printk(KERN_INFO PFX "Hooking into interface %i (%s).\n",
+            desc->ifindex, desc->name);
+
+    dev->tx_headroom = LL_RESERVED_SPACE(desc->netdev);
+    for (i = 0; i < EC_GEN_TX_POOL_SIZE; i++) {
+        dev->tx_pool[i] = alloc_skb(dev->tx_headroom + ETH_FRAME_LEN,
+                GFP_KERNEL);
+        if (!dev->tx_pool[i]) {
+            printk(KERN_ERR PFX "Failed to allocate transmit frames.\n");
+            return -ENOMEM;
+        }
+    }
+
+    memset(&dev->packet_type, 0x00, sizeof(dev->packet_type));
+    dev->packet_type.type = htons(ETH_P_ETHERCAT);
+    dev->packet_type.dev = desc->netdev;
+    dev->packet_type.func = ec_gen_packet_rcv;
+    dev_add_pack(&dev->packet_type);
+    dev->packet_type_added = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Offer generic device to master.
  */
 int ec_gen_device_offer(
@@ -259,7 +373,8 @@ int ec_gen_device_offer(
 
     dev->ecdev = ecdev_offer(dev->netdev, ec_gen_poll, THIS_MODULE);
     if (dev->ecdev) {
-        if (ec_gen_device_create_socket(dev, desc)) {
+        if (bypass_socket ? ec_gen_device_create_hook(dev, desc)
+                : ec_gen_device_create_socket(dev, desc)) {
             ecdev_withdraw(dev->ecdev);
             dev->ecdev = NULL;
         } else if (ecdev_open(dev->ecdev)) {
@@ -298,6 +413,81 @@ int ec_gen_device_stop(
 
 /*****************************************************************************/
 
+/** Takes a free frame from the transmit pool.
+ *
+ * A frame is free, if the stack dropped its reference and no clone (for
+ * example of a packet tap) shares its data any more. An extra reference
+ * is taken for the stack, so that the frame stays in the pool after
+ * sending (the same way pktgen reuses its frames).
+ *
+ * \return Frame, or NULL if all frames are still in use.
+ */
+static struct sk_buff *ec_gen_device_pool_get(
+        ec_gen_device_t *dev,
+        size_t size
+        )
+{
+    struct sk_buff *skb;
+    unsigned int i;
+
+    if (size > ETH_FRAME_LEN) {
+        return NULL;
+    }
+
+    for (i = 0; i < EC_GEN_TX_POOL_SIZE; i++) {
+        skb = dev->tx_pool[dev->tx_pool_next];
+        dev->tx_pool_next = (dev->tx_pool_next + 1) % EC_GEN_TX_POOL_SIZE;
+        if (skb && !skb_shared(skb) && !skb_cloned(skb)) {
+            // reset the frame, the stack may have moved the data pointer
+            skb->data = skb->head + dev->tx_headroom;
+            skb_reset_tail_pointer(skb);
+            skb->len = 0;
+            skb_get(skb);
+            return skb;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Hands a frame to the used interface, if the packet socket is bypassed.
+ *
+ * The master refills its transmit buffers in the next cycles, while the
+ * queueing discipline or the driver may still hold the frame, so the frame
+ * is copied into a preallocated frame of the transmit pool. Only if all of
+ * them are still in use, a new frame is allocated.
+ *
+ * A frame dropped by the stack is reported as a transmit error, like a
+ * failed send on the packet socket.
+ */
+static int ec_gen_device_direct_xmit(
+        ec_gen_device_t *dev,
+        struct sk_buff *skb
+        )
+{
+    struct sk_buff *tx_skb;
+    int ret;
+
+    tx_skb = ec_gen_device_pool_get(dev, skb->len);
+    if (tx_skb) {
+        memcpy(skb_put(tx_skb, skb->len), skb->data, skb->len);
+    } else if (!(tx_skb = skb_copy(skb, GFP_ATOMIC))) {
+        return NETDEV_TX_BUSY;
+    }
+
+    tx_skb->dev = dev->used_netdev;
+    tx_skb->protocol = htons(ETH_P_ETHERCAT);
+    skb_reset_mac_header(tx_skb);
+    skb_reset_network_header(tx_skb);
+
+    ret = dev_queue_xmit(tx_skb); // consumes tx_skb in any case
+    return net_xmit_eval(ret) ? NETDEV_TX_BUSY : NETDEV_TX_OK;
+}
+
+/*****************************************************************************/
+
 int ec_gen_device_start_xmit(
         ec_gen_device_t *dev,
         struct sk_buff *skb
@@ -310,6 +500,10 @@ int ec_gen_device_start_xmit(
 
     ecdev_set_link(dev->ecdev, netif_carrier_ok(dev->used_netdev));
 
+    if (bypass_socket) {
+        return ec_gen_device_direct_xmit(dev, skb);
+    }
+
     iov.iov_base = skb->data;
     iov.iov_len = len;
     memset(&msg, 0, sizeof(msg));
@@ -333,6 +527,18 @@ void ec_gen_device_poll(
 
     ecdev_set_link(dev->ecdev, netif_carrier_ok(dev->used_netdev));
 
+    if (bypass_socket) {
+        struct sk_buff *skb;
+
+        // process all frames received since the last poll in place
+        while ((skb = skb_dequeue(&dev->rx_queue))) {
+            ecdev_receive(dev->ecdev, skb_mac_header(skb),
+                    skb->len + (skb->data - skb_mac_header(skb)));
+            kfree_skb(skb);
+        }
+        return;
+    }
+
     do {
         iov.iov_base = dev->rx_buf;
         iov.iov_len = EC_GEN_RX_BUF_SIZE;
@@ -0,0 +1,1305 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+
+/** \file
+ * EtherCAT simulated segment device module.
+ *
+ * Offers a virtual Ethernet device to the master, that does not send any
+ * frames to the wire. Instead, each frame is processed by a chain of
+ * simulated EtherCAT slave controllers (ESCs) and handed back to the master
+ * on the next poll.
+ *
+ * The simulation covers the register space with the station address, the AL
+ * state machine, the SII interface, sync managers, FMMUs and the distributed
+ * clock registers, as well as a CoE mailbox responder for expedited SDO
+ * transfers. It is meant for benchmarking and regression testing of the
+ * master without hardware; the timing behaviour of real slaves is not
+ * reproduced.
+ */
+
+/*****************************************************************************/
+
+#include <linux/module.h>
+#include <linux/err.h>
+#include <linux/version.h>
+#include <linux/etherdevice.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+
+#include "../globals.h"
+#include "../include/ecrt.h"
+#include "ecdev.h"
+
+#define PFX "ec_sim: "
+
+#define ETH_P_ETHERCAT 0x88A4
+
+/** Maximum number of simulated slaves. */
+#define EC_SIM_MAX_SLAVES 65535
+
+/** Size of the simulated ESC memory (registers and process data RAM). */
+#define EC_SIM_MEM_SIZE 0x2000
+
+/** Number of FMMUs of a simulated slave. */
+#define EC_SIM_FMMU_COUNT 8
+
+/** Number of sync managers of a simulated slave. */
+#define EC_SIM_SYNC_COUNT 8
+
+/** Size of the simulated SII image in words. */
+#define EC_SIM_SII_WORDS 128
+
+/** Physical start address and size of the mailboxes. */
+#define EC_SIM_RX_MBOX_ADDRESS 0x1000
+#define EC_SIM_TX_MBOX_ADDRESS 0x1080
+#define EC_SIM_MBOX_SIZE 128
+
+/** Physical start addresses of the process data sync managers. */
+#define EC_SIM_OUTPUT_ADDRESS 0x1100
+#define EC_SIM_INPUT_ADDRESS 0x1800
+
+/** Number of object values, that can be downloaded to a simulated slave. */
+#define EC_SIM_SDO_COUNT 64
+
+/** Forwarding delay of a simulated slave per direction in ns. */
+#define EC_SIM_PORT_DELAY_NS 100
+
+/** Number of processed frames waiting for the next poll. */
+#define EC_SIM_RX_RING_SIZE 64
+
+/** Identity of the simulated slaves. */
+#define EC_SIM_VENDOR_ID 0x00000000
+#define EC_SIM_PRODUCT_CODE 0x00000001
+#define EC_SIM_REVISION_NUMBER 0x00010000
+
+/** Mailbox protocol flag for CoE in the SII. */
+#define EC_SIM_MBOX_COE 0x04
+
+/*****************************************************************************/
+
+int __init ec_sim_init_module(void);
+void __exit ec_sim_cleanup_module(void);
+
+/*****************************************************************************/
+
+/** \cond */
+
+MODULE_AUTHOR("Florian Pose <fp@igh-essen.com>");
+MODULE_DESCRIPTION("EtherCAT master simulated segment device module");
+MODULE_LICENSE("GPL");
+MODULE_VERSION(EC_MASTER_VERSION);
+
+static unsigned int slave_count = 16; /**< Number of simulated slaves. */
+static bool mailbox = 1; /**< Slaves support CoE. */
+static unsigned int latency_us; /**< Delay until a frame returns. */
+static unsigned int loss_ppm; /**< Frame loss rate. */
+
+module_param_named(slaves, slave_count, uint, S_IRUGO);
+MODULE_PARM_DESC(slaves, "Number of simulated slaves");
+module_param_named(mailbox, mailbox, bool, S_IRUGO);
+MODULE_PARM_DESC(mailbox, "Simulated slaves support CoE");
+module_param_named(latency_us, latency_us, uint, S_IRUGO);
+MODULE_PARM_DESC(latency_us, "Time in us, until a frame is returned");
+module_param_named(loss_ppm, loss_ppm, uint, S_IRUGO);
+MODULE_PARM_DESC(loss_ppm, "Frames lost per million");
+
+/** \endcond */
+
+/** EtherCAT commands.
+ */
+enum {
+    EC_SIM_CMD_NOP, EC_SIM_CMD_APRD, EC_SIM_CMD_APWR, EC_SIM_CMD_APRW,
+    EC_SIM_CMD_FPRD, EC_SIM_CMD_FPWR, EC_SIM_CMD_FPRW, EC_SIM_CMD_BRD,
+    EC_SIM_CMD_BWR, EC_SIM_CMD_BRW, EC_SIM_CMD_LRD, EC_SIM_CMD_LWR,
+    EC_SIM_CMD_LRW, EC_SIM_CMD_ARMW, EC_SIM_CMD_FRMW
+};
+
+/** Memory access types.
+ */
+enum {
+    EC_SIM_READ = 0x01, /**< Read into the frame. */
+    EC_SIM_WRITE = 0x02, /**< Write from the frame. */
+    EC_SIM_READ_OR = 0x04 /**< Read into the frame with a bitwise OR. */
+};
+
+/** Downloaded object value.
+ */
+typedef struct {
+    uint16_t index; /**< Object index. 0 means unused. */
+    uint8_t subindex; /**< Object subindex. */
+    uint8_t size; /**< Value size in bytes. */
+    uint32_t value; /**< Value. */
+} ec_sim_sdo_t;
+
+/** Simulated slave.
+ */
+typedef struct {
+    uint16_t position; /**< Ring position. */
+    uint64_t clock_offset; /**< Local clock minus simulator time. */
+    uint8_t mem[EC_SIM_MEM_SIZE]; /**< ESC memory. */
+    uint8_t sii[EC_SIM_SII_WORDS * 2]; /**< SII image. */
+    ec_sim_sdo_t sdos[EC_SIM_SDO_COUNT]; /**< Downloaded values. */
+} ec_sim_slave_t;
+
+/** Processed frame.
+ */
+typedef struct {
+    uint8_t data[ETH_FRAME_LEN]; /**< Frame data. */
+    size_t size; /**< Frame size. */
+    u64 due; /**< Time, when the frame shall be returned [ns]. */
+} ec_sim_frame_t;
+
+/** Simulated segment device.
+ */
+typedef struct {
+    struct net_device *netdev; /**< Net device offered to the master. */
+    ec_device_t *ecdev; /**< Master device. */
+    ec_sim_slave_t *slaves; /**< Simulated slaves. */
+    unsigned int slave_count; /**< Number of simulated slaves. */
+    uint16_t *station_map; /**< Maps station addresses to ring positions
+                             + 1. 0 means unknown. */
+    ec_sim_frame_t *rx_ring; /**< Frames waiting for the next poll. */
+    unsigned int rx_head; /**< Next frame to process. */
+    unsigned int rx_tail; /**< Next frame to return. */
+    uint8_t scratch[ETH_FRAME_LEN]; /**< Buffer for read/write commands. */
+    uint32_t random; /**< Pseudo-random generator state. */
+} ec_sim_device_t;
+
+static ec_sim_device_t *sim_device; /**< The simulated segment. */
+
+/** Simulator time base. */
+static u64 ec_sim_time_base;
+
+/*****************************************************************************/
+
+/** Current simulator time.
+ *
+ * \return Time in ns.
+ */
+static inline u64 ec_sim_now(void)
+{
+    return ktime_to_ns(ktime_get()) - ec_sim_time_base;
+}
+
+/*****************************************************************************/
+
+/** Pseudo-random number.
+ *
+ * A simple xorshift generator with a fixed seed is used, so that loss
+ * patterns are reproducible.
+ *
+ * \return Next pseudo-random number.
+ */
+static uint32_t ec_sim_random(ec_sim_device_t *sim)
+{
+    uint32_t x = sim->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->random = x;
+    return x;
+}
+
+/*****************************************************************************/
+
+/** Checks, if a memory area overlaps a register.
+ *
+ * \return Non-zero, if the areas overlap.
+ */
+static inline int ec_sim_overlaps(
+        uint16_t address, /**< Start of the accessed area. */
+        size_t size, /**< Size of the accessed area. */
+        uint16_t reg, /**< Register address. */
+        size_t reg_size /**< Register size. */
+        )
+{
+    return address < reg + reg_size && reg < address + size;
+}
+
+/*****************************************************************************/
+
+/** Checks, if a register byte is read-only for the master.
+ *
+ * \return Non-zero, if the byte is read-only.
+ */
+static inline int ec_sim_read_only(uint16_t address)
+{
+    return address < 0x0010 // type, features
+        || (address >= 0x0110 && address < 0x0112) // DL status
+        || (address >= 0x0130 && address < 0x0136) // AL status and code
+        || (address >= 0x0900 && address < 0x0920) // DC receive times
+        || (address >= 0x092C && address < 0x0930); // DC time difference
+}
+
+/*****************************************************************************/
+
+/** Local time of a slave, when the frame passes its processing unit.
+ *
+ * \return Local time in ns.
+ */
+static u64 ec_sim_slave_local_time(
+        const ec_sim_slave_t *slave, /**< Simulated slave. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    return time + (u64) slave->position * EC_SIM_PORT_DELAY_NS
+        + slave->clock_offset;
+}
+
+/*****************************************************************************/
+
+/** Latches the DC receive times.
+ *
+ * The segment is simulated as a line: The frame passes port 0 of all slaves
+ * in ring order, is looped back by the last slave and passes port 1 of all
+ * other slaves on its way back.
+ */
+static void ec_sim_slave_latch(
+        const ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    u64 local = ec_sim_slave_local_time(slave, time);
+    unsigned int hops = 2 * (sim->slave_count - 1 - slave->position);
+
+    EC_WRITE_U32(slave->mem + 0x0900, (uint32_t) local);
+    if (hops) {
+        EC_WRITE_U32(slave->mem + 0x0904,
+                (uint32_t) (local + hops * EC_SIM_PORT_DELAY_NS));
+    }
+    EC_WRITE_U64(slave->mem + 0x0918, local);
+}
+
+/*****************************************************************************/
+
+/** Adjusts the system time offset of a slave to a written system time.
+ *
+ * The control loop of a real ESC is replaced by an immediate correction, so
+ * the system time difference is always zero.
+ */
+static void ec_sim_slave_sync(
+        const ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t address, /**< Start of the written area. */
+        const uint8_t *data, /**< Written data. */
+        size_t size, /**< Size of the written area. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    uint8_t buf[8];
+    u64 offset = EC_READ_U64(slave->mem + 0x0920);
+    u64 own = ec_sim_slave_local_time(slave, time) + offset;
+    u64 received;
+    unsigned int i;
+
+    // bytes not written are taken from the own system time
+    EC_WRITE_U64(buf, own);
+    for (i = 0; i < 8; i++) {
+        if (0x0910 + i >= address && 0x0910 + i < address + size) {
+            buf[i] = data[0x0910 + i - address];
+        }
+    }
+    received = EC_READ_U64(buf) + EC_READ_U32(slave->mem + 0x0928);
+
+    EC_WRITE_U64(slave->mem + 0x0920, offset + received - own);
+}
+
+/*****************************************************************************/
+
+/** Processes a write access to the AL control register.
+ */
+static void ec_sim_slave_al_control(
+        ec_sim_slave_t *slave /**< Simulated slave. */
+        )
+{
+    uint8_t request = EC_READ_U8(slave->mem + 0x0120) & 0x0F;
+
+    switch (request) {
+        case 0x01: // INIT
+        case 0x02: // PREOP
+        case 0x03: // BOOT
+        case 0x04: // SAFEOP
+        case 0x08: // OP
+            EC_WRITE_U8(slave->mem + 0x0130, request);
+            EC_WRITE_U16(slave->mem + 0x0134, 0x0000);
+            break;
+        default:
+            // invalid requested state change
+            EC_WRITE_U8(slave->mem + 0x0130,
+                    EC_READ_U8(slave->mem + 0x0130) | 0x10);
+            EC_WRITE_U16(slave->mem + 0x0134, 0x0011);
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+/** Processes a command written to the SII control register.
+ */
+static void ec_sim_slave_sii_command(
+        ec_sim_slave_t *slave /**< Simulated slave. */
+        )
+{
+    uint8_t command = EC_READ_U8(slave->mem + 0x0503);
+    uint16_t word = EC_READ_U16(slave->mem + 0x0504);
+    unsigned int i;
+
+    if (command & 0x01) { // read 4 words
+        for (i = 0; i < 4; i++) {
+            EC_WRITE_U16(slave->mem + 0x0508 + 2 * i,
+                    word + i < EC_SIM_SII_WORDS ?
+                    EC_READ_U16(slave->sii + 2 * (word + i)) : 0xFFFF);
+        }
+    } else if (command & 0x02) { // write 1 word
+        if (word < EC_SIM_SII_WORDS) {
+            EC_WRITE_U16(slave->sii + 2 * word,
+                    EC_READ_U16(slave->mem + 0x0508));
+        }
+    }
+
+    // command executed immediately, 8 byte read access supported
+    EC_WRITE_U8(slave->mem + 0x0502,
+            (EC_READ_U8(slave->mem + 0x0502) & 0x81) | 0x40);
+    EC_WRITE_U8(slave->mem + 0x0503, 0x00);
+}
+
+/*****************************************************************************/
+
+/** Looks up the value of an object.
+ *
+ * \return 0 on success, else the SDO abort code.
+ */
+static uint32_t ec_sim_slave_sdo_upload(
+        const ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t index, /**< Object index. */
+        uint8_t subindex, /**< Object subindex. */
+        uint32_t *value, /**< Value. */
+        uint8_t *size /**< Value size. */
+        )
+{
+    unsigned int i;
+
+    *size = 4;
+
+    switch (index) {
+        case 0x1000: // device type
+            *value = 0x00000000;
+            return subindex ? 0x06090011 : 0;
+        case 0x1018: // identity
+            switch (subindex) {
+                case 0:
+                    *value = 4;
+                    *size = 1;
+                    return 0;
+                case 1:
+                case 2:
+                case 3:
+                case 4:
+                    *value = EC_READ_U32(slave->sii + 2 * (0x0006
+                                + 2 * subindex));
+                    return 0;
+                default:
+                    return 0x06090011;
+            }
+    }
+
+    for (i = 0; i < EC_SIM_SDO_COUNT; i++) {
+        const ec_sim_sdo_t *sdo = &slave->sdos[i];
+        if (sdo->index == index && sdo->subindex == subindex) {
+            *value = sdo->value;
+            *size = sdo->size;
+            return 0;
+        }
+    }
+
+    // empty PDO mappings and assignments
+    if (index >= 0x1600 && index < 0x1C30 && !subindex) {
+        *value = 0;
+        *size = 1;
+        return 0;
+    }
+
+    return 0x06020000; // object does not exist
+}
+
+/*****************************************************************************/
+
+/** Stores a downloaded object value.
+ *
+ * \return 0 on success, else the SDO abort code.
+ */
+static uint32_t ec_sim_slave_sdo_download(
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t index, /**< Object index. */
+        uint8_t subindex, /**< Object subindex. */
+        uint32_t value, /**< Value. */
+        uint8_t size /**< Value size. */
+        )
+{
+    ec_sim_sdo_t *sdo, *free_sdo = NULL;
+    unsigned int i;
+
+    if (index == 0x1000 || index == 0x1018) {
+        return 0x06010002; // read only
+    }
+
+    for (i = 0; i < EC_SIM_SDO_COUNT; i++) {
+        sdo = &slave->sdos[i];
+        if (sdo->index == index && sdo->subindex == subindex) {
+            free_sdo = sdo;
+            break;
+        }
+        if (!sdo->index && !free_sdo) {
+            free_sdo = sdo;
+        }
+    }
+
+    if (!free_sdo) {
+        return 0x05040005; // out of memory
+    }
+
+    free_sdo->index = index;
+    free_sdo->subindex = subindex;
+    free_sdo->value = value;
+    free_sdo->size = size;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Answers a CoE request.
+ *
+ * Only expedited SDO transfers are supported.
+ *
+ * \return Size of the CoE response.
+ */
+static size_t ec_sim_slave_coe(
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        const uint8_t *request, /**< CoE request. */
+        size_t size, /**< Request size. */
+        uint8_t *response /**< CoE response. */
+        )
+{
+    uint8_t command, value_size;
+    uint16_t index;
+    uint8_t subindex;
+    uint32_t value = 0, abort_code;
+
+    if (size < 10 || EC_READ_U16(request) >> 12 != 0x2) { // SDO request
+        return 0;
+    }
+
+    command = EC_READ_U8(request + 2);
+    index = EC_READ_U16(request + 3);
+    subindex = EC_READ_U8(request + 5);
+
+    if (command & 0x10) {
+        abort_code = 0x06010000; // complete access not supported
+    } else if ((command >> 5) == 0x2) { // upload
+        abort_code = ec_sim_slave_sdo_upload(slave, index, subindex,
+                &value, &value_size);
+        if (!abort_code) {
+            EC_WRITE_U16(response, 0x3 << 12); // SDO response
+            EC_WRITE_U8(response + 2, 0x43 | ((4 - value_size) << 2));
+            EC_WRITE_U16(response + 3, index);
+            EC_WRITE_U8(response + 5, subindex);
+            EC_WRITE_U32(response + 6, value);
+            return 10;
+        }
+    } else if ((command >> 5) == 0x1) { // download
+        if (!(command & 0x02)) {
+            abort_code = 0x06010000; // only expedited transfers
+        } else {
+            value_size = command & 0x01 ? 4 - ((command >> 2) & 0x03) : 4;
+            value = EC_READ_U32(request + 6);
+            if (value_size < 4) {
+                value &= (1U << (value_size * 8)) - 1;
+            }
+            abort_code = ec_sim_slave_sdo_download(slave, index, subindex,
+                    value, value_size);
+            if (!abort_code) {
+                EC_WRITE_U16(response, 0x3 << 12); // SDO response
+                EC_WRITE_U8(response + 2, 0x60);
+                EC_WRITE_U16(response + 3, index);
+                EC_WRITE_U8(response + 5, subindex);
+                EC_WRITE_U32(response + 6, 0x00000000);
+                return 10;
+            }
+        }
+    } else {
+        abort_code = 0x05040001; // command specifier not valid
+    }
+
+    EC_WRITE_U16(response, 0x2 << 12); // SDO request
+    EC_WRITE_U8(response + 2, 0x80); // abort
+    EC_WRITE_U16(response + 3, index);
+    EC_WRITE_U8(response + 5, subindex);
+    EC_WRITE_U32(response + 6, abort_code);
+    return 10;
+}
+
+/*****************************************************************************/
+
+/** Processes a mailbox request written by the master.
+ *
+ * The response is placed in the read mailbox and the mailbox full flag of
+ * sync manager 1 is set.
+ */
+static void ec_sim_slave_mailbox(
+        ec_sim_slave_t *slave /**< Simulated slave. */
+        )
+{
+    uint16_t rx = EC_READ_U16(slave->mem + 0x0800);
+    uint16_t rx_size = EC_READ_U16(slave->mem + 0x0802);
+    uint16_t tx = EC_READ_U16(slave->mem + 0x0808);
+    uint16_t tx_size = EC_READ_U16(slave->mem + 0x080A);
+    uint8_t *request = slave->mem + rx, *response = slave->mem + tx;
+    size_t size, response_size = 0;
+    uint8_t type;
+
+    if (!(EC_READ_U8(slave->mem + 0x080E) & 0x01) || rx_size < 6
+            || tx_size < 16 || rx + rx_size > EC_SIM_MEM_SIZE
+            || tx + tx_size > EC_SIM_MEM_SIZE) {
+        return;
+    }
+
+    size = EC_READ_U16(request);
+    type = EC_READ_U8(request + 5);
+    if (size > rx_size - 6) {
+        size = rx_size - 6;
+    }
+
+    if ((type & 0x0F) == 0x03 && mailbox) {
+        response_size = ec_sim_slave_coe(slave, request + 6, size,
+                response + 6);
+        if (!response_size) {
+            return;
+        }
+    } else {
+        // mailbox error: unsupported protocol
+        type = 0x00;
+        EC_WRITE_U16(response + 6, 0x0001);
+        EC_WRITE_U16(response + 8, 0x0002);
+        response_size = 4;
+    }
+
+    EC_WRITE_U16(response, response_size);
+    EC_WRITE_U16(response + 2, 0x0000);
+    EC_WRITE_U8(response + 4, 0x00);
+    EC_WRITE_U8(response + 5, type);
+    EC_WRITE_U8(slave->mem + 0x080D, EC_READ_U8(slave->mem + 0x080D) | 0x08);
+}
+
+/*****************************************************************************/
+
+/** Reads from the memory of a simulated slave.
+ */
+static void ec_sim_slave_read(
+        const ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t address, /**< Physical address. */
+        uint8_t *data, /**< Frame data. */
+        size_t size, /**< Number of bytes. */
+        unsigned int type, /**< EC_SIM_READ or EC_SIM_READ_OR. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    uint16_t tx, tx_size;
+    size_t i;
+
+    if (address >= EC_SIM_MEM_SIZE) {
+        return;
+    }
+    if (address + size > EC_SIM_MEM_SIZE) {
+        size = EC_SIM_MEM_SIZE - address;
+    }
+
+    if (ec_sim_overlaps(address, size, 0x0910, 8)) {
+        EC_WRITE_U64(slave->mem + 0x0910,
+                ec_sim_slave_local_time(slave, time)
+                + EC_READ_U64(slave->mem + 0x0920));
+    }
+
+    if (type == EC_SIM_READ_OR) {
+        for (i = 0; i < size; i++) {
+            data[i] |= slave->mem[address + i];
+        }
+    } else {
+        memcpy(data, slave->mem + address, size);
+    }
+
+    // reading the last byte of the read mailbox empties it
+    tx = EC_READ_U16(slave->mem + 0x0808);
+    tx_size = EC_READ_U16(slave->mem + 0x080A);
+    if (tx_size && ec_sim_overlaps(address, size, tx + tx_size - 1, 1)) {
+        EC_WRITE_U8(slave->mem + 0x080D,
+                EC_READ_U8(slave->mem + 0x080D) & ~0x08);
+    }
+}
+
+/*****************************************************************************/
+
+/** Writes to the memory of a simulated slave.
+ */
+static void ec_sim_slave_write(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t address, /**< Physical address. */
+        const uint8_t *data, /**< Frame data. */
+        size_t size, /**< Number of bytes. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    uint16_t rx, rx_size;
+    size_t i;
+
+    if (address >= EC_SIM_MEM_SIZE) {
+        return;
+    }
+    if (address + size > EC_SIM_MEM_SIZE) {
+        size = EC_SIM_MEM_SIZE - address;
+    }
+
+    if (address >= 0x1000) { // process data RAM
+        memcpy(slave->mem + address, data, size);
+    } else {
+        for (i = 0; i < size; i++) {
+            if (!ec_sim_read_only(address + i)) {
+                slave->mem[address + i] = data[i];
+            }
+        }
+
+        if (ec_sim_overlaps(address, size, 0x0010, 2)) {
+            sim->station_map[EC_READ_U16(slave->mem + 0x0010)] =
+                slave->position + 1;
+        }
+        if (ec_sim_overlaps(address, size, 0x0120, 1)) {
+            ec_sim_slave_al_control(slave);
+        }
+        if (ec_sim_overlaps(address, size, 0x0503, 1)) {
+            ec_sim_slave_sii_command(slave);
+        }
+        if (ec_sim_overlaps(address, size, 0x0900, 1)) {
+            ec_sim_slave_latch(sim, slave, time);
+        }
+        if (ec_sim_overlaps(address, size, 0x0910, 8)) {
+            ec_sim_slave_sync(sim, slave, address, data, size, time);
+        }
+    }
+
+    // writing the last byte of the write mailbox passes the request
+    rx = EC_READ_U16(slave->mem + 0x0800);
+    rx_size = EC_READ_U16(slave->mem + 0x0802);
+    if (rx_size && (EC_READ_U8(slave->mem + 0x0806) & 0x01)
+            && ec_sim_overlaps(address, size, rx + rx_size - 1, 1)) {
+        ec_sim_slave_mailbox(slave);
+    }
+}
+
+/*****************************************************************************/
+
+/** Processes a physically addressed command at a simulated slave.
+ *
+ * \return Working counter increment.
+ */
+static unsigned int ec_sim_slave_access(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        unsigned int type, /**< Access type. */
+        uint16_t address, /**< Physical address. */
+        uint8_t *data, /**< Frame data. */
+        size_t size, /**< Number of bytes. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    unsigned int read_type = type & (EC_SIM_READ | EC_SIM_READ_OR);
+
+    if (read_type && (type & EC_SIM_WRITE)) {
+        // the frame data are written, the previous memory content is read
+        memcpy(sim->scratch, data, size);
+        ec_sim_slave_read(sim, slave, address, data, size, read_type, time);
+        ec_sim_slave_write(sim, slave, address, sim->scratch, size, time);
+        return 3;
+    } else if (read_type) {
+        ec_sim_slave_read(sim, slave, address, data, size, read_type, time);
+        return 1;
+    } else {
+        ec_sim_slave_write(sim, slave, address, data, size, time);
+        return 1;
+    }
+}
+
+/*****************************************************************************/
+
+/** Processes a logically addressed command at a simulated slave.
+ *
+ * FMMUs are evaluated with byte granularity; start and stop bits are
+ * ignored.
+ *
+ * \return Working counter increment.
+ */
+static unsigned int ec_sim_slave_logical(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        unsigned int type, /**< Access type. */
+        uint32_t address, /**< Logical address. */
+        uint8_t *data, /**< Frame data. */
+        size_t size, /**< Number of bytes. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    unsigned int pass, i, wc = 0;
+
+    // writes take the frame data, before reads replace them
+    for (pass = EC_SIM_WRITE; pass >= EC_SIM_READ; pass >>= 1) {
+        if (!(type & pass)) {
+            continue;
+        }
+
+        for (i = 0; i < EC_SIM_FMMU_COUNT; i++) {
+            const uint8_t *fmmu = slave->mem + 0x0600 + 16 * i;
+            uint32_t start = EC_READ_U32(fmmu), begin, end;
+            uint16_t physical = EC_READ_U16(fmmu + 8);
+
+            if (!(EC_READ_U8(fmmu + 12) & 0x01)
+                    || !(EC_READ_U8(fmmu + 11) & pass)) {
+                continue;
+            }
+
+            begin = max(start, address);
+            end = min(start + EC_READ_U16(fmmu + 4), address + (uint32_t) size);
+            if (begin >= end) {
+                continue;
+            }
+
+            if (pass == EC_SIM_WRITE) {
+                ec_sim_slave_write(sim, slave, physical + begin - start,
+                        data + begin - address, end - begin, time);
+            } else {
+                ec_sim_slave_read(sim, slave, physical + begin - start,
+                        data + begin - address, end - begin, EC_SIM_READ,
+                        time);
+            }
+            wc |= pass;
+        }
+    }
+
+    // LRW: 1 for reading, 2 for writing
+    return type == EC_SIM_WRITE ? !!wc : wc;
+}
+
+/*****************************************************************************/
+
+/** Finds a simulated slave by its station address.
+ *
+ * \return Slave, or NULL.
+ */
+static ec_sim_slave_t *ec_sim_find_station(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        uint16_t address /**< Station address. */
+        )
+{
+    unsigned int i = sim->station_map[address];
+
+    if (i && EC_READ_U16(sim->slaves[i - 1].mem + 0x0010) == address) {
+        return &sim->slaves[i - 1];
+    }
+
+    for (i = 0; i < sim->slave_count; i++) {
+        if (EC_READ_U16(sim->slaves[i].mem + 0x0010) == address) {
+            sim->station_map[address] = i + 1;
+            return &sim->slaves[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Processes a datagram.
+ */
+static void ec_sim_process_datagram(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        uint8_t *datagram, /**< Datagram header. */
+        size_t size, /**< Data size. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    static const unsigned int access[] = {
+        0, EC_SIM_READ, EC_SIM_WRITE, EC_SIM_READ | EC_SIM_WRITE,
+        EC_SIM_READ, EC_SIM_WRITE, EC_SIM_READ | EC_SIM_WRITE,
+        EC_SIM_READ_OR, EC_SIM_WRITE, EC_SIM_READ_OR | EC_SIM_WRITE,
+        EC_SIM_READ, EC_SIM_WRITE, EC_SIM_READ | EC_SIM_WRITE,
+        EC_SIM_READ, EC_SIM_READ
+    };
+    uint8_t command = EC_READ_U8(datagram);
+    uint16_t adp = EC_READ_U16(datagram + 2);
+    uint16_t ado = EC_READ_U16(datagram + 4);
+    uint8_t *data = datagram + 10;
+    uint16_t wc = EC_READ_U16(data + size);
+    ec_sim_slave_t *slave = NULL;
+    unsigned int i, position;
+
+    if (command >= ARRAY_SIZE(access)) {
+        return;
+    }
+
+    switch (command) {
+        case EC_SIM_CMD_APRD:
+        case EC_SIM_CMD_APWR:
+        case EC_SIM_CMD_APRW:
+            position = (uint16_t) -adp;
+            if (position < sim->slave_count) {
+                wc += ec_sim_slave_access(sim, &sim->slaves[position],
+                        access[command], ado, data, size, time);
+            }
+            EC_WRITE_U16(datagram + 2, adp + sim->slave_count);
+            break;
+        case EC_SIM_CMD_FPRD:
+        case EC_SIM_CMD_FPWR:
+        case EC_SIM_CMD_FPRW:
+            slave = ec_sim_find_station(sim, adp);
+            if (slave) {
+                wc += ec_sim_slave_access(sim, slave, access[command], ado,
+                        data, size, time);
+            }
+            break;
+        case EC_SIM_CMD_BRD:
+        case EC_SIM_CMD_BWR:
+        case EC_SIM_CMD_BRW:
+            for (i = 0; i < sim->slave_count; i++) {
+                wc += ec_sim_slave_access(sim, &sim->slaves[i],
+                        access[command], ado, data, size, time);
+            }
+            EC_WRITE_U16(datagram + 2, adp + sim->slave_count);
+            break;
+        case EC_SIM_CMD_LRD:
+        case EC_SIM_CMD_LWR:
+        case EC_SIM_CMD_LRW:
+            for (i = 0; i < sim->slave_count; i++) {
+                wc += ec_sim_slave_logical(sim, &sim->slaves[i],
+                        access[command], EC_READ_U32(datagram + 2), data,
+                        size, time);
+            }
+            break;
+        case EC_SIM_CMD_ARMW:
+        case EC_SIM_CMD_FRMW:
+            // the addressed slave reads, all others write
+            if (command == EC_SIM_CMD_ARMW) {
+                position = (uint16_t) -adp;
+            } else {
+                slave = ec_sim_find_station(sim, adp);
+                position = slave ? slave->position : sim->slave_count;
+            }
+            for (i = 0; i < sim->slave_count; i++) {
+                wc += ec_sim_slave_access(sim, &sim->slaves[i],
+                        i == position ? EC_SIM_READ : EC_SIM_WRITE,
+                        ado, data, size, time);
+            }
+            if (command == EC_SIM_CMD_ARMW) {
+                EC_WRITE_U16(datagram + 2, adp + sim->slave_count);
+            }
+            break;
+        default:
+            break;
+    }
+
+    EC_WRITE_U16(data + size, wc);
+}
+
+/*****************************************************************************/
+
+/** Passes a frame through the simulated segment.
+ */
+static void ec_sim_process_frame(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        uint8_t *frame, /**< Frame data. */
+        size_t size, /**< Frame size. */
+        u64 time /**< Simulator time, when the frame entered the segment. */
+        )
+{
+    uint8_t *cur, *end;
+    uint16_t header;
+    size_t data_size;
+
+    if (size < ETH_HLEN + 2
+            || ((frame[12] << 8) | frame[13]) != ETH_P_ETHERCAT) {
+        return;
+    }
+
+    end = frame + ETH_HLEN + 2 + (EC_READ_U16(frame + ETH_HLEN) & 0x07FF);
+    if (end > frame + size) {
+        return;
+    }
+
+    // the first slave marks the source address as locally administered
+    frame[6] |= 0x02;
+
+    cur = frame + ETH_HLEN + 2;
+    while (cur + 12 <= end) {
+        header = EC_READ_U16(cur + 6);
+        data_size = header & 0x07FF;
+        if (cur + 12 + data_size > end) {
+            break;
+        }
+        ec_sim_process_datagram(sim, cur, data_size, time);
+        cur += 12 + data_size;
+        if (!(header & 0x8000)) { // no more datagrams
+            break;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Initializes a simulated slave.
+ */
+static void ec_sim_slave_init(
+        ec_sim_device_t *sim, /**< Simulated segment. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        uint16_t position /**< Ring position. */
+        )
+{
+    static const char name[] = "Simulated slave";
+    uint8_t *cat, *syncs;
+    unsigned int i;
+    int last = position == sim->slave_count - 1;
+
+    memset(slave, 0x00, sizeof(*slave));
+    slave->position = position;
+    slave->clock_offset = (u64) ec_sim_random(sim) * 1000;
+
+    // ESC information
+    EC_WRITE_U8(slave->mem + 0x0000, 0x11); // type
+    EC_WRITE_U8(slave->mem + 0x0004, EC_SIM_FMMU_COUNT);
+    EC_WRITE_U8(slave->mem + 0x0005, EC_SIM_SYNC_COUNT);
+    EC_WRITE_U8(slave->mem + 0x0006, (EC_SIM_MEM_SIZE - 0x1000) / 1024);
+    EC_WRITE_U8(slave->mem + 0x0007, 0x0A); // ports 0 and 1: E-Bus
+    EC_WRITE_U16(slave->mem + 0x0008, 0x000C); // DC, 64 bit system time
+
+    // DL status: link and communication on port 0 (and 1, if not last),
+    // loop closed on all other ports
+    EC_WRITE_U16(slave->mem + 0x0110, last ? 0x5610 : 0x5A30);
+
+    EC_WRITE_U8(slave->mem + 0x0130, 0x01); // INIT
+    EC_WRITE_U8(slave->mem + 0x0502, 0x40); // 8 byte SII read access
+
+    // SII image
+    memset(slave->sii, 0xFF, sizeof(slave->sii));
+    memset(slave->sii, 0x00, 0x0040 * 2);
+    EC_WRITE_U32(slave->sii + 2 * 0x0008, EC_SIM_VENDOR_ID);
+    EC_WRITE_U32(slave->sii + 2 * 0x000A, EC_SIM_PRODUCT_CODE);
+    EC_WRITE_U32(slave->sii + 2 * 0x000C, EC_SIM_REVISION_NUMBER);
+    EC_WRITE_U32(slave->sii + 2 * 0x000E, position + 1); // serial number
+    for (i = 0; i < 2; i++) { // bootstrap and standard mailbox
+        EC_WRITE_U16(slave->sii + 2 * (0x0014 + 4 * i),
+                EC_SIM_RX_MBOX_ADDRESS);
+        EC_WRITE_U16(slave->sii + 2 * (0x0015 + 4 * i), EC_SIM_MBOX_SIZE);
+        EC_WRITE_U16(slave->sii + 2 * (0x0016 + 4 * i),
+                EC_SIM_TX_MBOX_ADDRESS);
+        EC_WRITE_U16(slave->sii + 2 * (0x0017 + 4 * i), EC_SIM_MBOX_SIZE);
+    }
+    EC_WRITE_U16(slave->sii + 2 * 0x001C, mailbox ? EC_SIM_MBOX_COE : 0);
+    EC_WRITE_U16(slave->sii + 2 * 0x003E, EC_SIM_SII_WORDS * 16 / 1024 - 1);
+    EC_WRITE_U16(slave->sii + 2 * 0x003F, 0x0001); // version
+
+    // strings category
+    cat = slave->sii + 2 * 0x0040;
+    EC_WRITE_U16(cat, 0x000A);
+    EC_WRITE_U16(cat + 2, (2 + sizeof(name)) / 2);
+    memset(cat + 4, 0x00, 2 + sizeof(name));
+    EC_WRITE_U8(cat + 4, 1);
+    EC_WRITE_U8(cat + 5, sizeof(name) - 1);
+    memcpy(cat + 6, name, sizeof(name) - 1);
+    cat += 4 + 2 * EC_READ_U16(cat + 2);
+
+    // general category
+    EC_WRITE_U16(cat, 0x001E);
+    EC_WRITE_U16(cat + 2, 16);
+    memset(cat + 4, 0x00, 32);
+    EC_WRITE_U8(cat + 4 + 3, 1); // name string
+    EC_WRITE_U8(cat + 4 + 5, mailbox ? 0x0D : 0x00); // SDO, PDO assign/conf.
+    cat += 4 + 32;
+
+    // sync manager category
+    EC_WRITE_U16(cat, 0x0029);
+    EC_WRITE_U16(cat + 2, 16);
+    syncs = cat + 4;
+    EC_WRITE_U16(syncs, EC_SIM_RX_MBOX_ADDRESS);
+    EC_WRITE_U16(syncs + 2, EC_SIM_MBOX_SIZE);
+    EC_WRITE_U32(syncs + 4, 0x01010026); // mailbox out
+    syncs += 8;
+    EC_WRITE_U16(syncs, EC_SIM_TX_MBOX_ADDRESS);
+    EC_WRITE_U16(syncs + 2, EC_SIM_MBOX_SIZE);
+    EC_WRITE_U32(syncs + 4, 0x02010022); // mailbox in
+    syncs += 8;
+    EC_WRITE_U16(syncs, EC_SIM_OUTPUT_ADDRESS);
+    EC_WRITE_U16(syncs + 2, 0);
+    EC_WRITE_U32(syncs + 4, 0x03010064); // process data outputs
+    syncs += 8;
+    EC_WRITE_U16(syncs, EC_SIM_INPUT_ADDRESS);
+    EC_WRITE_U16(syncs + 2, 0);
+    EC_WRITE_U32(syncs + 4, 0x04010020); // process data inputs
+    cat += 4 + 32;
+
+    EC_WRITE_U16(cat, 0xFFFF); // end
+}
+
+/*****************************************************************************/
+
+static int ec_sim_netdev_open(struct net_device *dev)
+{
+    return 0;
+}
+
+/*****************************************************************************/
+
+static int ec_sim_netdev_stop(struct net_device *dev)
+{
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Passes a frame through the simulated segment.
+ *
+ * The frame is processed immediately and queued for the next poll. Lost
+ * frames are dropped before they reach the first slave.
+ */
+static int ec_sim_netdev_start_xmit(
+        struct sk_buff *skb,
+        struct net_device *dev
+        )
+{
+    ec_sim_device_t *sim = *((ec_sim_device_t **) netdev_priv(dev));
+    unsigned int next = (sim->rx_head + 1) % EC_SIM_RX_RING_SIZE;
+    ec_sim_frame_t *frame = &sim->rx_ring[sim->rx_head];
+    u64 now = ec_sim_now();
+
+    if (skb->len > ETH_FRAME_LEN || next == sim->rx_tail) {
+        return NETDEV_TX_OK; // dropped
+    }
+
+    if (loss_ppm && ec_sim_random(sim) % 1000000 < loss_ppm) {
+        return NETDEV_TX_OK; // lost
+    }
+
+    memcpy(frame->data, skb->data, skb->len);
+    frame->size = skb->len;
+    frame->due = now + (u64) latency_us * 1000;
+    ec_sim_process_frame(sim, frame->data, frame->size, now);
+    sim->rx_head = next;
+    return NETDEV_TX_OK;
+}
+
+/*****************************************************************************/
+
+/** Polls the simulated device.
+ *
+ * Returns all frames, whose latency has elapsed.
+ */
+static void ec_sim_poll(struct net_device *dev)
+{
+    ec_sim_device_t *sim = *((ec_sim_device_t **) netdev_priv(dev));
+    u64 now = ec_sim_now();
+
+    while (sim->rx_tail != sim->rx_head) {
+        ec_sim_frame_t *frame = &sim->rx_ring[sim->rx_tail];
+        if ((s64) (frame->due - now) > 0) {
+            break;
+        }
+        ecdev_receive(sim->ecdev, frame->data, frame->size);
+        sim->rx_tail = (sim->rx_tail + 1) % EC_SIM_RX_RING_SIZE;
+    }
+}
+
+/*****************************************************************************/
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
+static const struct net_device_ops ec_sim_netdev_ops = {
+    .ndo_open       = ec_sim_netdev_open,
+    .ndo_stop       = ec_sim_netdev_stop,
+    .ndo_start_xmit = ec_sim_netdev_start_xmit,
+};
+#endif
+
+/*****************************************************************************/
+
+/** Clears the simulated segment.
+ */
+static void ec_sim_device_clear(
+        ec_sim_device_t *sim /**< Simulated segment. */
+        )
+{
+    if (sim->ecdev) {
+        ecdev_close(sim->ecdev);
+        ecdev_withdraw(sim->ecdev);
+    }
+    if (sim->netdev) {
+        free_netdev(sim->netdev);
+    }
+    if (sim->rx_ring) {
+        vfree(sim->rx_ring);
+    }
+    if (sim->station_map) {
+        vfree(sim->station_map);
+    }
+    if (sim->slaves) {
+        vfree(sim->slaves);
+    }
+}
+
+/*****************************************************************************/
+
+/** Initializes the simulated segment and offers it to the master.
+ *
+ * \return 0 on success, else < 0
+ */
+static int ec_sim_device_init(
+        ec_sim_device_t *sim /**< Simulated segment. */
+        )
+{
+    static const uint8_t address[ETH_ALEN] = {
+        0x02, 0xEC, 0x00, 0x00, 0x00, 0x00};
+    ec_sim_device_t **priv;
+    unsigned int i;
+    char null = 0x00;
+
+    memset(sim, 0x00, sizeof(*sim));
+    sim->slave_count = slave_count;
+    sim->random = 0x2545F491;
+
+    sim->slaves = vmalloc(sizeof(ec_sim_slave_t) * sim->slave_count);
+    sim->station_map = vmalloc(sizeof(uint16_t) * 0x10000);
+    sim->rx_ring = vmalloc(sizeof(ec_sim_frame_t) * EC_SIM_RX_RING_SIZE);
+    if (!sim->slaves || !sim->station_map || !sim->rx_ring) {
+        printk(KERN_ERR PFX "Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
+    memset(sim->station_map, 0x00, sizeof(uint16_t) * 0x10000);
+    for (i = 0; i < sim->slave_count; i++) {
+        ec_sim_slave_init(sim, &sim->slaves[i], i);
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
+    sim->netdev = alloc_netdev(sizeof(ec_sim_device_t *), &null,
+            NET_NAME_UNKNOWN, ether_setup);
+#else
+    sim->netdev = alloc_netdev(sizeof(ec_sim_device_t *), &null,
+            ether_setup);
+#endif
+    if (!sim->netdev) {
+        return -ENOMEM;
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
+    sim->netdev->netdev_ops = &ec_sim_netdev_ops;
+#else
+    sim->netdev->open = ec_sim_netdev_open;
+    sim->netdev->stop = ec_sim_netdev_stop;
+    sim->netdev->hard_start_xmit = ec_sim_netdev_start_xmit;
+#endif
+    memcpy(sim->netdev->dev_addr, address, ETH_ALEN);
+
+    priv = netdev_priv(sim->netdev);
+    *priv = sim;
+
+    sim->ecdev = ecdev_offer(sim->netdev, ec_sim_poll, THIS_MODULE);
+    if (!sim->ecdev) {
+        printk(KERN_ERR PFX "No master accepted the simulated device.\n");
+        return -ENODEV;
+    }
+
+    if (ecdev_open(sim->ecdev)) {
+        ecdev_withdraw(sim->ecdev);
+        sim->ecdev = NULL;
+        return -EIO;
+    }
+
+    ecdev_set_link(sim->ecdev, 1);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Module initialization.
+ *
+ * \return 0 on success, else < 0
+ */
+int __init ec_sim_init_module(void)
+{
+    int ret;
+
+    printk(KERN_INFO PFX "EtherCAT master simulated segment device module"
+            " %s\n", EC_MASTER_VERSION);
+
+    if (!slave_count || slave_count > EC_SIM_MAX_SLAVES) {
+        printk(KERN_ERR PFX "Invalid number of slaves %u!\n", slave_count);
+        return -EINVAL;
+    }
+
+    ec_sim_time_base = ktime_to_ns(ktime_get());
+
+    sim_device = kmalloc(sizeof(ec_sim_device_t), GFP_KERNEL);
+    if (!sim_device) {
+        return -ENOMEM;
+    }
+
+    ret = ec_sim_device_init(sim_device);
+    if (ret) {
+        ec_sim_device_clear(sim_device);
+        kfree(sim_device);
+        return ret;
+    }
+
+    printk(KERN_INFO PFX "Simulating %u slaves (latency %u us,"
+            " loss %u ppm).\n", slave_count, latency_us, loss_ppm);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Module cleanup.
+ */
+void __exit ec_sim_cleanup_module(void)
+{
+    ec_sim_device_clear(sim_device);
+    kfree(sim_device);
+    printk(KERN_INFO PFX "Unloading.\n");
+}
+
+/*****************************************************************************/
+
+/** \cond */
+
+module_init(ec_sim_init_module);
+module_exit(ec_sim_cleanup_module);
+
+/** \endcond */
+
+/*****************************************************************************/
@@ -0,0 +1,840 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+
+/** \file
+ * Cycle benchmark.
+ *
+ * Runs the standard cyclic loop (receive, domain processing, distributed
+ * clocks synchronisation, domain queueing, send) at a configurable rate and
+ * records wakeup jitter, the time spent in each realtime call, the
+ * send-to-receive latency and working counter failures. The results are
+ * written in JSON format.
+ */
+
+/****************************************************************************/
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sched.h> /* sched_setscheduler() */
+
+/****************************************************************************/
+
+#include "ecrt.h"
+
+/****************************************************************************/
+
+#define NSEC_PER_SEC (1000000000L)
+#define CLOCK_TO_USE CLOCK_MONOTONIC
+
+#define DIFF_NS(A, B) (((int64_t) (B).tv_sec - (A).tv_sec) * NSEC_PER_SEC \
+        + (B).tv_nsec - (A).tv_nsec)
+
+#define TIMESPEC2NS(T) ((uint64_t) (T).tv_sec * NSEC_PER_SEC + (T).tv_nsec)
+
+/** Maximum number of domains. */
+#define MAX_DOMAINS 16
+
+/** Maximum number of PDO entries per PDO. */
+#define MAX_ENTRIES 254
+
+/** Number of bits used for sub-buckets per power of two.
+ *
+ * The relative resolution of the statistics is 2^-STAT_SUB_BITS.
+ */
+#define STAT_SUB_BITS 3
+
+/** Number of histogram buckets, covering the full 32 bit nanosecond range.
+ */
+#define STAT_BUCKETS ((32 - STAT_SUB_BITS + 1) << STAT_SUB_BITS)
+
+/****************************************************************************/
+
+/** Cycle variants.
+ */
+typedef enum {
+    MODE_CALLS, /**< One call per operation. */
+    MODE_CYCLE, /**< ecrt_master_cycle(). */
+    MODE_RING /**< Command ring. */
+} bench_mode_t;
+
+static const char *mode_names[] = {"calls", "cycle", "ring"};
+
+/** Statistics of a measured time.
+ */
+typedef struct {
+    const char *name; /**< Name in the results. */
+    uint64_t count; /**< Number of samples. */
+    uint64_t sum; /**< Sum of all samples in ns. */
+    uint32_t min; /**< Minimum sample in ns. */
+    uint32_t max; /**< Maximum sample in ns. */
+    uint32_t buckets[STAT_BUCKETS]; /**< Log-linear histogram. */
+} stat_t;
+
+/** Measured times.
+ */
+enum {
+    STAT_WAKEUP, /**< Wakeup jitter. */
+    STAT_PERIOD, /**< Cycle period. */
+    STAT_EXEC, /**< Execution time of the cycle. */
+    STAT_RECEIVE, /**< ecrt_master_receive(). */
+    STAT_PROCESS, /**< ecrt_domain_process(), for all domains. */
+    STAT_DC, /**< Distributed clocks calls. */
+    STAT_QUEUE, /**< ecrt_domain_queue(), for all domains. */
+    STAT_SEND, /**< ecrt_master_send(). */
+    STAT_CYCLE, /**< ecrt_master_cycle() or ecrt_master_cmd_ring_exec(). */
+    STAT_LATENCY, /**< Send-to-receive latency. */
+    STAT_COUNT
+};
+
+/****************************************************************************/
+
+// parameters
+static unsigned int master_index = 0;
+static unsigned int frequency = 1000;
+static unsigned int cycles = 10000;
+static unsigned int warmup = 1000;
+static unsigned int domain_count = 1;
+static int slave_count = -1;
+static unsigned int bytes = 0;
+static int use_dc = 0;
+static int poll_receive = 0;
+static bench_mode_t mode = MODE_CALLS;
+static int priority = -1;
+static const char *output = NULL;
+
+// EtherCAT
+static ec_master_t *master = NULL;
+static ec_domain_t *domains[MAX_DOMAINS];
+static unsigned int domain_sizes[MAX_DOMAINS];
+
+// results
+static stat_t stats[STAT_COUNT];
+static uint64_t wc_failures = 0;
+static uint64_t overruns = 0;
+static uint64_t poll_timeouts = 0;
+
+/****************************************************************************/
+
+static void stat_init(void)
+{
+    static const char *names[STAT_COUNT] = {
+        "wakeup_jitter", "period", "exec", "receive", "domain_process",
+        "dc_sync", "domain_queue", "send", "cycle", "send_to_receive"
+    };
+    unsigned int i;
+
+    for (i = 0; i < STAT_COUNT; i++) {
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].name = names[i];
+        stats[i].min = 0xffffffff;
+    }
+}
+
+/****************************************************************************/
+
+static unsigned int stat_bucket(uint32_t ns)
+{
+    unsigned int msb;
+
+    if (ns < (1U << STAT_SUB_BITS)) {
+        return ns;
+    }
+
+    msb = 31 - __builtin_clz(ns);
+    return ((msb - STAT_SUB_BITS + 1) << STAT_SUB_BITS)
+        | ((ns >> (msb - STAT_SUB_BITS)) & ((1U << STAT_SUB_BITS) - 1));
+}
+
+/****************************************************************************/
+
+static uint32_t stat_bucket_floor(unsigned int bucket)
+{
+    unsigned int shift;
+
+    if (bucket < (1U << STAT_SUB_BITS)) {
+        return bucket;
+    }
+
+    shift = (bucket >> STAT_SUB_BITS) - 1;
+    return ((1U << STAT_SUB_BITS)
+            | (bucket & ((1U << STAT_SUB_BITS) - 1))) << shift;
+}
+
+/****************************************************************************/
+
+static void stat_add(stat_t *stat, int64_t ns)
+{
+    uint32_t value = ns < 0 ? 0 : (ns > 0xffffffff ? 0xffffffff : ns);
+
+    stat->count++;
+    stat->sum += value;
+    if (value < stat->min) {
+        stat->min = value;
+    }
+    if (value > stat->max) {
+        stat->max = value;
+    }
+    stat->buckets[stat_bucket(value)]++;
+}
+
+/****************************************************************************/
+
+/** Returns the lower bound of the bucket containing a quantile.
+ */
+static uint32_t stat_quantile(const stat_t *stat, double q)
+{
+    uint64_t rank = (uint64_t) (q * stat->count), sum = 0;
+    unsigned int i;
+
+    for (i = 0; i < STAT_BUCKETS; i++) {
+        sum += stat->buckets[i];
+        if (sum > rank) {
+            return stat_bucket_floor(i);
+        }
+    }
+
+    return stat->max;
+}
+
+/****************************************************************************/
+
+static void stat_print(FILE *f, const stat_t *stat, int last)
+{
+    if (!stat->count) {
+        fprintf(f, "    \"%s\": null%s\n", stat->name, last ? "" : ",");
+        return;
+    }
+
+    fprintf(f, "    \"%s\": {\"count\": %llu, \"min_ns\": %u,"
+            " \"mean_ns\": %llu, \"p50_ns\": %u, \"p99_ns\": %u,"
+            " \"p999_ns\": %u, \"max_ns\": %u}%s\n",
+            stat->name, (unsigned long long) stat->count, stat->min,
+            (unsigned long long) (stat->sum / stat->count),
+            stat_quantile(stat, 0.5), stat_quantile(stat, 0.99),
+            stat_quantile(stat, 0.999), stat->max, last ? "" : ",");
+}
+
+/****************************************************************************/
+
+static int write_results(void)
+{
+    FILE *f = stdout;
+    unsigned int i;
+
+    if (output && !(f = fopen(output, "w"))) {
+        fprintf(stderr, "Failed to open %s: %s\n", output, strerror(errno));
+        return -1;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version_magic\": %u,\n", ecrt_version_magic());
+    fprintf(f, "  \"config\": {\"mode\": \"%s\", \"frequency\": %u,"
+            " \"cycles\": %u, \"slaves\": %d, \"domains\": %u,"
+            " \"bytes\": %u, \"dc\": %s, \"poll\": %s},\n",
+            mode_names[mode], frequency, cycles, slave_count, domain_count,
+            bytes, use_dc ? "true" : "false",
+            poll_receive ? "true" : "false");
+    fprintf(f, "  \"domain_sizes\": [");
+    for (i = 0; i < domain_count; i++) {
+        fprintf(f, "%s%u", i ? ", " : "", domain_sizes[i]);
+    }
+    fprintf(f, "],\n");
+    fprintf(f, "  \"wc_failures\": %llu,\n",
+            (unsigned long long) wc_failures);
+    fprintf(f, "  \"overruns\": %llu,\n", (unsigned long long) overruns);
+    fprintf(f, "  \"poll_timeouts\": %llu,\n",
+            (unsigned long long) poll_timeouts);
+    fprintf(f, "  \"times\": {\n");
+    for (i = 0; i < STAT_COUNT; i++) {
+        stat_print(f, &stats[i], i == STAT_COUNT - 1);
+    }
+    fprintf(f, "  }\n}\n");
+
+    if (f != stdout) {
+        fclose(f);
+    }
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Registers the default PDO entries of a slave in a domain.
+ */
+static int register_default_pdos(ec_slave_config_t *sc, uint16_t position,
+        ec_domain_t *domain)
+{
+    ec_slave_info_t slave_info;
+    ec_sync_info_t sync;
+    ec_pdo_info_t pdo;
+    ec_pdo_entry_info_t entry;
+    unsigned int sm, i, j, bit_position;
+
+    if (ecrt_master_get_slave(master, position, &slave_info)) {
+        return -1;
+    }
+
+    for (sm = 0; sm < slave_info.sync_count; sm++) {
+        if (ecrt_master_get_sync_manager(master, position, sm, &sync)) {
+            return -1;
+        }
+        for (i = 0; i < sync.n_pdos; i++) {
+            if (ecrt_master_get_pdo(master, position, sm, i, &pdo)) {
+                return -1;
+            }
+            for (j = 0; j < pdo.n_entries; j++) {
+                if (ecrt_master_get_pdo_entry(master, position, sm, i, j,
+                            &entry)) {
+                    return -1;
+                }
+                if (!entry.index) { // gap
+                    continue;
+                }
+                if (ecrt_slave_config_reg_pdo_entry(sc, entry.index,
+                            entry.subindex, domain, &bit_position) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Configures a slave with one RxPDO and one TxPDO per domain.
+ *
+ * Each PDO maps \a bytes 8 bit entries.
+ */
+static int register_generated_pdos(ec_slave_config_t *sc)
+{
+    static ec_pdo_entry_info_t entries[2][MAX_DOMAINS][MAX_ENTRIES];
+    static ec_pdo_info_t pdos[2][MAX_DOMAINS];
+    ec_sync_info_t syncs[3];
+    unsigned int dir, d, i;
+
+    for (dir = 0; dir < 2; dir++) {
+        for (d = 0; d < domain_count; d++) {
+            for (i = 0; i < bytes; i++) {
+                entries[dir][d][i].index = (dir ? 0x6000 : 0x7000) + d;
+                entries[dir][d][i].subindex = i + 1;
+                entries[dir][d][i].bit_length = 8;
+            }
+            pdos[dir][d].index = (dir ? 0x1A00 : 0x1600) + d;
+            pdos[dir][d].n_entries = bytes;
+            pdos[dir][d].entries = entries[dir][d];
+        }
+        syncs[dir].index = 2 + dir;
+        syncs[dir].dir = dir ? EC_DIR_INPUT : EC_DIR_OUTPUT;
+        syncs[dir].n_pdos = domain_count;
+        syncs[dir].pdos = pdos[dir];
+        syncs[dir].watchdog_mode = EC_WD_DEFAULT;
+    }
+    syncs[2].index = 0xff;
+
+    if (ecrt_slave_config_pdos(sc, EC_END, syncs)) {
+        return -1;
+    }
+
+    for (dir = 0; dir < 2; dir++) {
+        for (d = 0; d < domain_count; d++) {
+            for (i = 0; i < bytes; i++) {
+                if (ecrt_slave_config_reg_pdo_entry(sc,
+                            entries[dir][d][i].index,
+                            entries[dir][d][i].subindex,
+                            domains[d], NULL) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+static int configure(void)
+{
+    ec_master_info_t master_info;
+    ec_slave_info_t slave_info;
+    ec_slave_config_t *sc;
+    unsigned int d;
+    int i;
+
+    if (ecrt_master(master, &master_info)) {
+        fprintf(stderr, "Failed to get master information.\n");
+        return -1;
+    }
+
+    if (slave_count < 0 || slave_count > (int) master_info.slave_count) {
+        slave_count = master_info.slave_count;
+    }
+
+    for (d = 0; d < domain_count; d++) {
+        if (!(domains[d] = ecrt_master_create_domain(master))) {
+            fprintf(stderr, "Failed to create domain.\n");
+            return -1;
+        }
+    }
+
+    for (i = 0; i < slave_count; i++) {
+        if (ecrt_master_get_slave(master, i, &slave_info)) {
+            fprintf(stderr, "Failed to get slave %i information.\n", i);
+            return -1;
+        }
+
+        if (!(sc = ecrt_master_slave_config(master, 0, i,
+                        slave_info.vendor_id, slave_info.product_code))) {
+            fprintf(stderr, "Failed to configure slave %i.\n", i);
+            return -1;
+        }
+
+        if (bytes ? register_generated_pdos(sc)
+                : register_default_pdos(sc, i, domains[i % domain_count])) {
+            fprintf(stderr, "Failed to register PDO entries of slave %i.\n",
+                    i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+static void add_ns(struct timespec *t, long ns)
+{
+    t->tv_nsec += ns;
+    while (t->tv_nsec >= NSEC_PER_SEC) {
+        t->tv_nsec -= NSEC_PER_SEC;
+        t->tv_sec++;
+    }
+}
+
+/****************************************************************************/
+
+/** Checks the working counters of all domains.
+ *
+ * \return Non-zero, if all domains are complete.
+ */
+static int domains_complete(void)
+{
+    ec_domain_state_t ds;
+    unsigned int d;
+
+    for (d = 0; d < domain_count; d++) {
+        ecrt_domain_state(domains[d], &ds);
+        if (ds.wc_state != EC_WC_COMPLETE) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/****************************************************************************/
+
+/** Receives and processes the domains, until all working counters are
+ * complete or the deadline is reached.
+ *
+ * \return Non-zero, if the domains are complete.
+ */
+static int poll_domains(const struct timespec *deadline)
+{
+    struct timespec now;
+    unsigned int d;
+
+    while (1) {
+        ecrt_master_receive(master);
+        for (d = 0; d < domain_count; d++) {
+            ecrt_domain_process(domains[d]);
+        }
+        if (domains_complete()) {
+            return 1;
+        }
+        clock_gettime(CLOCK_TO_USE, &now);
+        if (DIFF_NS(*deadline, now) >= 0) {
+            return 0;
+        }
+    }
+}
+
+/****************************************************************************/
+
+static int run(void)
+{
+    struct timespec wakeup, start, t1, t2, last_start = {}, deadline;
+    long period_ns = NSEC_PER_SEC / frequency;
+    unsigned int cycle, d, n;
+    ec_cmd_t cmds[2 * MAX_DOMAINS + 5];
+    int record, sync_ref = 0;
+
+    clock_gettime(CLOCK_TO_USE, &wakeup);
+
+    for (cycle = 0; cycle < warmup + cycles; cycle++) {
+        record = cycle >= warmup;
+
+        add_ns(&wakeup, period_ns);
+        clock_nanosleep(CLOCK_TO_USE, TIMER_ABSTIME, &wakeup, NULL);
+        clock_gettime(CLOCK_TO_USE, &start);
+
+        if (record) {
+            stat_add(&stats[STAT_WAKEUP], DIFF_NS(wakeup, start));
+            if (cycle > warmup) {
+                stat_add(&stats[STAT_PERIOD], DIFF_NS(last_start, start));
+            }
+            if (DIFF_NS(wakeup, start) >= period_ns) {
+                overruns++;
+            }
+        }
+        last_start = start;
+
+        if (mode == MODE_CALLS) {
+            if (!poll_receive) {
+                clock_gettime(CLOCK_TO_USE, &t1);
+                ecrt_master_receive(master);
+                clock_gettime(CLOCK_TO_USE, &t2);
+                if (record) {
+                    stat_add(&stats[STAT_RECEIVE], DIFF_NS(t1, t2));
+                }
+
+                for (d = 0; d < domain_count; d++) {
+                    ecrt_domain_process(domains[d]);
+                }
+                clock_gettime(CLOCK_TO_USE, &t1);
+                if (record) {
+                    stat_add(&stats[STAT_PROCESS], DIFF_NS(t2, t1));
+                }
+            }
+
+            if (use_dc) {
+                clock_gettime(CLOCK_TO_USE, &t1);
+                ecrt_master_application_time(master, TIMESPEC2NS(wakeup));
+                if (sync_ref) {
+                    sync_ref--;
+                } else {
+                    sync_ref = 1; // every second cycle
+                    ecrt_master_sync_reference_clock(master);
+                }
+                ecrt_master_sync_slave_clocks(master);
+                clock_gettime(CLOCK_TO_USE, &t2);
+                if (record) {
+                    stat_add(&stats[STAT_DC], DIFF_NS(t1, t2));
+                }
+            }
+
+            clock_gettime(CLOCK_TO_USE, &t1);
+            for (d = 0; d < domain_count; d++) {
+                ecrt_domain_queue(domains[d]);
+            }
+            clock_gettime(CLOCK_TO_USE, &t2);
+            if (record) {
+                stat_add(&stats[STAT_QUEUE], DIFF_NS(t1, t2));
+            }
+
+            ecrt_master_send(master);
+            clock_gettime(CLOCK_TO_USE, &t1);
+            if (record) {
+                stat_add(&stats[STAT_SEND], DIFF_NS(t2, t1));
+            }
+        } else {
+            n = 0;
+            if (!poll_receive) {
+                cmds[n++].type = EC_CMD_RECEIVE;
+                for (d = 0; d < domain_count; d++) {
+                    cmds[n].type = EC_CMD_DOMAIN_PROCESS;
+                    cmds[n++].domain = domains[d];
+                }
+            }
+            if (use_dc && mode == MODE_CYCLE) {
+                cmds[n].type = EC_CMD_APP_TIME;
+                cmds[n++].value = TIMESPEC2NS(wakeup);
+                if (sync_ref) {
+                    sync_ref--;
+                } else {
+                    sync_ref = 1; // every second cycle
+                    cmds[n++].type = EC_CMD_SYNC_REF_CLOCK;
+                }
+                cmds[n++].type = EC_CMD_SYNC_SLAVE_CLOCKS;
+            }
+            for (d = 0; d < domain_count; d++) {
+                cmds[n].type = EC_CMD_DOMAIN_QUEUE;
+                cmds[n++].domain = domains[d];
+            }
+            cmds[n++].type = EC_CMD_SEND;
+
+            if (use_dc && mode == MODE_RING) {
+                // not available in the command ring
+                clock_gettime(CLOCK_TO_USE, &t1);
+                ecrt_master_application_time(master, TIMESPEC2NS(wakeup));
+                if (sync_ref) {
+                    sync_ref--;
+                } else {
+                    sync_ref = 1; // every second cycle
+                    ecrt_master_sync_reference_clock(master);
+                }
+                ecrt_master_sync_slave_clocks(master);
+                clock_gettime(CLOCK_TO_USE, &t2);
+                if (record) {
+                    stat_add(&stats[STAT_DC], DIFF_NS(t1, t2));
+                }
+            }
+
+            clock_gettime(CLOCK_TO_USE, &t2);
+            if (mode == MODE_CYCLE) {
+                ecrt_master_cycle(master, cmds, n);
+            } else {
+                for (d = 0; d < n; d++) {
+                    ecrt_master_cmd_ring_add(master, cmds[d].type,
+                            cmds[d].domain);
+                }
+                ecrt_master_cmd_ring_exec(master);
+            }
+            clock_gettime(CLOCK_TO_USE, &t1);
+            if (record) {
+                stat_add(&stats[STAT_CYCLE], DIFF_NS(t2, t1));
+            }
+        }
+
+        if (poll_receive) {
+            // wait for the frames until half of the period has passed
+            deadline = start;
+            add_ns(&deadline, period_ns / 2);
+            if (poll_domains(&deadline)) {
+                clock_gettime(CLOCK_TO_USE, &t2);
+                if (record) {
+                    stat_add(&stats[STAT_LATENCY], DIFF_NS(t1, t2));
+                }
+            } else if (record) {
+                poll_timeouts++;
+            }
+        }
+
+        if (record && !domains_complete()) {
+            wc_failures++;
+        }
+
+        clock_gettime(CLOCK_TO_USE, &t2);
+        if (record) {
+            stat_add(&stats[STAT_EXEC], DIFF_NS(start, t2));
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTIONS]\n"
+            "Runs the cyclic loop and writes timing results as JSON.\n"
+            "\n"
+            "Options:\n"
+            "  --master     -m <index>  Master index (default 0).\n"
+            "  --frequency  -f <hz>     Cycle frequency (default 1000).\n"
+            "  --cycles     -n <count>  Measured cycles (default 10000).\n"
+            "  --warmup     -w <count>  Cycles before measuring\n"
+            "                           (default 1000).\n"
+            "  --domains    -d <count>  Number of domains (default 1, max.\n"
+            "                           %u).\n"
+            "  --slaves     -s <count>  Number of slaves to configure\n"
+            "                           (default all).\n"
+            "  --bytes      -b <count>  Configure one RxPDO and one TxPDO\n"
+            "                           with <count> byte entries per slave\n"
+            "                           and domain (max. %u). Default 0:\n"
+            "                           Register the slaves' default PDO\n"
+            "                           entries, distributing the slaves\n"
+            "                           over the domains.\n"
+            "  --dc         -c          Synchronise the distributed clocks.\n"
+            "  --mode       -M <mode>   calls (default): One call per\n"
+            "                           operation, cycle: ecrt_master_cycle(),\n"
+            "                           ring: command ring.\n"
+            "  --poll       -p          Receive right after sending, until\n"
+            "                           all working counters are complete,\n"
+            "                           to measure the send-to-receive\n"
+            "                           latency.\n"
+            "  --priority   -P <prio>   SCHED_FIFO priority (default max.,\n"
+            "                           0: do not change).\n"
+            "  --output     -o <file>   Write the results to <file>.\n"
+            "  --help       -h          Show this help.\n",
+            name, MAX_DOMAINS, MAX_ENTRIES);
+}
+
+/****************************************************************************/
+
+static int parse_args(int argc, char **argv)
+{
+    static const struct option options[] = {
+        {"master",    required_argument, NULL, 'm'},
+        {"frequency", required_argument, NULL, 'f'},
+        {"cycles",    required_argument, NULL, 'n'},
+        {"warmup",    required_argument, NULL, 'w'},
+        {"domains",   required_argument, NULL, 'd'},
+        {"slaves",    required_argument, NULL, 's'},
+        {"bytes",     required_argument, NULL, 'b'},
+        {"dc",        no_argument,       NULL, 'c'},
+        {"mode",      required_argument, NULL, 'M'},
+        {"poll",      no_argument,       NULL, 'p'},
+        {"priority",  required_argument, NULL, 'P'},
+        {"output",    required_argument, NULL, 'o'},
+        {"help",      no_argument,       NULL, 'h'},
+        {}
+    };
+    int c;
+
+    while ((c = getopt_long(argc, argv, "m:f:n:w:d:s:b:cM:pP:o:h",
+                    options, NULL)) != -1) {
+        switch (c) {
+            case 'm':
+                master_index = strtoul(optarg, NULL, 0);
+                break;
+            case 'f':
+                frequency = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                cycles = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                warmup = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                domain_count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                slave_count = strtol(optarg, NULL, 0);
+                break;
+            case 'b':
+                bytes = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                use_dc = 1;
+                break;
+            case 'M':
+                if (!strcmp(optarg, "calls")) {
+                    mode = MODE_CALLS;
+                } else if (!strcmp(optarg, "cycle")) {
+                    mode = MODE_CYCLE;
+                } else if (!strcmp(optarg, "ring")) {
+                    mode = MODE_RING;
+                } else {
+                    fprintf(stderr, "Invalid mode %s.\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'p':
+                poll_receive = 1;
+                break;
+            case 'P':
+                priority = strtol(optarg, NULL, 0);
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if (optind < argc || !frequency || !domain_count
+            || domain_count > MAX_DOMAINS || bytes > MAX_ENTRIES) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (mode == MODE_CYCLE && 2 * domain_count + 5 > EC_CYCLE_MAX_CMDS) {
+        fprintf(stderr, "Mode cycle supports at most %u domains.\n",
+                (EC_CYCLE_MAX_CMDS - 5) / 2);
+        return -1;
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int main(int argc, char **argv)
+{
+    struct sched_param param = {};
+    unsigned int d;
+
+    if (parse_args(argc, argv)) {
+        return 1;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        perror("mlockall failed");
+        return 1;
+    }
+
+    stat_init();
+
+    master = ecrt_request_master(master_index);
+    if (!master) {
+        return 1;
+    }
+
+    if (configure()) {
+        return 1;
+    }
+
+    fprintf(stderr, "Activating master with %i slaves...\n", slave_count);
+    if (ecrt_master_activate(master)) {
+        return 1;
+    }
+
+    for (d = 0; d < domain_count; d++) {
+        domain_sizes[d] = ecrt_domain_size(domains[d]);
+    }
+
+    if (mode == MODE_RING && ecrt_master_setup_cmd_ring(master)) {
+        fprintf(stderr, "Failed to set up the command ring.\n");
+        return 1;
+    }
+
+    if (priority) {
+        param.sched_priority = priority < 0 ?
+            sched_get_priority_max(SCHED_FIFO) : priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
+            perror("sched_setscheduler failed");
+        }
+    }
+
+    fprintf(stderr, "Running %u + %u cycles at %u Hz...\n",
+            warmup, cycles, frequency);
+    run();
+
+    ecrt_release_master(master);
+
+    return write_results() ? 1 : 0;
+}
+
+/****************************************************************************/
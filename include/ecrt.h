@@ -43,6 +43,18 @@
  *
  * - Added the ecrt_slave_config_flag() method and the EC_HAVE_FLAGS
  *   definition to check for its existence.
+ * - Added a memory-mapped command ring for userspace applications, to execute
+ *   the cyclic receive, domain processing, domain queueing and send calls
+ *   with a single system call: ecrt_master_setup_cmd_ring(),
+ *   ecrt_master_cmd_ring_add(), ecrt_master_cmd_ring_exec(), the
+ *   ec_cmd_type_t enumeration and the EC_HAVE_CMD_RING feature flag.
+ * - Added ecrt_master_cycle() and the ec_cmd_t type, to execute a sequence
+ *   of cyclic commands, including the distributed clocks calls, with a
+ *   single system call, and the EC_HAVE_CYCLE feature flag.
+ * - Added a master-side distributed clocks drift compensation controller:
+ *   ecrt_master_dc_pll_config(), ecrt_master_dc_pll_state(), the types
+ *   ec_dc_pll_mode_t, ec_dc_pll_config_t and ec_dc_pll_state_t and the
+ *   EC_HAVE_DC_PLL feature flag.
  *
  * Changes in version 1.5.2:
  *
@@ -204,6 +216,20 @@
  */
 #define EC_HAVE_FLAGS
 
+/** Defined if the command ring methods ecrt_master_setup_cmd_ring(),
+ * ecrt_master_cmd_ring_add() and ecrt_master_cmd_ring_exec() are available.
+ */
+#define EC_HAVE_CMD_RING
+
+/** Defined if the method ecrt_master_cycle() is available.
+ */
+#define EC_HAVE_CYCLE
+
+/** Defined if the methods ecrt_master_dc_pll_config() and
+ * ecrt_master_dc_pll_state() are available.
+ */
+#define EC_HAVE_DC_PLL
+
 /*****************************************************************************/
 
 /** End of list marker.
@@ -585,6 +611,132 @@ typedef enum {
     EC_AL_STATE_OP = 8, /**< Operational. */
 } ec_al_state_t;
 
+/*****************************************************************************/
+
+/** Cyclic command type.
+ *
+ * This is used with ecrt_master_cycle() and with the command ring, see
+ * ecrt_master_setup_cmd_ring().
+ */
+typedef enum {
+    EC_CMD_NONE, /**< No operation. */
+    EC_CMD_RECEIVE, /**< Receive frames, see ecrt_master_receive(). */
+    EC_CMD_SEND, /**< Send frames, see ecrt_master_send(). */
+    EC_CMD_DOMAIN_PROCESS, /**< Process a domain, see
+                             ecrt_domain_process(). */
+    EC_CMD_DOMAIN_QUEUE, /**< Queue a domain, see ecrt_domain_queue(). */
+    EC_CMD_APP_TIME, /**< Set the application time from the command value,
+                       see ecrt_master_application_time(). */
+    EC_CMD_SYNC_REF_CLOCK, /**< See ecrt_master_sync_reference_clock(). */
+    EC_CMD_SYNC_REF_CLOCK_TO, /**< Sync the reference clock to the command
+                                value, see
+                                ecrt_master_sync_reference_clock_to(). */
+    EC_CMD_SYNC_SLAVE_CLOCKS, /**< See ecrt_master_sync_slave_clocks(). */
+    EC_CMD_REF_CLOCK_TIME, /**< Read the 32 bit reference clock time into
+                             the command value, see
+                             ecrt_master_reference_clock_time(). */
+    EC_CMD_REF_CLOCK_TIME_64_QUEUE, /**< See
+                       ecrt_master_64bit_reference_clock_time_queue(). */
+    EC_CMD_REF_CLOCK_TIME_64, /**< Read the 64 bit reference clock time into
+                                the command value, see
+                                ecrt_master_64bit_reference_clock_time(). */
+    EC_CMD_SYNC_MONITOR_QUEUE, /**< See ecrt_master_sync_monitor_queue(). */
+    EC_CMD_SYNC_MONITOR_PROCESS, /**< Read the synchrony estimation into the
+                                   command value, see
+                                   ecrt_master_sync_monitor_process(). */
+} ec_cmd_type_t;
+
+/*****************************************************************************/
+
+/** Maximum number of commands per ecrt_master_cycle() call.
+ */
+#define EC_CYCLE_MAX_CMDS 16
+
+/** Cyclic command.
+ *
+ * This is used with ecrt_master_cycle().
+ */
+typedef struct {
+    ec_cmd_type_t type; /**< Command type. */
+    ec_domain_t *domain; /**< Domain for #EC_CMD_DOMAIN_PROCESS and
+                           #EC_CMD_DOMAIN_QUEUE, otherwise NULL. */
+    uint64_t value; /**< Input or output value, depending on \a type. */
+    int result; /**< Result of the command. Negative error code on failure,
+                  the number of bytes sent for #EC_CMD_SEND, otherwise 0. */
+} ec_cmd_t;
+
+/*****************************************************************************/
+
+/** Distributed clocks drift compensation mode.
+ *
+ * This is used in ec_dc_pll_config_t.
+ */
+typedef enum {
+    EC_DC_PLL_OFF, /**< Controller disabled (default). */
+    EC_DC_PLL_REF_CLOCK, /**< Adjust the reference clock: The reference
+                           clock is synchronized to a filtered copy of the
+                           application time. */
+    EC_DC_PLL_APP_CYCLE, /**< Adjust the application cycle: The reference
+                           clock is the master clock and the application
+                           follows it by applying the correction from
+                           ecrt_master_dc_pll_state(). */
+} ec_dc_pll_mode_t;
+
+/** Distributed clocks drift compensation controller configuration.
+ *
+ * The gains are fixed-point values with 16 fractional bits, i. e. 65536
+ * corresponds to a gain of 1. If both gains are zero, the defaults
+ * #EC_DC_PLL_DEFAULT_KP and #EC_DC_PLL_DEFAULT_KI are used.
+ *
+ * This is used with ecrt_master_dc_pll_config().
+ */
+typedef struct {
+    ec_dc_pll_mode_t mode; /**< Controller mode. */
+    uint32_t period_ns; /**< Nominal application cycle time in ns. */
+    uint32_t kp; /**< Proportional gain (1 / 65536), less than 65536. */
+    uint32_t ki; /**< Integral gain (1 / 65536), less than 65536. */
+    uint32_t filter_shift; /**< Low-pass filter of the phase error. Each new
+                             sample is weighted with 2^-filter_shift, so 0
+                             disables the filter. Maximum is 16. */
+    uint32_t lock_threshold_ns; /**< The controller is reported as locked, if
+                                  the filtered error stays below this value.
+                                  Zero selects 1000 ns. */
+} ec_dc_pll_config_t;
+
+/** Default proportional gain of the drift compensation controller (0.05).
+ */
+#define EC_DC_PLL_DEFAULT_KP 3277
+
+/** Default integral gain of the drift compensation controller (0.0005).
+ */
+#define EC_DC_PLL_DEFAULT_KI 33
+
+/** Distributed clocks drift compensation controller state.
+ *
+ * This is used with ecrt_master_dc_pll_state().
+ */
+typedef struct {
+    ec_dc_pll_mode_t mode; /**< Current controller mode. */
+    int32_t sync_error_ns; /**< Residual error between the reference clock
+                             and the application time base, measured with
+                             the last 64 bit reference clock time reading.
+                             Positive, if the reference clock is ahead. */
+    int32_t filtered_error_ns; /**< Low-pass filtered controller input. */
+    int32_t correction_ns; /**< Correction for the next cycle. */
+    int32_t drift_ppb; /**< Estimated frequency deviation in ppb: Of the
+                         reference clock from the application clock
+                         (#EC_DC_PLL_APP_CYCLE) or of the application cycle
+                         from the nominal period (#EC_DC_PLL_REF_CLOCK). */
+    uint32_t sync_monitor_ns; /**< Last result of the synchrony monitoring
+                                (see ecrt_master_sync_monitor_process()), or
+                                0xffffffff. */
+    uint32_t locked; /**< Non-zero, if the filtered error stays below the
+                       lock threshold. */
+    uint32_t missed; /**< Number of reference clock readings, that were not
+                       received. */
+    uint64_t updates; /**< Number of controller updates. */
+} ec_dc_pll_state_t;
+
 /******************************************************************************
  * Global functions
  *****************************************************************************/
@@ -1087,6 +1239,85 @@ size_t ecrt_master_send_ext(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+#ifndef __KERNEL__
+
+/** Sets up the cyclic command ring.
+ *
+ * The command ring is a memory area shared with the master, that takes a
+ * sequence of cyclic commands (see ec_cmd_type_t). Commands are added with
+ * ecrt_master_cmd_ring_add() and are executed in order by a single call to
+ * ecrt_master_cmd_ring_exec(). This replaces the separate system calls of
+ * ecrt_master_receive(), ecrt_domain_process(), ecrt_domain_queue() and
+ * ecrt_master_send() by one, and the master lock is acquired only once.
+ *
+ * Using the command ring is optional. This method should be called after
+ * ecrt_master_activate() and not in realtime context. It is not available
+ * with RTDM.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_master_setup_cmd_ring(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Adds a command to the cyclic command ring.
+ *
+ * The command is not executed until ecrt_master_cmd_ring_exec() is called.
+ *
+ * \retval 0 Success.
+ * \retval -ENXIO The command ring was not set up.
+ * \retval -ENOBUFS The command ring is full.
+ */
+int ecrt_master_cmd_ring_add(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_cmd_type_t type, /**< Command type. */
+        ec_domain_t *domain /**< Domain for #EC_CMD_DOMAIN_PROCESS and
+                              #EC_CMD_DOMAIN_QUEUE, otherwise NULL. */
+        );
+
+/** Executes all commands added to the cyclic command ring.
+ *
+ * The commands are executed in the order they were added, with one system
+ * call. This method should be called in realtime context.
+ *
+ * A typical cycle adds #EC_CMD_RECEIVE, #EC_CMD_DOMAIN_PROCESS,
+ * #EC_CMD_DOMAIN_QUEUE and #EC_CMD_SEND, executes the ring and then
+ * evaluates the inputs and calculates the outputs for the next cycle.
+ *
+ * \return 0 if all commands succeeded, otherwise the negative error code of
+ *         the first command that failed.
+ */
+int ecrt_master_cmd_ring_exec(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Executes a sequence of cyclic commands.
+ *
+ * The commands are executed in the given order with one system call and
+ * with a single acquisition of the master lock. The \a value and \a result
+ * fields of the commands are updated on return.
+ *
+ * A typical cycle is #EC_CMD_RECEIVE, #EC_CMD_DOMAIN_PROCESS,
+ * #EC_CMD_APP_TIME, #EC_CMD_SYNC_REF_CLOCK, #EC_CMD_SYNC_SLAVE_CLOCKS,
+ * #EC_CMD_DOMAIN_QUEUE and #EC_CMD_SEND.
+ *
+ * At most #EC_CYCLE_MAX_CMDS commands can be executed per call. Longer
+ * sequences are rejected, because they could not be executed atomically.
+ *
+ * This method should be called in realtime context.
+ *
+ * \return 0 if all commands succeeded, otherwise the negative error code of
+ *         the first command that failed.
+ * \retval -EINVAL More than #EC_CYCLE_MAX_CMDS commands.
+ */
+int ecrt_master_cycle(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_cmd_t *cmds, /**< Commands to execute. */
+        unsigned int count /**< Number of commands. */
+        );
+
+#endif /* #ifndef __KERNEL__ */
+
 #if !defined(__KERNEL__) && defined(EC_RTDM) && (EC_EOE)
 
 /** check if there are any open eoe handlers
@@ -1298,6 +1529,54 @@ uint32_t ecrt_master_sync_monitor_process(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+/** Configures the distributed clocks drift compensation controller.
+ *
+ * Instead of running its own control loop, the application can let the
+ * master filter the clock deviations. The controller is a PLL with a
+ * low-pass filtered phase error and a PI filter. While it is enabled,
+ * ecrt_master_sync_slave_clocks() additionally queues the 64 bit reference
+ * clock time datagram and the synchrony monitoring datagram, which are
+ * evaluated by the next ecrt_master_receive(). The application still has
+ * to call ecrt_master_application_time() every cycle.
+ *
+ * With #EC_DC_PLL_REF_CLOCK, the reference clock follows the application.
+ * The master runs a filtered copy of the application time, that is advanced
+ * by the nominal period in ecrt_master_application_time() and pulled
+ * towards the passed time, so the wakeup jitter of the application does not
+ * reach the reference clock. ecrt_master_sync_reference_clock() writes the
+ * filtered time. ecrt_master_sync_reference_clock_to() is not affected.
+ *
+ * With #EC_DC_PLL_APP_CYCLE, the application follows the reference clock.
+ * The application keeps an offset between its own clock and the DC time
+ * base. It passes its own time plus the offset to
+ * ecrt_master_application_time() and schedules its wakeups on the DC time
+ * base, i. e. at the next multiple of the period minus the offset. Each
+ * cycle it adds ec_dc_pll_state_t::correction_ns to the offset. The
+ * reference clock must not be synchronized by the application in this mode.
+ *
+ * The controller state is reset with every call. It should not be called
+ * in realtime context.
+ *
+ * \retval 0 Success.
+ * \retval -EINVAL Invalid configuration.
+ */
+int ecrt_master_dc_pll_config(
+        ec_master_t *master, /**< EtherCAT master. */
+        const ec_dc_pll_config_t *config /**< Controller configuration. */
+        );
+
+/** Reads the state of the distributed clocks drift compensation controller.
+ *
+ * This method can be called in realtime context, typically after
+ * ecrt_master_receive().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_master_dc_pll_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_dc_pll_state_t *state /**< Structure to store the state. */
+        );
+
 /** Selects whether to process slave requests by the application or the master
  *
  * if rt_slave_requests \a True, slave requests are to be handled by calls to 
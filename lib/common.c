@@ -83,6 +83,7 @@ ec_master_t *ecrt_open_master(unsigned int master_index)
 
     master->process_data = NULL;
     master->process_data_size = 0;
+    master->cmd_ring = NULL;
     master->first_domain = NULL;
     master->first_config = NULL;
 
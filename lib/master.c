@@ -94,6 +94,11 @@ void ec_master_clear(ec_master_t *master)
 {
     ec_master_clear_config(master);
 
+    if (master->cmd_ring) {
+        munmap(master->cmd_ring, sizeof(ec_ioctl_cmd_ring_t));
+        master->cmd_ring = NULL;
+    }
+
     if (master->fd != -1) {
 #if USE_RTDM
         rt_dev_close(master->fd);
@@ -734,6 +739,146 @@ void ecrt_master_receive(ec_master_t *master)
 
 /****************************************************************************/
 
+int ecrt_master_setup_cmd_ring(ec_master_t *master)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    EC_PRINT_ERR("Command ring is not supported with RTDM.\n");
+    return -EOPNOTSUPP;
+#else
+    void *ring;
+    int ret;
+
+    if (master->cmd_ring) {
+        return 0;
+    }
+
+    ret = ioctl(master->fd, EC_IOCTL_SETUP_CMD_RING, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to set up command ring: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    ring = mmap(0, sizeof(ec_ioctl_cmd_ring_t), PROT_READ | PROT_WRITE,
+            MAP_SHARED, master->fd, EC_IOCTL_CMD_RING_OFFSET);
+    if (ring == MAP_FAILED) {
+        EC_PRINT_ERR("Failed to map command ring: %s\n", strerror(errno));
+        return -errno;
+    }
+
+    master->cmd_ring = ring;
+
+    // Access the mapped region to cause the initial page fault
+    master->cmd_ring->head = master->cmd_ring->tail;
+    return 0;
+#endif
+}
+
+/****************************************************************************/
+
+int ecrt_master_cmd_ring_add(ec_master_t *master, ec_cmd_type_t type,
+        ec_domain_t *domain)
+{
+    ec_ioctl_cmd_ring_t *ring = master->cmd_ring;
+    ec_ioctl_cmd_t *cmd;
+
+    if (!ring) {
+        return -ENXIO;
+    }
+
+    if (ring->head - ring->tail >= EC_IOCTL_CMD_RING_SIZE) {
+        return -ENOBUFS;
+    }
+
+    cmd = &ring->cmd[ring->head & (EC_IOCTL_CMD_RING_SIZE - 1)];
+    cmd->type = type;
+    cmd->index = domain ? domain->index : 0;
+    cmd->value = 0;
+    cmd->result = 0;
+    ring->head++;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cmd_ring_exec(ec_master_t *master)
+{
+    ec_ioctl_cmd_ring_t *ring = master->cmd_ring;
+    uint32_t tail;
+    int ret;
+
+    if (!ring) {
+        return -ENXIO;
+    }
+
+    tail = ring->tail;
+
+    ret = ioctl(master->fd, EC_IOCTL_CMD_RING_EXEC, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to execute command ring: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    for (; tail != ring->tail; tail++) {
+        ret = ring->cmd[tail & (EC_IOCTL_CMD_RING_SIZE - 1)].result;
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cycle(ec_master_t *master, ec_cmd_t *cmds,
+        unsigned int count)
+{
+    ec_ioctl_cmd_t io_cmds[EC_IOCTL_BATCH_SIZE];
+    ec_ioctl_batch_t io;
+    unsigned int i;
+    int ret, result = 0;
+
+    if (count > EC_IOCTL_BATCH_SIZE) {
+        EC_PRINT_ERR("Failed to execute cycle: %u commands exceed the"
+                " maximum of %u.\n", count, EC_IOCTL_BATCH_SIZE);
+        return -EINVAL;
+    }
+
+    io.count = count;
+    io.cmds = io_cmds;
+
+    for (i = 0; i < count; i++) {
+        const ec_cmd_t *cmd = &cmds[i];
+        io_cmds[i].type = cmd->type;
+        io_cmds[i].index = cmd->domain ? cmd->domain->index : 0;
+        io_cmds[i].value = cmd->value;
+        io_cmds[i].result = 0;
+        io_cmds[i].reserved = 0;
+    }
+
+    ret = ioctl(master->fd, EC_IOCTL_BATCH, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to execute cycle: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    for (i = 0; i < count; i++) {
+        ec_cmd_t *cmd = &cmds[i];
+        cmd->value = io_cmds[i].value;
+        cmd->result = io_cmds[i].result;
+        if (cmd->result < 0 && !result) {
+            result = cmd->result;
+        }
+    }
+
+    return result;
+}
+
+/****************************************************************************/
+
 #if defined(EC_RTDM) && (EC_EOE)
 
 size_t ecrt_master_send_ext(ec_master_t *master)
@@ -1007,6 +1152,39 @@ uint32_t ecrt_master_sync_monitor_process(ec_master_t *master)
 
 /****************************************************************************/
 
+int ecrt_master_dc_pll_config(ec_master_t *master,
+        const ec_dc_pll_config_t *config)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_DC_PLL_CONFIG, config);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to configure DC controller: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_dc_pll_state(ec_master_t *master, ec_dc_pll_state_t *state)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_DC_PLL_STATE, state);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get DC controller state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 int ecrt_master_rt_slave_requests(ec_master_t *master,
         unsigned int rt_slave_requests)
 {
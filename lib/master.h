@@ -36,6 +36,7 @@ struct ec_master {
     int fd;
     uint8_t *process_data;
     size_t process_data_size;
+    struct ec_ioctl_cmd_ring *cmd_ring;
 
     ec_domain_t *first_domain;
     ec_slave_config_t *first_config;
@@ -35,6 +35,7 @@
 #include <linux/module.h>
 #include <linux/vmalloc.h>
 #include <linux/mm.h>
+#include <linux/poll.h>
 
 #include "cdev.h"
 #include "master.h"
@@ -54,6 +55,14 @@ static int eccdev_release(struct inode *, struct file *);
 static long eccdev_ioctl(struct file *, unsigned int, unsigned long);
 static int eccdev_mmap(struct file *, struct vm_area_struct *);
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 16, 0)
+# define POLL_RETURN_TYPE unsigned int
+#else
+# define POLL_RETURN_TYPE __poll_t
+#endif
+
+static POLL_RETURN_TYPE eccdev_poll(struct file *, poll_table *);
+
 /** This is the kernel version from which the .fault member of the
  * vm_operations_struct is usable.
  */
@@ -85,7 +94,8 @@ static struct file_operations eccdev_fops = {
     .open           = eccdev_open,
     .release        = eccdev_release,
     .unlocked_ioctl = eccdev_ioctl,
-    .mmap           = eccdev_mmap
+    .mmap           = eccdev_mmap,
+    .poll           = eccdev_poll
 };
 
 /** Callbacks for a virtual memory area retrieved with ecdevc_mmap().
@@ -167,6 +177,10 @@ int eccdev_open(struct inode *inode, struct file *filp)
     priv->ctx.requested = 0;
     priv->ctx.process_data = NULL;
     priv->ctx.process_data_size = 0;
+    priv->ctx.cmd_ring = NULL;
+    priv->ctx.cmd_ring_tail = 0;
+    priv->ctx.pcap_pos = 0;
+    priv->ctx.pcap_streaming = 0;
 
     filp->private_data = priv;
 
@@ -193,6 +207,10 @@ int eccdev_release(struct inode *inode, struct file *filp)
         vfree(priv->ctx.process_data);
     }
 
+    if (priv->ctx.cmd_ring) {
+        vfree(priv->ctx.cmd_ring);
+    }
+
 #if DEBUG
     EC_MASTER_DBG(master, 0, "File closed.\n");
 #endif
@@ -220,6 +238,65 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 
 /*****************************************************************************/
 
+/** Called when the cdev is polled.
+ *
+ * The file handle is readable, if there are pcap records behind its stream
+ * position (see EC_IOCTL_PCAP_READ).
+ */
+POLL_RETURN_TYPE eccdev_poll(struct file *filp, poll_table *wait)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    ec_pcap_t *pcap = &priv->cdev->master->pcap;
+    unsigned long pos;
+
+    if (!pcap->data) {
+        return 0;
+    }
+
+    poll_wait(filp, &pcap->wait, wait);
+    ec_pcap_watch(pcap);
+
+    pos = priv->ctx.pcap_streaming ?
+        priv->ctx.pcap_pos : READ_ONCE(pcap->tail);
+    if (ec_pcap_pending(pcap, pos)) {
+        return POLLIN | POLLRDNORM;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Looks up the page backing an offset of the memory mapping.
+ *
+ * Offsets from #EC_IOCTL_CMD_RING_OFFSET on address the command ring, lower
+ * offsets address the process data.
+ *
+ * \return Page, or NULL if the offset is not backed by memory.
+ */
+static struct page *eccdev_offset_to_page(
+        ec_cdev_priv_t *priv, /**< Private data structure of file handle. */
+        unsigned long offset /**< Offset into the mapping. */
+        )
+{
+    if (offset >= EC_IOCTL_CMD_RING_OFFSET) {
+        offset -= EC_IOCTL_CMD_RING_OFFSET;
+        if (!priv->ctx.cmd_ring
+                || offset >= PAGE_ALIGN(sizeof(ec_ioctl_cmd_ring_t))) {
+            return NULL;
+        }
+        return vmalloc_to_page((uint8_t *) priv->ctx.cmd_ring + offset);
+    }
+
+    if (offset >= priv->ctx.process_data_size) {
+        return NULL;
+    }
+
+    return vmalloc_to_page(priv->ctx.process_data + offset);
+}
+
+/*****************************************************************************/
+
 #ifndef VM_DONTDUMP
 /** VM_RESERVED disappeared in 3.7.
  */
@@ -274,11 +351,7 @@ static FAULT_RETURN_TYPE eccdev_vma_fault(
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) vma->vm_private_data;
     struct page *page;
 
-    if (offset >= priv->ctx.process_data_size) {
-        return VM_FAULT_SIGBUS;
-    }
-
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
+    page = eccdev_offset_to_page(priv, offset);
     if (!page) {
         return VM_FAULT_SIGBUS;
     }
@@ -317,11 +390,10 @@ struct page *eccdev_vma_nopage(
 
     offset = (address - vma->vm_start) + (vma->vm_pgoff << PAGE_SHIFT);
 
-    if (offset >= priv->ctx.process_data_size)
+    page = eccdev_offset_to_page(priv, offset);
+    if (!page)
         return NOPAGE_SIGBUS;
 
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
-
     EC_MASTER_DBG(master, 1, "Nopage fault vma, address = %#lx,"
             " offset = %#lx, page = %p\n", address, offset, page);
 
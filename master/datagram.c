@@ -96,8 +96,10 @@ void ec_datagram_init(ec_datagram_t *datagram /**< EtherCAT datagram. */)
     datagram->mem_size = 0;
     datagram->data_size = 0;
     datagram->index = 0x00;
+    datagram->lookup_entry = NULL;
     datagram->working_counter = 0x0000;
     datagram->state = EC_DATAGRAM_INIT;
+    datagram->priority = EC_DATAGRAM_PRIO_CYCLIC;
 #ifdef EC_HAVE_CYCLES
     datagram->cycles_sent = 0;
 #endif
@@ -110,6 +112,10 @@ void ec_datagram_init(ec_datagram_t *datagram /**< EtherCAT datagram. */)
     datagram->skip_count = 0;
     datagram->stats_output_jiffies = 0;
     memset(datagram->name, 0x00, EC_DATAGRAM_NAME_SIZE);
+    datagram->tx_frame = NULL;
+    datagram->tx_frame_size = 0;
+    datagram->tx_frame_pending = 0;
+    datagram->ext_owner = NULL;
 }
 
 /*****************************************************************************/
@@ -124,17 +130,42 @@ void ec_datagram_clear(ec_datagram_t *datagram /**< EtherCAT datagram. */)
         kfree(datagram->data);
         datagram->data = NULL;
     }
+
+    datagram->tx_frame = NULL; // owned by the user of the datagram
 }
 
 /*****************************************************************************/
 
 /** Unqueue datagram.
+ *
+ * This also releases the datagram's entry in the master's index lookup
+ * table, so that a late response can not be matched to it any more.
  */
 void ec_datagram_unqueue(ec_datagram_t *datagram /**< EtherCAT datagram. */)
 {
     if (!list_empty(&datagram->queue)) {
         list_del_init(&datagram->queue);
     }
+
+    ec_datagram_release_index(datagram);
+}
+
+/*****************************************************************************/
+
+/** Releases the datagram's entry in the master's index lookup table.
+ *
+ * The entry is only cleared, if it still refers to this datagram.
+ */
+void ec_datagram_release_index(
+        ec_datagram_t *datagram /**< EtherCAT datagram. */
+        )
+{
+    if (datagram->lookup_entry) {
+        if (*datagram->lookup_entry == datagram) {
+            *datagram->lookup_entry = NULL;
+        }
+        datagram->lookup_entry = NULL;
+    }
 }
 
 /*****************************************************************************/
@@ -183,6 +214,44 @@ void ec_datagram_zero(ec_datagram_t *datagram /**< EtherCAT datagram. */)
 
 /*****************************************************************************/
 
+/** Assigns a dedicated transmit frame to a datagram.
+ *
+ * The external data memory of the datagram has to be located inside the
+ * zeroed frame, right behind the frame and datagram headers. The headers are
+ * written once here, so that the master only has to update the index and the
+ * working counter for each transmission.
+ */
+void ec_datagram_attach_frame(
+        ec_datagram_t *datagram, /**< EtherCAT datagram. */
+        struct sk_buff *skb /**< Frame from ec_device_alloc_frame(). */
+        )
+{
+    uint8_t *cur_data = datagram->data - EC_DATAGRAM_HEADER_SIZE;
+    size_t size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+        + EC_DATAGRAM_FOOTER_SIZE;
+
+    // EtherCAT frame header
+    EC_WRITE_U16(cur_data - EC_FRAME_HEADER_SIZE, (size & 0x7FF) | 0x1000);
+
+    // EtherCAT datagram header
+    EC_WRITE_U8 (cur_data, datagram->type);
+    EC_WRITE_U8 (cur_data + 1, 0x00);
+    memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+    EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+    EC_WRITE_U16(cur_data + 8, 0x0000);
+
+    // EtherCAT datagram footer
+    EC_WRITE_U16(datagram->data + datagram->data_size, 0x0000);
+
+    // the padding is already zeroed
+    datagram->tx_frame = skb;
+    datagram->tx_frame_size = max_t(size_t, EC_FRAME_HEADER_SIZE + size,
+            ETH_ZLEN - ETH_HLEN);
+    datagram->tx_frame_pending = 0;
+}
+
+/*****************************************************************************/
+
 /** Copies a previously constructed datagram for repeated send.
  * 
  * \return Return value of ec_datagram_prealloc().
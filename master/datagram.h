@@ -38,6 +38,7 @@
 #define __EC_DATAGRAM_H__
 
 #include <linux/list.h>
+#include <linux/skbuff.h>
 #include <linux/time.h>
 #include <linux/timex.h>
 
@@ -83,9 +84,25 @@ typedef enum {
 
 /*****************************************************************************/
 
+/** EtherCAT datagram priority.
+ *
+ * Cyclic datagrams are sent in the order they were queued. Datagrams of
+ * lower priority fill the space left in the frames, highest priority first.
+ */
+typedef enum {
+    EC_DATAGRAM_PRIO_LOW,    /**< Bulk transfers (FoE, EoE). */
+    EC_DATAGRAM_PRIO_NORMAL, /**< Other mailbox transfers. */
+    EC_DATAGRAM_PRIO_HIGH,   /**< Slave state machines, SDO and register
+                               requests. */
+    EC_DATAGRAM_PRIO_CYCLIC, /**< Application and master datagrams. */
+    EC_DATAGRAM_PRIO_COUNT   /**< Number of priorities. */
+} ec_datagram_priority_t;
+
+/*****************************************************************************/
+
 /** EtherCAT datagram.
  */
-typedef struct {
+typedef struct ec_datagram {
     struct list_head queue; /**< Master datagram queue item. */
     struct list_head sent; /**< Master list item for sent datagrams. */
     ec_device_index_t device_index; /**< Device via which the datagram shall
@@ -97,8 +114,11 @@ typedef struct {
     size_t mem_size; /**< Datagram \a data memory size. */
     size_t data_size; /**< Size of the data in \a data. */
     uint8_t index; /**< Index (set by master). */
+    struct ec_datagram **lookup_entry; /**< Entry in the master's index
+                                         lookup table, while sent. */
     uint16_t working_counter; /**< Working counter. */
     ec_datagram_state_t state; /**< State. */
+    ec_datagram_priority_t priority; /**< Sending priority. */
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_sent; /**< Time, when the datagram was sent. */
 #endif
@@ -112,6 +132,13 @@ typedef struct {
     unsigned int skip_count; /**< Number of requeues when not yet received. */
     unsigned long stats_output_jiffies; /**< Last statistics output. */
     char name[EC_DATAGRAM_NAME_SIZE]; /**< Description of the datagram. */
+    struct sk_buff *tx_frame; /**< Dedicated transmit frame containing
+                                \a data, or NULL. */
+    size_t tx_frame_size; /**< Size of \a tx_frame in bytes. */
+    unsigned int tx_frame_pending; /**< \a tx_frame was sent, but not
+                                     received yet. */
+    const void *ext_owner; /**< User of an external datagram, that has not
+                             evaluated it yet, or NULL. */
 } ec_datagram_t;
 
 
@@ -130,8 +157,10 @@ typedef struct {
 void ec_datagram_init(ec_datagram_t *);
 void ec_datagram_clear(ec_datagram_t *);
 void ec_datagram_unqueue(ec_datagram_t *);
+void ec_datagram_release_index(ec_datagram_t *);
 int ec_datagram_prealloc(ec_datagram_t *, size_t);
 void ec_datagram_zero(ec_datagram_t *);
+void ec_datagram_attach_frame(ec_datagram_t *, struct sk_buff *);
 int ec_datagram_repeat(ec_datagram_t *, const ec_datagram_t *);
 
 int ec_datagram_aprd(ec_datagram_t *, uint16_t, uint16_t, size_t);
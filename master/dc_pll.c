@@ -0,0 +1,338 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Distributed clocks drift compensation controller.
+*/
+
+/****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/math64.h>
+#include <linux/preempt.h>
+
+#include "globals.h"
+#include "dc_pll.h"
+
+/****************************************************************************/
+
+/** Starts a modification of the controller.
+ */
+static inline void ec_dc_pll_write_begin(
+        ec_dc_pll_t *pll /**< Controller. */
+        )
+{
+    preempt_disable(); // a preempted writer would block the readers
+    write_seqcount_begin(&pll->seq);
+}
+
+/****************************************************************************/
+
+/** Finishes a modification of the controller.
+ */
+static inline void ec_dc_pll_write_end(
+        ec_dc_pll_t *pll /**< Controller. */
+        )
+{
+    write_seqcount_end(&pll->seq);
+    preempt_enable();
+}
+
+/****************************************************************************/
+
+/** Resets all members except the sequence counter and disables the
+ * controller.
+ */
+static void ec_dc_pll_reset(
+        ec_dc_pll_t *pll /**< Controller. */
+        )
+{
+    memset(&pll->config, 0,
+            sizeof(*pll) - offsetof(ec_dc_pll_t, config));
+    pll->config.mode = EC_DC_PLL_OFF;
+    pll->sync_monitor = 0xffffffff;
+}
+
+/****************************************************************************/
+
+/** Initializes the controller and disables it.
+ */
+void ec_dc_pll_init(
+        ec_dc_pll_t *pll /**< Controller. */
+        )
+{
+    seqcount_init(&pll->seq);
+    ec_dc_pll_reset(pll);
+}
+
+/****************************************************************************/
+
+/** Configures the controller and resets its state.
+ *
+ * \retval 0 Success.
+ * \retval -EINVAL Invalid configuration.
+ */
+int ec_dc_pll_configure(
+        ec_dc_pll_t *pll, /**< Controller. */
+        const ec_dc_pll_config_t *config /**< New configuration. */
+        )
+{
+    ec_dc_pll_config_t c = *config;
+
+    switch (c.mode) {
+        case EC_DC_PLL_OFF:
+            break;
+        case EC_DC_PLL_REF_CLOCK:
+        case EC_DC_PLL_APP_CYCLE:
+            if (!c.period_ns || c.period_ns > NSEC_PER_SEC) {
+                return -EINVAL;
+            }
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    if (c.kp >= 0x10000 || c.ki >= 0x10000 || c.filter_shift > 16) {
+        return -EINVAL;
+    }
+
+    if (!c.kp && !c.ki) {
+        c.kp = EC_DC_PLL_DEFAULT_KP;
+        c.ki = EC_DC_PLL_DEFAULT_KI;
+    }
+
+    if (!c.lock_threshold_ns) {
+        c.lock_threshold_ns = 1000;
+    }
+
+    ec_dc_pll_write_begin(pll);
+    ec_dc_pll_reset(pll);
+    pll->config = c;
+    ec_dc_pll_write_end(pll);
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Updates the controller with a new phase error.
+ *
+ * Calculates the correction for the next cycle.
+ */
+static void ec_dc_pll_update(
+        ec_dc_pll_t *pll, /**< Controller. */
+        s64 error /**< Phase error in ns. */
+        )
+{
+    s64 limit = pll->config.period_ns, total, correction;
+
+    // Limit the influence of outliers, e. g. missed cycles.
+    if (error > limit) {
+        error = limit;
+    } else if (error < -limit) {
+        error = -limit;
+    }
+
+    pll->filtered += ((error << 16) - pll->filtered)
+        >> pll->config.filter_shift;
+
+    // The frequency correction is limited to 1000 ppm.
+    pll->freq += (pll->config.ki * pll->filtered) >> 16;
+    limit = ((s64) pll->config.period_ns << 16) / 1000;
+    if (pll->freq > limit) {
+        pll->freq = limit;
+    } else if (pll->freq < -limit) {
+        pll->freq = -limit;
+    }
+
+    total = ((pll->config.kp * pll->filtered) >> 16) + pll->freq
+        + pll->frac;
+    correction = total >> 16;
+
+    // The correction per cycle is limited to 1/16 of the period.
+    limit = pll->config.period_ns >> 4;
+    if (correction > limit) {
+        correction = limit;
+        pll->frac = 0;
+    } else if (correction < -limit) {
+        correction = -limit;
+        pll->frac = 0;
+    } else {
+        pll->frac = total - (correction << 16);
+    }
+    pll->correction = correction;
+
+    if ((u32) abs((s32) (pll->filtered >> 16))
+            < pll->config.lock_threshold_ns) {
+        if (pll->lock_count < EC_DC_PLL_LOCK_COUNT) {
+            pll->lock_count++;
+        }
+    } else {
+        pll->lock_count = 0;
+    }
+
+    pll->updates++;
+}
+
+/****************************************************************************/
+
+/** Advances the filtered application time (#EC_DC_PLL_REF_CLOCK).
+ *
+ * This has to be called once per application cycle.
+ *
+ * \return Filtered application time.
+ */
+u64 ec_dc_pll_app_time(
+        ec_dc_pll_t *pll, /**< Controller. */
+        u64 app_time /**< Application time. */
+        )
+{
+    ec_dc_pll_write_begin(pll);
+    if (unlikely(!pll->started)) {
+        pll->time = app_time;
+        pll->started = 1;
+    } else {
+        pll->time += pll->config.period_ns + pll->correction;
+        ec_dc_pll_update(pll, (s64) (app_time - pll->time));
+    }
+    ec_dc_pll_write_end(pll);
+    return pll->time;
+}
+
+/****************************************************************************/
+
+/** Notes, that the reference clock time datagram was queued.
+ */
+void ec_dc_pll_queued(
+        ec_dc_pll_t *pll, /**< Controller. */
+        u64 app_time /**< Current application time. */
+        )
+{
+    ec_dc_pll_write_begin(pll);
+    pll->queued_time = pll->config.mode == EC_DC_PLL_REF_CLOCK ?
+        pll->time : app_time;
+    pll->pending = 1;
+    ec_dc_pll_write_end(pll);
+}
+
+/****************************************************************************/
+
+/** Evaluates a reference clock time reading.
+ *
+ * With #EC_DC_PLL_APP_CYCLE, this updates the controller.
+ */
+void ec_dc_pll_ref_time(
+        ec_dc_pll_t *pll, /**< Controller. */
+        u64 ref_time /**< Reference clock time, transmission delay
+                       removed. */
+        )
+{
+    s64 error = ref_time - pll->queued_time;
+
+    ec_dc_pll_write_begin(pll);
+    pll->pending = 0;
+
+    if (error > S32_MAX) {
+        pll->sync_error = S32_MAX;
+    } else if (error < S32_MIN) {
+        pll->sync_error = S32_MIN;
+    } else {
+        pll->sync_error = error;
+    }
+
+    if (pll->config.mode == EC_DC_PLL_APP_CYCLE) {
+        ec_dc_pll_update(pll, error);
+    }
+    ec_dc_pll_write_end(pll);
+}
+
+/****************************************************************************/
+
+/** Notes, that the reference clock time reading was lost.
+ */
+void ec_dc_pll_missed(
+        ec_dc_pll_t *pll /**< Controller. */
+        )
+{
+    ec_dc_pll_write_begin(pll);
+    pll->pending = 0;
+    pll->missed++;
+    ec_dc_pll_write_end(pll);
+}
+
+/****************************************************************************/
+
+/** Stores the result of the synchrony monitoring.
+ */
+void ec_dc_pll_sync_monitor(
+        ec_dc_pll_t *pll, /**< Controller. */
+        u32 sync_monitor /**< Deviation in ns, or 0xffffffff, if unknown. */
+        )
+{
+    ec_dc_pll_write_begin(pll);
+    pll->sync_monitor = sync_monitor;
+    ec_dc_pll_write_end(pll);
+}
+
+/****************************************************************************/
+
+/** Copies the controller state.
+ */
+static void ec_dc_pll_read_state(
+        const ec_dc_pll_t *pll, /**< Controller. */
+        ec_dc_pll_state_t *state /**< Target. */
+        )
+{
+    state->mode = pll->config.mode;
+    state->sync_error_ns = pll->sync_error;
+    state->filtered_error_ns = pll->filtered >> 16;
+    state->correction_ns = pll->correction;
+    // ppb = freq / 2^16 * 10^9 / period, with 10^9 / 2^16 = 1953125 / 2^7
+    state->drift_ppb = pll->config.period_ns ?
+        div_s64(pll->freq * 1953125, pll->config.period_ns) >> 7 : 0;
+    state->sync_monitor_ns = pll->sync_monitor;
+    state->locked = pll->lock_count >= EC_DC_PLL_LOCK_COUNT;
+    state->missed = pll->missed;
+    state->updates = pll->updates;
+}
+
+/****************************************************************************/
+
+/** Reads the controller state.
+ *
+ * The state is read again, if the controller was updated meanwhile, so
+ * that it is always consistent.
+ */
+void ec_dc_pll_state(
+        const ec_dc_pll_t *pll, /**< Controller. */
+        ec_dc_pll_state_t *state /**< Target. */
+        )
+{
+    unsigned int seq;
+
+    do {
+        seq = read_seqcount_begin(&pll->seq);
+        ec_dc_pll_read_state(pll, state);
+    } while (read_seqcount_retry(&pll->seq, seq));
+}
+
+/****************************************************************************/
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Distributed clocks drift compensation controller.
+*/
+
+/****************************************************************************/
+
+#ifndef __EC_DC_PLL_H__
+#define __EC_DC_PLL_H__
+
+#include <linux/types.h>
+#include <linux/seqlock.h>
+
+#include "../include/ecrt.h"
+
+/****************************************************************************/
+
+/** Number of consecutive updates below the lock threshold, before the
+ * controller is reported as locked.
+ */
+#define EC_DC_PLL_LOCK_COUNT 16
+
+/****************************************************************************/
+
+/** Distributed clocks drift compensation controller.
+ *
+ * Fixed-point values have 16 fractional bits.
+ *
+ * The controller is updated by the application only. The state may be read
+ * from any context, so all writes are enclosed in \a seq.
+ */
+typedef struct {
+    seqcount_t seq; /**< Sequence counter for readers of the state. */
+    ec_dc_pll_config_t config; /**< Configuration. */
+    u8 started; /**< The filtered time was initialized. */
+    u8 pending; /**< The reference clock time datagram was queued by the
+                  controller and is not evaluated yet. */
+    u64 time; /**< Filtered application time (#EC_DC_PLL_REF_CLOCK). */
+    u64 queued_time; /**< Application time base at the time the reference
+                       clock time datagram was queued. */
+    s64 filtered; /**< Filtered phase error (fixed-point ns). */
+    s64 freq; /**< Integral part, the frequency correction (fixed-point ns
+                per cycle). */
+    s64 frac; /**< Fractional part of the last correction. */
+    s32 correction; /**< Correction for the next cycle in ns. */
+    s32 sync_error; /**< Last measured reference clock error in ns. */
+    u32 sync_monitor; /**< Last synchrony monitoring result in ns. */
+    unsigned int lock_count; /**< Consecutive updates below the lock
+                               threshold. */
+    u32 missed; /**< Reference clock readings not received. */
+    u64 updates; /**< Number of controller updates. */
+} ec_dc_pll_t;
+
+/****************************************************************************/
+
+void ec_dc_pll_init(ec_dc_pll_t *);
+int ec_dc_pll_configure(ec_dc_pll_t *, const ec_dc_pll_config_t *);
+u64 ec_dc_pll_app_time(ec_dc_pll_t *, u64);
+void ec_dc_pll_queued(ec_dc_pll_t *, u64);
+void ec_dc_pll_ref_time(ec_dc_pll_t *, u64);
+void ec_dc_pll_missed(ec_dc_pll_t *);
+void ec_dc_pll_sync_monitor(ec_dc_pll_t *, u32);
+void ec_dc_pll_state(const ec_dc_pll_t *, ec_dc_pll_state_t *);
+
+/****************************************************************************/
+
+#endif
@@ -37,6 +37,7 @@
 #include <linux/version.h>
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
+#include <linux/vmalloc.h>
 
 #include "globals.h"
 #include "master.h"
@@ -49,6 +50,7 @@ int ec_dbgdev_open(struct net_device *);
 int ec_dbgdev_stop(struct net_device *);
 int ec_dbgdev_tx(struct sk_buff *, struct net_device *);
 struct net_device_stats *ec_dbgdev_stats(struct net_device *);
+static void ec_debug_work(struct work_struct *);
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 31)
 /** Device operations for debug interfaces.
@@ -80,9 +82,20 @@ int ec_debug_init(
     dbg->device = device;
     dbg->registered = 0;
     dbg->opened = 0;
+    dbg->head = 0;
+    dbg->tail = 0;
+    dbg->overruns = 0;
+    INIT_DELAYED_WORK(&dbg->work, ec_debug_work);
 
     memset(&dbg->stats, 0, sizeof(struct net_device_stats));
 
+    if (!(dbg->slots =
+                vmalloc(EC_DEBUG_IF_SLOTS * sizeof(ec_debug_slot_t)))) {
+        EC_MASTER_ERR(device->master, "Unable to allocate frame ring"
+                " for debug object!\n");
+        return -ENOMEM;
+    }
+
     if (!(dbg->dev =
           alloc_netdev(sizeof(ec_debug_t *), name,
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
@@ -91,6 +104,7 @@ int ec_debug_init(
 			ether_setup))) {
         EC_MASTER_ERR(device->master, "Unable to allocate net_device"
                 " for debug object!\n");
+        vfree(dbg->slots);
         return -ENODEV;
     }
 
@@ -122,6 +136,7 @@ void ec_debug_clear(
 {
     ec_debug_unregister(dbg);
     free_netdev(dbg->dev);
+    vfree(dbg->slots);
 }
 
 /*****************************************************************************/
@@ -161,12 +176,16 @@ void ec_debug_unregister(
         dbg->opened = 0;
         dbg->registered = 0;
         unregister_netdev(dbg->dev);
+        cancel_delayed_work_sync(&dbg->work);
     }
 }
 
 /*****************************************************************************/
 
 /** Sends frame data to the interface.
+ *
+ * Called in the realtime context. The frame is only copied into the ring;
+ * if the ring is full, it is dropped.
  */
 void ec_debug_send(
         ec_debug_t *dbg, /**< debug object */
@@ -174,23 +193,54 @@ void ec_debug_send(
         size_t size /**< size of the frame data */
         )
 {
-    struct sk_buff *skb;
+    ec_debug_slot_t *slot;
+    unsigned int head, next;
 
     if (!dbg->opened)
         return;
 
+    head = dbg->head;
+    next = (head + 1) % EC_DEBUG_IF_SLOTS;
+    if (next == READ_ONCE(dbg->tail)) {
+        dbg->overruns++;
+        return;
+    }
+
+    // the worker must be done with the slot before it is overwritten
+    smp_mb();
+
+    slot = &dbg->slots[head];
+    slot->size = min_t(size_t, size, ETH_FRAME_LEN);
+    memcpy(slot->data, data, slot->size);
+
+    // publish the frame
+    smp_wmb();
+    WRITE_ONCE(dbg->head, next);
+}
+
+/*****************************************************************************/
+
+/** Passes a buffered frame to the network stack.
+ */
+static void ec_debug_deliver(
+        ec_debug_t *dbg, /**< debug object */
+        const ec_debug_slot_t *slot /**< buffered frame */
+        )
+{
+    struct sk_buff *skb;
+
     // allocate socket buffer
-    if (!(skb = dev_alloc_skb(size))) {
+    if (!(skb = dev_alloc_skb(slot->size))) {
         dbg->stats.rx_dropped++;
         return;
     }
 
     // copy frame contents into socket buffer
-    memcpy(skb_put(skb, size), data, size);
+    memcpy(skb_put(skb, slot->size), slot->data, slot->size);
 
     // update device statistics
     dbg->stats.rx_packets++;
-    dbg->stats.rx_bytes += size;
+    dbg->stats.rx_bytes += slot->size;
 
     // pass socket buffer to network stack
     skb->dev = dbg->dev;
@@ -199,6 +249,34 @@ void ec_debug_send(
     netif_rx_ni(skb);
 }
 
+/*****************************************************************************/
+
+/** Worker delivering the buffered frames.
+ *
+ * Runs once per jiffy while the interface is opened.
+ */
+static void ec_debug_work(
+        struct work_struct *work /**< work structure */
+        )
+{
+    ec_debug_t *dbg = container_of(work, ec_debug_t, work.work);
+    unsigned int tail = dbg->tail;
+
+    while (tail != READ_ONCE(dbg->head)) {
+        smp_rmb();
+        ec_debug_deliver(dbg, &dbg->slots[tail]);
+        tail = (tail + 1) % EC_DEBUG_IF_SLOTS;
+
+        // release the slot
+        smp_mb();
+        WRITE_ONCE(dbg->tail, tail);
+    }
+
+    if (dbg->opened) {
+        schedule_delayed_work(&dbg->work, 1);
+    }
+}
+
 /******************************************************************************
  *  NET_DEVICE functions
  *****************************************************************************/
@@ -212,7 +290,11 @@ int ec_dbgdev_open(
         )
 {
     ec_debug_t *dbg = *((ec_debug_t **) netdev_priv(dev));
+
+    // discard frames left over from the last time the interface was open
+    WRITE_ONCE(dbg->tail, READ_ONCE(dbg->head));
     dbg->opened = 1;
+    schedule_delayed_work(&dbg->work, 1);
     EC_MASTER_INFO(dbg->device->master, "Debug interface %s opened.\n",
             dev->name);
     return 0;
@@ -230,6 +312,7 @@ int ec_dbgdev_stop(
 {
     ec_debug_t *dbg = *((ec_debug_t **) netdev_priv(dev));
     dbg->opened = 0;
+    cancel_delayed_work_sync(&dbg->work);
     EC_MASTER_INFO(dbg->device->master, "Debug interface %s stopped.\n",
             dev->name);
     return 0;
@@ -264,6 +347,7 @@ struct net_device_stats *ec_dbgdev_stats(
         )
 {
     ec_debug_t *dbg = *((ec_debug_t **) netdev_priv(dev));
+    dbg->stats.rx_over_errors = dbg->overruns;
     return &dbg->stats;
 }
 
@@ -37,11 +37,39 @@
 #ifndef __EC_DEBUG_H__
 #define __EC_DEBUG_H__
 
+#include <linux/workqueue.h>
+#include <linux/if_ether.h>
+
 #include "../devices/ecdev.h"
 
 /*****************************************************************************/
 
+/** Number of frames buffered between the realtime context and the worker
+ * delivering them to the network stack.
+ *
+ * The worker runs once per jiffy, so the ring has to hold the frames of
+ * some jiffies.
+ */
+#define EC_DEBUG_IF_SLOTS 256
+
+/*****************************************************************************/
+
+/** Frame buffered for the debugging network interface.
+ */
+typedef struct
+{
+    size_t size; /**< Frame size. */
+    uint8_t data[ETH_FRAME_LEN]; /**< Frame data. */
+}
+ec_debug_slot_t;
+
+/*****************************************************************************/
+
 /** Debugging network interface.
+ *
+ * Frames are copied into a preallocated ring in the realtime context and
+ * passed to the network stack by a worker, so that the send and receive
+ * path neither allocates memory nor raises a softirq.
  */
 typedef struct
 {
@@ -50,6 +78,12 @@ typedef struct
     struct net_device_stats stats; /**< device statistics */
     uint8_t registered; /**< net_device is opened */
     uint8_t opened; /**< net_device is opened */
+    ec_debug_slot_t *slots; /**< Frame ring. */
+    unsigned int head; /**< Next slot to fill (realtime context). */
+    unsigned int tail; /**< Next slot to deliver (worker). */
+    unsigned long overruns; /**< Frames dropped, because the ring was
+                              full. */
+    struct delayed_work work; /**< Worker delivering the frames. */
 }
 ec_debug_t;
 
@@ -306,44 +306,25 @@ int ec_device_close(
 
 /*****************************************************************************/
 
-/** Records a packet in the master's pcap buffer, if there is room.
+/** Records a packet in the master's pcap ring, if capturing is enabled.
  */
 
 static void pcap_record(
             ec_device_t *device, /**< EtherCAT device */
+            unsigned int direction, /**< EC_PCAP_TX or EC_PCAP_RX */
             const void *data, /**< Packet data */
             size_t size /**< Packet size */
             )
 {
-    // check there's enough room to copy frame to pcap mem
-    if (unlikely(device->master->pcap_data)) {
-        // get current data pointer
-        void *curr_data = device->master->pcap_curr_data;
-        long available = pcap_size - (curr_data - device->master->pcap_data);
-        long reqd = size + sizeof(pcaprec_hdr_t);
-        if (unlikely(reqd <= available)) {
-            pcaprec_hdr_t *pcaphdr;
-            struct timespec64 ts;
-          
-            // update curr data pointer
-            device->master->pcap_curr_data = curr_data + reqd;
-            
-            // fill in pcap frame header info
-            pcaphdr = curr_data;
+    if (unlikely(device->master->pcap.data)) {
+        struct timespec64 ts;
+
 #ifdef EC_RTDM
-            jiffies_to_timespec64(device->jiffies_poll, &ts);
+        jiffies_to_timespec64(device->jiffies_poll, &ts);
 #else
-            ts = device->timespec64_poll;
+        ts = device->timespec64_poll;
 #endif
-            pcaphdr->ts_sec   = ts.tv_sec;
-            pcaphdr->ts_nsec  = ts.tv_nsec;
-            pcaphdr->incl_len = size;
-            pcaphdr->orig_len = size;
-            curr_data += sizeof(pcaprec_hdr_t);
-          
-            // copy frame
-            memcpy(curr_data, data, size);
-        }
+        ec_pcap_record(&device->master->pcap, direction, &ts, data, size);
     }
 }
 
@@ -367,18 +348,41 @@ uint8_t *ec_device_tx_data(
 
 /*****************************************************************************/
 
-/** Sends the content of the transmit socket buffer.
+/** Allocates a dedicated transmit frame.
  *
- * Cuts the socket buffer content to the (now known) size, and calls the
- * start_xmit() function of the assigned net_device.
+ * In contrast to the frames of the transmit ring, the frame is owned by the
+ * caller, which may keep datagram contents in place between transmissions.
+ * The frame has to be freed with dev_kfree_skb().
+ *
+ * \return Socket buffer, or NULL if the allocation failed.
  */
-void ec_device_send(
+struct sk_buff *ec_device_alloc_frame(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    struct sk_buff *skb;
+
+    if (!(skb = dev_alloc_skb(ETH_FRAME_LEN))) {
+        return NULL;
+    }
+
+    // the Ethernet-II-header is taken over from the ring on sending
+    skb_reserve(skb, ETH_HLEN);
+    skb_push(skb, ETH_HLEN);
+    memset(skb->data, 0x00, ETH_FRAME_LEN);
+    return skb;
+}
+
+/*****************************************************************************/
+
+/** Transmits a socket buffer.
+ */
+static void ec_device_xmit(
         ec_device_t *device, /**< EtherCAT device */
+        struct sk_buff *skb, /**< socket buffer to send */
         size_t size /**< number of bytes to send */
         )
 {
-    struct sk_buff *skb = device->tx_skb[device->tx_ring_index];
-
     // set the right length for the data
     skb->len = ETH_HLEN + size;
 
@@ -399,7 +403,7 @@ void ec_device_send(
         device->master->device_stats.tx_count++;
         device->tx_bytes += ETH_HLEN + size;
         device->master->device_stats.tx_bytes += ETH_HLEN + size;
-        pcap_record(device, skb->data, ETH_HLEN + size);
+        pcap_record(device, EC_PCAP_TX, skb->data, ETH_HLEN + size);
 #ifdef EC_DEBUG_IF
         ec_debug_send(&device->dbg, skb->data, ETH_HLEN + size);
 #endif
@@ -414,6 +418,39 @@ void ec_device_send(
 
 /*****************************************************************************/
 
+/** Sends the content of the transmit socket buffer.
+ *
+ * Cuts the socket buffer content to the (now known) size, and calls the
+ * start_xmit() function of the assigned net_device.
+ */
+void ec_device_send(
+        ec_device_t *device, /**< EtherCAT device */
+        size_t size /**< number of bytes to send */
+        )
+{
+    ec_device_xmit(device, device->tx_skb[device->tx_ring_index], size);
+}
+
+/*****************************************************************************/
+
+/** Sends a frame allocated with ec_device_alloc_frame().
+ *
+ * The Ethernet header and the net_device are updated first, because the
+ * device may have been re-attached since the frame was built.
+ */
+void ec_device_send_frame(
+        ec_device_t *device, /**< EtherCAT device */
+        struct sk_buff *skb, /**< dedicated transmit frame */
+        size_t size /**< number of bytes to send */
+        )
+{
+    memcpy(skb->data, device->tx_skb[0]->data, ETH_HLEN);
+    skb->dev = device->dev;
+    ec_device_xmit(device, skb, size);
+}
+
+/*****************************************************************************/
+
 /** Clears the frame statistics.
  */
 void ec_device_clear_stats(
@@ -706,7 +743,7 @@ void ecdev_receive(
         ec_print_data(data, size);
     }
 
-    pcap_record(device, data, size);
+    pcap_record(device, EC_PCAP_RX, data, size);
 #ifdef EC_DEBUG_IF
     ec_debug_send(&device->dbg, data, size);
 #endif
@@ -131,35 +131,6 @@ struct ec_device
 
 /*****************************************************************************/
 
-/**
-   pcap global header
-*/
-
-typedef struct {
-    u32 magic_number;   /* magic number */
-    u16 version_major;  /* major version number */
-    u16 version_minor;  /* minor version number */
-    s32 thiszone;       /* GMT to local correction */
-    u32 sigfigs;        /* accuracy of timestamps */
-    u32 snaplen;        /* max length of captured packets, in octets */
-    u32 network;        /* data link type */
-} pcap_hdr_t;
-
-/*****************************************************************************/
-
-/**
-   pcap packet header
-*/
-
-typedef struct {
-    u64 ts_sec;         /* timestamp seconds */
-    u64 ts_nsec;        /* timestamp nanoseconds */
-    u32 incl_len;       /* number of octets of packet saved in file */
-    u32 orig_len;       /* actual length of packet */
-} pcaprec_hdr_t;
-
-/*****************************************************************************/
-
 int ec_device_init(ec_device_t *, ec_master_t *);
 void ec_device_clear(ec_device_t *);
 
@@ -173,6 +144,8 @@ int ec_device_close(ec_device_t *);
 void ec_device_poll(ec_device_t *);
 uint8_t *ec_device_tx_data(ec_device_t *);
 void ec_device_send(ec_device_t *, size_t);
+struct sk_buff *ec_device_alloc_frame(ec_device_t *);
+void ec_device_send_frame(ec_device_t *, struct sk_buff *, size_t);
 void ec_device_clear_stats(ec_device_t *);
 void ec_device_update_stats(ec_device_t *);
 
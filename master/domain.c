@@ -74,6 +74,7 @@ void ec_domain_init(
     domain->data_size = 0;
     domain->data = NULL;
     domain->data_origin = EC_ORIG_INTERNAL;
+    domain->tx_frame = NULL;
     domain->logical_base_address = 0x00000000;
     INIT_LIST_HEAD(&domain->datagram_pairs);
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
@@ -116,7 +117,10 @@ void ec_domain_clear_data(
         ec_domain_t *domain /**< EtherCAT domain. */
         )
 {
-    if (domain->data_origin == EC_ORIG_INTERNAL && domain->data) {
+    if (domain->tx_frame) {
+        dev_kfree_skb(domain->tx_frame);
+        domain->tx_frame = NULL;
+    } else if (domain->data_origin == EC_ORIG_INTERNAL && domain->data) {
         kfree(domain->data);
     }
 
@@ -297,6 +301,49 @@ static int emplace_datagram(ec_domain_t *domain,
 
 /*****************************************************************************/
 
+/** Allocates the process data memory inside a dedicated transmit frame.
+ *
+ * This is possible, if the master allocates the process data memory, the
+ * process data fit into a single datagram and no redundancy is used. The
+ * datagram is then sent without copying. If zero-copy domains are enabled,
+ * but the domain does not qualify, the reason is logged.
+ *
+ * \return Non-zero, if the memory was allocated.
+ */
+static int ec_domain_alloc_tx_frame(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    const char *reason;
+
+    if (!zero_copy_domains) {
+        return 0;
+    }
+
+    if (domain->data_origin != EC_ORIG_INTERNAL) {
+        reason = "the application provides the memory";
+    } else if (domain->data_size > EC_MAX_DATA_SIZE) {
+        reason = "the process data need more than one datagram";
+    } else if (ec_master_num_devices(domain->master) > 1) {
+        reason = "a backup device is used";
+    } else {
+        domain->tx_frame = ec_device_alloc_frame(
+                &domain->master->devices[EC_DEVICE_MAIN]);
+        if (domain->tx_frame) {
+            domain->data = domain->tx_frame->data + ETH_HLEN
+                + EC_FRAME_HEADER_SIZE + EC_DATAGRAM_HEADER_SIZE;
+            return 1;
+        }
+        reason = "no frame could be allocated";
+    }
+
+    EC_MASTER_INFO(domain->master, "Domain%u: No zero-copy frame, because"
+            " %s. Process data are copied.\n", domain->index, reason);
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Finishes a domain.
  *
  * This allocates the necessary datagrams and writes the correct logical
@@ -322,7 +369,8 @@ int ec_domain_finish(
 
     domain->logical_base_address = base_address;
 
-    if (domain->data_size && domain->data_origin == EC_ORIG_INTERNAL) {
+    if (domain->data_size && !ec_domain_alloc_tx_frame(domain)
+            && domain->data_origin == EC_ORIG_INTERNAL) {
         if (!(domain->data =
                     (uint8_t *) kmalloc(domain->data_size, GFP_KERNEL))) {
             EC_MASTER_ERR(domain->master, "Failed to allocate %zu bytes"
@@ -384,6 +432,13 @@ int ec_domain_finish(
         datagram_count++;
     }
 
+    if (domain->tx_frame) {
+        ec_datagram_pair_t *pair = list_first_entry(&domain->datagram_pairs,
+                ec_datagram_pair_t, list);
+        ec_datagram_attach_frame(&pair->datagrams[EC_DEVICE_MAIN],
+                domain->tx_frame);
+    }
+
     EC_MASTER_INFO(domain->master, "Domain%u: Logical address 0x%08x,"
             " %zu byte, expected working counter %u.\n", domain->index,
             domain->logical_base_address, domain->data_size,
@@ -546,6 +601,7 @@ void ecrt_domain_process(ec_domain_t *domain)
 #ifdef EC_RT_SYSLOG
     unsigned int wc_change;
 #endif
+    ec_latency_time_t start = ec_latency_time();
 
 #if DEBUG_REDUNDANCY
     EC_MASTER_DBG(domain->master, 1, "domain %u process\n", domain->index);
@@ -717,6 +773,10 @@ void ecrt_domain_process(ec_domain_t *domain)
         domain->working_counter_changes = 0;
     }
 #endif
+
+    ec_latency_hist_add_span(
+            &domain->master->latency[EC_LATENCY_DOMAIN_PROCESS],
+            start, ec_latency_time());
 }
 
 /*****************************************************************************/
@@ -725,14 +785,17 @@ void ecrt_domain_queue(ec_domain_t *domain)
 {
     ec_datagram_pair_t *datagram_pair;
     ec_device_index_t dev_idx;
+    ec_latency_time_t start = ec_latency_time();
 
     list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
 
 #if EC_MAX_NUM_DEVICES > 1
-        /* copy main data to send buffer */
-        memcpy(datagram_pair->send_buffer,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+        /* copy main data to send buffer (only needed for redundancy) */
+        if (ec_master_num_devices(domain->master) > 1) {
+            memcpy(datagram_pair->send_buffer,
+                    datagram_pair->datagrams[EC_DEVICE_MAIN].data,
+                    datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+        }
 #endif
         ec_master_queue_datagram(domain->master,
                 &datagram_pair->datagrams[EC_DEVICE_MAIN]);
@@ -747,6 +810,10 @@ void ecrt_domain_queue(ec_domain_t *domain)
                     &datagram_pair->datagrams[dev_idx]);
         }
     }
+
+    ec_latency_hist_add_span(
+            &domain->master->latency[EC_LATENCY_DOMAIN_QUEUE],
+            start, ec_latency_time());
 }
 
 /*****************************************************************************/
@@ -61,6 +61,8 @@ struct ec_domain
     size_t data_size; /**< Size of the process data. */
     uint8_t *data; /**< Memory for the process data. */
     ec_origin_t data_origin; /**< Origin of the \a data memory. */
+    struct sk_buff *tx_frame; /**< Dedicated transmit frame containing
+                                \a data, or NULL. */
     uint32_t logical_base_address; /**< Logical offset address of the
                                      process data. */
     struct list_head datagram_pairs; /**< Datagrams pairs (main/backup) for
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   EtherCAT slave controller error counter statistics.
+*/
+
+/****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/jiffies.h>
+#include <linux/math64.h>
+
+#include "globals.h"
+#include "esc_stats.h"
+
+/****************************************************************************/
+
+/** Resets the statistics.
+ *
+ * The next reading only serves as the new base for the differences.
+ */
+void ec_esc_stats_reset(
+        ec_esc_stats_t *stats /**< ESC error statistics. */
+        )
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->window_start = (uint32_t) jiffies;
+}
+
+/****************************************************************************/
+
+/** Calculates the increase of a hardware counter since the last reading.
+ *
+ * If the counter decreased, it was cleared in the meantime (for example by
+ * 'ethercat crc reset'), so all of its value is new.
+ *
+ * \return Increase.
+ */
+static inline unsigned int ec_esc_counter_delta(
+        const ec_esc_stats_t *stats, /**< ESC error statistics. */
+        const uint8_t *data, /**< Register values. */
+        unsigned int offset /**< Register offset. */
+        )
+{
+    uint8_t last = stats->last[offset];
+
+    return data[offset] >= last ? data[offset] - last : data[offset];
+}
+
+/****************************************************************************/
+
+/** Evaluates a reading of the ESC error counters.
+ *
+ * A port raises an event, if it lost its link, or if its error rate reached
+ * the threshold at the end of a rate window.
+ *
+ * \return Bit mask of the ports that raised an event.
+ */
+unsigned int ec_esc_stats_update(
+        ec_esc_stats_t *stats, /**< ESC error statistics. */
+        const uint8_t *data, /**< Values of the error counter registers. */
+        int cleared, /**< The reading cleared the counters. */
+        uint32_t threshold /**< Errors per minute, from which on a port
+                             raises an event. Zero disables the rate
+                             events. */
+        )
+{
+    uint32_t elapsed = (uint32_t) jiffies - stats->window_start;
+    unsigned int port, i, delta, events = 0;
+    int saturating = 0;
+
+    stats->readings++;
+
+    if (stats->valid) {
+        for (port = 0; port < EC_MAX_PORTS; port++) {
+            ec_esc_port_stats_t *ps = &stats->ports[port];
+
+            delta = ec_esc_counter_delta(stats, data, port * 2);
+            ps->invalid_frames += delta;
+            stats->window_errors[port] += delta;
+
+            delta = ec_esc_counter_delta(stats, data, port * 2 + 1);
+            ps->rx_errors += delta;
+            stats->window_errors[port] += delta;
+
+            ps->forwarded_errors +=
+                ec_esc_counter_delta(stats, data, 0x08 + port);
+
+            delta = ec_esc_counter_delta(stats, data, 0x10 + port);
+            if (delta) {
+                ps->lost_links += delta;
+                ps->events++;
+                events |= 1 << port;
+            }
+        }
+
+        stats->processing_unit_errors +=
+            ec_esc_counter_delta(stats, data, 0x0c);
+        stats->pdi_errors += ec_esc_counter_delta(stats, data, 0x0d);
+    }
+
+    if (elapsed >= EC_ESC_RATE_WINDOW * HZ) {
+        for (port = 0; port < EC_MAX_PORTS; port++) {
+            ec_esc_port_stats_t *ps = &stats->ports[port];
+
+            ps->rate = div_u64((u64) stats->window_errors[port]
+                    * 60 * HZ, elapsed);
+            stats->window_errors[port] = 0;
+
+            if (threshold && ps->rate >= threshold) {
+                ps->events++;
+                events |= 1 << port;
+            }
+        }
+        stats->window_start += elapsed;
+    }
+
+    if (cleared) {
+        memset(stats->last, 0, sizeof(stats->last));
+        stats->clears++;
+    } else {
+        memcpy(stats->last, data, sizeof(stats->last));
+    }
+    stats->valid = 1;
+
+    for (i = 0; i < EC_ESC_ERRORS_SIZE; i++) {
+        if (i == 0x0e || i == 0x0f) {
+            continue; // reserved
+        }
+        if (stats->last[i] >= EC_ESC_CLEAR_LEVEL) {
+            saturating = 1;
+            break;
+        }
+    }
+    stats->clear = saturating;
+
+    return events;
+}
+
+/****************************************************************************/
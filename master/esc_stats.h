@@ -0,0 +1,109 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   EtherCAT slave controller error counter statistics.
+*/
+
+/****************************************************************************/
+
+#ifndef __EC_ESC_STATS_H__
+#define __EC_ESC_STATS_H__
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+#include "globals.h"
+
+/****************************************************************************/
+
+/** Address of the ESC error counter registers. */
+#define EC_ESC_ERRORS_ADDRESS 0x0300
+
+/** Size of the ESC error counter registers (0x0300 to 0x0313). */
+#define EC_ESC_ERRORS_SIZE 20
+
+/** Length of the window, the error rates are calculated over [s]. */
+#define EC_ESC_RATE_WINDOW 60
+
+/** Counter value, from which on the monitor clears the counters.
+ *
+ * The ESC counters saturate at 0xff. They are cleared well before, so that
+ * no errors get lost.
+ */
+#define EC_ESC_CLEAR_LEVEL 0xc0
+
+/****************************************************************************/
+
+/** Error statistics of a slave port.
+ */
+typedef struct {
+    uint32_t invalid_frames; /**< Invalid frames (CRC errors). */
+    uint32_t rx_errors; /**< Physical layer RX errors. */
+    uint32_t forwarded_errors; /**< Invalid frames, that a previous slave
+                                 already marked as erroneous. */
+    uint32_t lost_links; /**< Number of lost links. */
+    uint32_t rate; /**< Invalid frames and RX errors per minute in the last
+                     complete rate window. */
+    uint32_t events; /**< Number of threshold events. */
+} ec_esc_port_stats_t;
+
+/** Error statistics of an EtherCAT slave controller.
+ *
+ * The counts are accumulated from the differences of successive readings of
+ * the ESC error counters (0x0300 to 0x0313), so they are not limited by the
+ * 8 bit hardware counters.
+ */
+typedef struct {
+    ec_esc_port_stats_t ports[EC_MAX_PORTS]; /**< Port statistics. */
+    uint32_t processing_unit_errors; /**< ECAT processing unit errors. */
+    uint32_t pdi_errors; /**< PDI errors. */
+    uint32_t readings; /**< Number of successful readings. */
+    uint32_t failures; /**< Number of failed readings. */
+    uint32_t clears; /**< Number of times the counters were cleared by the
+                       monitor. */
+    uint32_t window_start; /**< Start of the current rate window
+                             [jiffies]. */
+    uint32_t window_errors[EC_MAX_PORTS]; /**< Errors in the current rate
+                                            window. */
+    uint8_t last[EC_ESC_ERRORS_SIZE]; /**< Last register values. */
+    uint8_t valid; /**< \a last contains a reading. */
+    uint8_t clear; /**< The next reading shall clear the counters. */
+    uint8_t reserved[2];
+} ec_esc_stats_t;
+
+/****************************************************************************/
+
+#ifdef __KERNEL__
+
+void ec_esc_stats_reset(ec_esc_stats_t *);
+unsigned int ec_esc_stats_update(ec_esc_stats_t *, const uint8_t *, int,
+        uint32_t);
+
+#endif // __KERNEL__
+
+/****************************************************************************/
+
+#endif
@@ -225,6 +225,7 @@ int ec_eoe_init(
     eoe->auto_created = 0;
 
     ec_datagram_init(&eoe->datagram);
+    eoe->datagram.priority = EC_DATAGRAM_PRIO_LOW;
     eoe->queue_datagram = 0;
     eoe->state = ec_eoe_state_rx_start;
     eoe->opened = 0;
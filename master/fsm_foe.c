@@ -88,6 +88,7 @@ void ec_fsm_foe_state_ack_check(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_ack_read(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_ack_read_data(ec_fsm_foe_t *, ec_datagram_t *);
 
+void ec_fsm_foe_state_data_next(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_data_sent(ec_fsm_foe_t *, ec_datagram_t *);
 
 void ec_fsm_foe_state_data_check(ec_fsm_foe_t *, ec_datagram_t *);
@@ -108,6 +109,7 @@ void ec_fsm_foe_init(
 {
     fsm->state = NULL;
     fsm->datagram = NULL;
+    fsm->yield = 0;
 }
 
 /*****************************************************************************/
@@ -155,6 +157,20 @@ int ec_fsm_foe_success(const ec_fsm_foe_t *fsm /**< Finite state machine */)
 
 /*****************************************************************************/
 
+/** Returns, if a write transfer is paused between two data packets.
+ *
+ * The mailbox is not used by the transfer in this state, so that other
+ * mailbox requests can be processed before the transfer is continued.
+ *
+ * \return non-zero if paused.
+ */
+int ec_fsm_foe_paused(const ec_fsm_foe_t *fsm /**< Finite state machine */)
+{
+    return fsm->state == ec_fsm_foe_state_data_next;
+}
+
+/*****************************************************************************/
+
 /** Prepares an FoE transfer.
  */
 void ec_fsm_foe_transfer(
@@ -505,11 +521,14 @@ void ec_fsm_foe_state_ack_read_data(
             return;
         }
 
-        if (ec_foe_prepare_data_send(fsm, datagram)) {
-            ec_foe_set_tx_error(fsm, FOE_PROT_ERROR);
+        fsm->state = ec_fsm_foe_state_data_next;
+        if (fsm->yield) {
+            // leave the mailbox to other requests for one cycle
+            datagram->state = EC_DATAGRAM_INVALID;
             return;
         }
-        fsm->state = ec_fsm_foe_state_data_sent;
+
+        fsm->state(fsm, datagram); // send next packet immediately
         return;
     }
     ec_foe_set_tx_error(fsm, FOE_ACK_ERROR);
@@ -517,6 +536,28 @@ void ec_fsm_foe_state_ack_read_data(
 
 /*****************************************************************************/
 
+/** State: DATA NEXT.
+ *
+ * Sends the next data packet of a write transfer.
+ */
+void ec_fsm_foe_state_data_next(
+        ec_fsm_foe_t *fsm, /**< FoE statemachine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+#ifdef DEBUG_FOE
+    EC_SLAVE_DBG(fsm->slave, 0, "%s()\n", __func__);
+#endif
+
+    if (ec_foe_prepare_data_send(fsm, datagram)) {
+        ec_foe_set_tx_error(fsm, FOE_PROT_ERROR);
+        return;
+    }
+    fsm->state = ec_fsm_foe_state_data_sent;
+}
+
+/*****************************************************************************/
+
 /** State: WRQ SENT.
  *
  * Checks is the previous transmit datagram succeded and sends the next
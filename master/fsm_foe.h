@@ -64,6 +64,7 @@ struct ec_fsm_foe {
     uint32_t last_packet; /**< Current packet is last one to send/receive. */
     uint32_t packet_no; /**< FoE packet number. */
     uint32_t current_size; /**< Size of current packet to send. */
+    unsigned int yield; /**< Pause before sending the next packet. */
 };
 
 /*****************************************************************************/
@@ -73,6 +74,7 @@ void ec_fsm_foe_clear(ec_fsm_foe_t *);
 
 int ec_fsm_foe_exec(ec_fsm_foe_t *, ec_datagram_t *);
 int ec_fsm_foe_success(const ec_fsm_foe_t *);
+int ec_fsm_foe_paused(const ec_fsm_foe_t *);
 
 void ec_fsm_foe_transfer(ec_fsm_foe_t *, ec_slave_t *, ec_foe_request_t *);
 
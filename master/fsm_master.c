@@ -56,7 +56,6 @@ void ec_fsm_master_state_start(ec_fsm_master_t *);
 void ec_fsm_master_state_broadcast(ec_fsm_master_t *);
 void ec_fsm_master_state_read_al_status(ec_fsm_master_t *);
 #ifdef EC_LOOP_CONTROL
-void ec_fsm_master_state_read_dl_status(ec_fsm_master_t *);
 void ec_fsm_master_state_open_port(ec_fsm_master_t *);
 #endif
 void ec_fsm_master_state_dc_read_old_times(ec_fsm_master_t *);
@@ -76,6 +75,9 @@ void ec_fsm_master_state_reboot_slave(ec_fsm_master_t *);
 void ec_fsm_master_enter_dc_read_old_times(ec_fsm_master_t *);
 void ec_fsm_master_enter_clear_addresses(ec_fsm_master_t *);
 void ec_fsm_master_enter_write_system_times(ec_fsm_master_t *);
+void ec_fsm_master_release_slaves(ec_fsm_master_t *);
+void ec_fsm_master_action_read_al_status(ec_fsm_master_t *);
+void ec_fsm_master_action_process_al_status(ec_fsm_master_t *);
 
 /*****************************************************************************/
 
@@ -87,9 +89,21 @@ void ec_fsm_master_init(
         ec_datagram_t *datagram /**< Datagram object to use. */
         )
 {
+    unsigned int i;
+
     fsm->master = master;
     fsm->datagram = datagram;
 
+    for (i = 0; i < EC_FSM_MASTER_AL_BATCH - 1; i++) {
+        ec_datagram_t *al_datagram = &fsm->al_datagrams[i];
+
+        ec_datagram_init(al_datagram);
+        al_datagram->data = fsm->al_data[i];
+        al_datagram->data_origin = EC_ORIG_EXTERNAL;
+        al_datagram->mem_size = sizeof(fsm->al_data[i]);
+        snprintf(al_datagram->name, EC_DATAGRAM_NAME_SIZE, "master-al");
+    }
+
     ec_fsm_master_reset(fsm);
 
     // init sub-state-machines
@@ -105,9 +119,15 @@ void ec_fsm_master_clear(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
+    unsigned int i;
+
     // clear sub-state machines
     ec_fsm_reboot_clear(&fsm->fsm_reboot);
     ec_fsm_sii_clear(&fsm->fsm_sii);
+
+    for (i = 0; i < EC_FSM_MASTER_AL_BATCH - 1; i++) {
+        ec_datagram_clear(&fsm->al_datagrams[i]);
+    }
 }
 
 /*****************************************************************************/
@@ -132,6 +152,9 @@ void ec_fsm_master_reset(
     }
 
     fsm->rescan_required = 0;
+    fsm->al_datagram_count = 0;
+    fsm->al_batch_start = NULL;
+    fsm->al_batch_end = NULL;
 }
 
 /*****************************************************************************/
@@ -147,18 +170,49 @@ int ec_fsm_master_exec(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
+    unsigned int i;
+
     if (fsm->datagram->state == EC_DATAGRAM_SENT
         || fsm->datagram->state == EC_DATAGRAM_QUEUED) {
         // datagram was not sent or received yet.
         return 0;
     }
 
+    for (i = 0; i < fsm->al_datagram_count; i++) {
+        if (fsm->al_datagrams[i].state == EC_DATAGRAM_SENT
+                || fsm->al_datagrams[i].state == EC_DATAGRAM_QUEUED) {
+            return 0;
+        }
+    }
+
+    // the datagram is received by the realtime side without the master lock
+    smp_rmb();
+
     fsm->state(fsm);
     return 1;
 }
 
 /*****************************************************************************/
 
+/** Queues the datagrams of the state machine.
+ *
+ * This has to be called, if ec_fsm_master_exec() returned true.
+ */
+void ec_fsm_master_queue_datagrams(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    unsigned int i;
+
+    ec_master_queue_datagram(fsm->master, fsm->datagram);
+
+    for (i = 0; i < fsm->al_datagram_count; i++) {
+        ec_master_queue_datagram(fsm->master, &fsm->al_datagrams[i]);
+    }
+}
+
+/*****************************************************************************/
+
 /**
  * \return true, if the state machine is in an idle phase
  */
@@ -430,14 +484,9 @@ void ec_fsm_master_state_broadcast(
             ec_fsm_master_enter_write_system_times(fsm);
 
         } else {
-            // fetch state from first slave
+            // fetch states beginning with the first slave
             fsm->slave = master->slaves;
-            ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
-                    0x0130, 2);
-            ec_datagram_zero(datagram);
-            fsm->datagram->device_index = fsm->slave->device_index;
-            fsm->retries = EC_FSM_RETRIES;
-            fsm->state = ec_fsm_master_state_read_al_status;
+            ec_fsm_master_action_read_al_status(fsm);
         }
     } else {
         ec_fsm_master_restart(fsm);
@@ -526,51 +575,81 @@ void ec_fsm_master_action_idle(
 
 /*****************************************************************************/
 
-/** Master action: Get state of next slave.
+/** Master action: Read the AL states of the next slaves.
+ *
+ * Beginning at the current slave, one FPRD per slave is packed into the
+ * cycle, as far as the frame, the maximum queue size and the free datagram
+ * indices allow. The first slave is read with the state machine's datagram.
+ * With loop control, each FPRD also covers the DL status.
  */
-void ec_fsm_master_action_next_slave_state(
+void ec_fsm_master_action_read_al_status(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
+    size_t count, max_count;
+    unsigned int i, budget;
 
-    // is there another slave to query?
-    fsm->slave++;
-    if (fsm->slave < master->slaves + master->slave_count) {
-        // fetch state from next slave
-        fsm->idle = 1;
-        ec_datagram_fprd(fsm->datagram,
-                fsm->slave->station_address, 0x0130, 2);
-        ec_datagram_zero(fsm->datagram);
-        fsm->datagram->device_index = fsm->slave->device_index;
-        fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_master_state_read_al_status;
-        return;
+    max_count = master->max_queue_size / EC_FSM_MASTER_AL_DATAGRAM_SIZE;
+    if (max_count > EC_FSM_MASTER_AL_BATCH) {
+        max_count = EC_FSM_MASTER_AL_BATCH;
+    }
+    budget = ec_master_fsm_datagram_budget(master);
+    if (max_count > budget) {
+        max_count = budget;
+    }
+    if (max_count < 1) {
+        max_count = 1;
+    }
+    count = master->slaves + master->slave_count - fsm->slave;
+    if (count > max_count) {
+        count = max_count;
     }
 
-    // all slaves processed
-    ec_fsm_master_action_idle(fsm);
+    fsm->al_batch_start = fsm->slave;
+    fsm->al_batch_end = fsm->slave + count;
+
+    ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
+            EC_FSM_MASTER_STATUS_ADDRESS, EC_FSM_MASTER_STATUS_SIZE);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = fsm->slave->device_index;
+
+    for (i = 1; i < count; i++) {
+        ec_datagram_t *datagram = &fsm->al_datagrams[i - 1];
+        const ec_slave_t *slave = fsm->slave + i;
+
+        ec_datagram_fprd(datagram, slave->station_address,
+                EC_FSM_MASTER_STATUS_ADDRESS, EC_FSM_MASTER_STATUS_SIZE);
+        ec_datagram_zero(datagram);
+        datagram->device_index = slave->device_index;
+    }
+
+    fsm->al_datagram_count = count - 1;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_read_al_status;
 }
 
 /*****************************************************************************/
 
-#ifdef EC_LOOP_CONTROL
-
-/** Master action: Read DL status of current slave.
+/** Master action: Get state of next slave.
+ *
+ * Called after the current slave needed further bus access. The rest of the
+ * snapshot is outdated by then, so the states of the next slaves are read
+ * again.
  */
-void ec_fsm_master_action_read_dl_status(
+void ec_fsm_master_action_next_slave_state(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_datagram_fprd(fsm->datagram, fsm->slave->station_address, 0x0110, 2);
-    ec_datagram_zero(fsm->datagram);
-    fsm->datagram->device_index = fsm->slave->device_index;
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_master_state_read_dl_status;
+    fsm->slave++;
+    fsm->al_batch_end = fsm->slave;
+    ec_fsm_master_action_process_al_status(fsm);
 }
 
 /*****************************************************************************/
 
+#ifdef EC_LOOP_CONTROL
+
 /** Master action: Open slave port.
  */
 void ec_fsm_master_action_open_port(
@@ -588,37 +667,20 @@ void ec_fsm_master_action_open_port(
 
 /*****************************************************************************/
 
-/** Master state: READ DL STATUS.
+/** Master action: Process the DL status of the current slave.
  *
- * Fetches the DL state of a slave.
+ * \return Non-zero, if a port is opened, so that the state check has to
+ *         wait for the bus.
  */
-void ec_fsm_master_state_read_dl_status(
-        ec_fsm_master_t *fsm /**< Master state machine. */
+int ec_fsm_master_action_process_dl_status(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        uint16_t dl_status /**< DL status from the snapshot. */
         )
 {
     ec_slave_t *slave = fsm->slave;
-    ec_datagram_t *datagram = fsm->datagram;
     unsigned int i;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
-        return;
-    }
-
-    if (datagram->state != EC_DATAGRAM_RECEIVED) {
-        EC_SLAVE_ERR(slave, "Failed to receive AL state datagram: ");
-        ec_datagram_print_state(datagram);
-        ec_fsm_master_restart(fsm);
-        return;
-    }
-
-    // did the slave not respond to its station address?
-    if (datagram->working_counter != 1) {
-        // try again next time
-        ec_fsm_master_action_next_slave_state(fsm);
-        return;
-    }
-
-    ec_slave_set_dl_status(slave, EC_READ_U16(datagram->data));
+    ec_slave_set_dl_status(slave, dl_status);
 
     // process port state machines
     for (i = 0; i < EC_MAX_PORTS; i++) {
@@ -642,7 +704,7 @@ void ec_fsm_master_state_read_dl_status(
                             HZ * EC_PORT_WAIT_MS / 1000) {
                         port->state = EC_SLAVE_PORT_UP;
                         ec_fsm_master_action_open_port(fsm);
-                        return;
+                        return 1;
                     }
                 }
                 else { // link down
@@ -657,8 +719,7 @@ void ec_fsm_master_state_read_dl_status(
         }
     }
 
-    // process next slave
-    ec_fsm_master_action_next_slave_state(fsm);
+    return 0;
 }
 
 /*****************************************************************************/
@@ -699,9 +760,35 @@ void ec_fsm_master_state_open_port(
 
 /*****************************************************************************/
 
+/** Master action: Release slave FSMs for configuration.
+ *
+ * The AL states are known from the scan, so the slave FSMs need not wait
+ * until the state check reaches them. The number of slave FSMs actually
+ * configuring at the same time is limited by ec_master_exec_slave_fsms().
+ */
+void ec_fsm_master_release_slaves(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count;
+            slave++) {
+        if (!slave->error_flag && !slave->reboot) {
+            ec_fsm_slave_set_ready(&slave->fsm);
+        }
+    }
+}
+
+/*****************************************************************************/
+
 /** Master action: Configure.
+ *
+ * \return Non-zero, if the state check was aborted.
  */
-void ec_fsm_master_action_configure(
+int ec_fsm_master_action_configure(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
@@ -719,82 +806,138 @@ void ec_fsm_master_action_configure(
 
         fsm->slave = master->slaves; // begin with first slave
         ec_fsm_master_enter_write_system_times(fsm);
-        return;
+        return 1;
     }
 
     // allow slave to start config (if not already done).
     ec_fsm_slave_set_ready(&fsm->slave->fsm);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Master action: Process AL status snapshot.
+ *
+ * Dispatches the AL states of the slaves from the current slave up to the
+ * end of the snapshot, until a slave needs further bus access. Afterwards,
+ * the states of the next slaves are read.
+ *
+ * A slave needing bus access ends the snapshot: Its readings would be stale
+ * for the remaining slaves, which are configured in parallel meanwhile (see
+ * ec_fsm_master_action_next_slave_state()).
+ */
+void ec_fsm_master_action_process_al_status(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+
+    while (fsm->slave < fsm->al_batch_end) {
+        ec_slave_t *slave = fsm->slave;
+        uint16_t al_status = fsm->al_status[slave - fsm->al_batch_start];
+
+        // did the slave not respond to its station address?
+        if (al_status == EC_FSM_MASTER_AL_NO_RESPONSE) {
+            if (!slave->error_flag) {
+                slave->error_flag = 1;
+                EC_SLAVE_DBG(slave, 1,
+                        "Slave did not respond to state query.\n");
+            }
+            fsm->rescan_required = 1;
+            ec_fsm_master_restart(fsm);
+            return;
+        }
+
+        ec_slave_set_al_status(slave, al_status);
+
+        if (slave->reboot) {
+            // A reboot of this slave was requested
+            slave->reboot = 0;
+            fsm->idle = 0;
+            fsm->state = ec_fsm_master_state_reboot_slave;
+            ec_fsm_reboot_single(&fsm->fsm_reboot, slave);
+            fsm->state(fsm); // execute immediately
+            return;
+        }
+
+        // Check for configuration
+        if (!slave->error_flag && ec_fsm_master_action_configure(fsm)) {
+            return;
+        }
 
 #ifdef EC_LOOP_CONTROL
-    // read DL status
-    ec_fsm_master_action_read_dl_status(fsm);
-#else
-    // process next slave
-    ec_fsm_master_action_next_slave_state(fsm);
+        if (ec_fsm_master_action_process_dl_status(fsm,
+                    fsm->dl_status[slave - fsm->al_batch_start])) {
+            return;
+        }
 #endif
+
+        fsm->slave++;
+    }
+
+    if (fsm->slave < master->slaves + master->slave_count) {
+        // fetch states from next slaves
+        fsm->idle = 1;
+        ec_fsm_master_action_read_al_status(fsm);
+        return;
+    }
+
+    // all slaves processed
+    ec_fsm_master_action_idle(fsm);
 }
 
 /*****************************************************************************/
 
 /** Master state: READ AL STATUS.
  *
- * Fetches the AL state of a slave.
+ * Fetches the AL states of the slaves in the current snapshot.
  */
 void ec_fsm_master_state_read_al_status(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_slave_t *slave = fsm->slave;
     ec_datagram_t *datagram = fsm->datagram;
+    unsigned int i, count = fsm->al_datagram_count;
+    int timed_out = datagram->state == EC_DATAGRAM_TIMED_OUT;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
-        return;
+    for (i = 0; i < count; i++) {
+        if (fsm->al_datagrams[i].state == EC_DATAGRAM_TIMED_OUT) {
+            timed_out = 1;
+        }
     }
 
-    if (datagram->state != EC_DATAGRAM_RECEIVED) {
-        EC_SLAVE_ERR(slave, "Failed to receive AL state datagram: ");
-        ec_datagram_print_state(datagram);
-        ec_fsm_master_restart(fsm);
+    if (timed_out && fsm->retries--) {
         return;
     }
 
-    // did the slave not respond to its station address?
-    if (datagram->working_counter != 1) {
-        if (!slave->error_flag) {
-            slave->error_flag = 1;
-            EC_SLAVE_DBG(slave, 1, "Slave did not respond to state query.\n");
-        }
-        fsm->rescan_required = 1;
-        ec_fsm_master_restart(fsm);
-        return;
-    }
+    fsm->al_datagram_count = 0;
 
-    // A single slave responded
-    ec_slave_set_al_status(slave, EC_READ_U8(datagram->data));
+    for (i = 0; i <= count; i++) {
+        ec_slave_t *slave = fsm->al_batch_start + i;
 
-    if (slave->reboot) {
-        // A reboot of this slave was requested
-        slave->reboot = 0;
-        fsm->idle = 0;
-        fsm->state = ec_fsm_master_state_reboot_slave;
-        ec_fsm_reboot_single(&fsm->fsm_reboot, slave);
-        fsm->state(fsm); // execute immediately
-        return;
-    }
+        if (i) {
+            datagram = &fsm->al_datagrams[i - 1];
+        }
 
-    if (!slave->error_flag) {
-        // Check for configuration
-        ec_fsm_master_action_configure(fsm);
-        return;
-    }
+        if (datagram->state != EC_DATAGRAM_RECEIVED) {
+            EC_SLAVE_ERR(slave, "Failed to receive AL state datagram: ");
+            ec_datagram_print_state(datagram);
+            ec_fsm_master_restart(fsm);
+            return;
+        }
 
+        if (datagram->working_counter == 1) {
+            fsm->al_status[i] = EC_READ_U8(datagram->data
+                    + EC_FSM_MASTER_STATUS_SIZE - 2);
 #ifdef EC_LOOP_CONTROL
-    // read DL status
-    ec_fsm_master_action_read_dl_status(fsm);
-#else
-    // process next slave
-    ec_fsm_master_action_next_slave_state(fsm);
+            fsm->dl_status[i] = EC_READ_U16(datagram->data);
 #endif
+        } else {
+            fsm->al_status[i] = EC_FSM_MASTER_AL_NO_RESPONSE;
+        }
+    }
+
+    ec_fsm_master_action_process_al_status(fsm);
 }
 
 /*****************************************************************************/
@@ -1097,6 +1240,8 @@ void ec_fsm_master_state_scan_slave(
     master->scan_busy = 0;
     wake_up_interruptible(&master->scan_queue);
 
+    ec_master_dc_monitor_update(master);
+
     // Attach slave configurations
     ec_master_attach_slave_configs(master);
 
@@ -1161,6 +1306,7 @@ void ec_fsm_master_enter_write_system_times(
     }
 
     // scanning and setting system times complete
+    ec_fsm_master_release_slaves(fsm);
     ec_master_request_op(master);
     ec_fsm_master_restart(fsm);
 }
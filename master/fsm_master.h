@@ -60,6 +60,38 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** First register read by the state check.
+ *
+ * With loop control, the DL status (0x0110) is read together with the AL
+ * status (0x0130), so that the port state machines need no extra cycle.
+ */
+#ifdef EC_LOOP_CONTROL
+#define EC_FSM_MASTER_STATUS_ADDRESS 0x0110
+#else
+#define EC_FSM_MASTER_STATUS_ADDRESS 0x0130
+#endif
+
+/** Number of bytes read per slave by the state check, ending with the AL
+ * status. */
+#define EC_FSM_MASTER_STATUS_SIZE (0x0132 - EC_FSM_MASTER_STATUS_ADDRESS)
+
+/** Size of an AL status datagram on the wire in byte. */
+#define EC_FSM_MASTER_AL_DATAGRAM_SIZE \
+    (EC_DATAGRAM_HEADER_SIZE + EC_FSM_MASTER_STATUS_SIZE \
+     + EC_DATAGRAM_FOOTER_SIZE)
+
+/** Maximum number of slaves, whose AL status is read in one cycle.
+ *
+ * This is the number of AL status datagrams that fit into a single frame.
+ */
+#define EC_FSM_MASTER_AL_BATCH \
+    ((ETH_DATA_LEN - EC_FRAME_HEADER_SIZE) / EC_FSM_MASTER_AL_DATAGRAM_SIZE)
+
+/** AL status snapshot value of a slave that did not respond. */
+#define EC_FSM_MASTER_AL_NO_RESPONSE 0xffff
+
+/*****************************************************************************/
+
 typedef struct ec_fsm_master ec_fsm_master_t; /**< \see ec_fsm_master */
 
 /** Finite state machine of an EtherCAT master.
@@ -84,6 +116,19 @@ struct ec_fsm_master {
                                                          responding slaves for
                                                          every device. */
     ec_slave_t *slave; /**< current slave */
+    ec_datagram_t al_datagrams[EC_FSM_MASTER_AL_BATCH - 1]; /**< Additional
+                                                              AL status
+                                                              datagrams. */
+    uint8_t al_data[EC_FSM_MASTER_AL_BATCH - 1][EC_FSM_MASTER_STATUS_SIZE];
+    /**< Payload memory of \a al_datagrams. */
+    unsigned int al_datagram_count; /**< Number of \a al_datagrams to be
+                                      queued with \a datagram. */
+    ec_slave_t *al_batch_start; /**< First slave in \a al_status. */
+    ec_slave_t *al_batch_end; /**< End of the slaves in \a al_status. */
+    uint16_t al_status[EC_FSM_MASTER_AL_BATCH]; /**< AL status snapshot. */
+#ifdef EC_LOOP_CONTROL
+    uint16_t dl_status[EC_FSM_MASTER_AL_BATCH]; /**< DL status snapshot. */
+#endif
     ec_sii_write_request_t *sii_request; /**< SII write request */
     off_t sii_index; /**< index to SII write request data */
 
@@ -100,6 +145,7 @@ void ec_fsm_master_reset(ec_fsm_master_t *);
 
 int ec_fsm_master_exec(ec_fsm_master_t *);
 int ec_fsm_master_idle(const ec_fsm_master_t *);
+void ec_fsm_master_queue_datagrams(ec_fsm_master_t *);
 
 /*****************************************************************************/
 
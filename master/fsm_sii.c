@@ -113,6 +113,7 @@ void ec_fsm_sii_read(ec_fsm_sii_t *fsm, /**< finite state machine */
     fsm->slave = slave;
     fsm->word_offset = word_offset;
     fsm->mode = mode;
+    fsm->value_size = 4;
 }
 
 /*****************************************************************************/
@@ -212,13 +213,13 @@ static void ec_fsm_sii_prepare_read_check(
         ec_datagram_t *datagram /**< Datagram to use. */
         )
 {
-    // issue check/fetch datagram
+    // issue check/fetch datagram, including the full 64 bit data register
     switch (fsm->mode) {
         case EC_FSM_SII_USE_INCREMENT_ADDRESS:
-            ec_datagram_aprd(datagram, fsm->slave->ring_position, 0x502, 10);
+            ec_datagram_aprd(datagram, fsm->slave->ring_position, 0x502, 14);
             break;
         case EC_FSM_SII_USE_CONFIGURED_ADDRESS:
-            ec_datagram_fprd(datagram, fsm->slave->station_address, 0x502, 10);
+            ec_datagram_fprd(datagram, fsm->slave->station_address, 0x502, 14);
             break;
     }
 
@@ -354,7 +355,7 @@ void ec_fsm_sii_state_read_fetch(
 
 #ifdef SII_DEBUG
     EC_SLAVE_DBG(fsm->slave, 0, "checking SII read state:\n");
-    ec_print_data(fsm->datagram->data, 10);
+    ec_print_data(fsm->datagram->data, 14);
 #endif
 
     if (EC_READ_U8(fsm->datagram->data + 1) & 0x20) {
@@ -424,8 +425,10 @@ void ec_fsm_sii_state_read_fetch(
         return;
     }
 
-    // SII value received.
-    memcpy(fsm->value, fsm->datagram->data + 6, 4);
+    // SII value received. If bit 6 of the control/status register is set,
+    // the ESC reads 8 bytes per access, otherwise 4 bytes.
+    fsm->value_size = EC_READ_U8(fsm->datagram->data) & 0x40 ? 8 : 4;
+    memcpy(fsm->value, fsm->datagram->data + 6, 8);
     fsm->state = ec_fsm_sii_state_end;
 }
 
@@ -55,9 +55,10 @@ int ec_fsm_slave_action_process_config_sdo(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_sdo(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_sdo_request(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_reg(ec_fsm_slave_t *, ec_datagram_t *);
-void ec_fsm_slave_state_reg_request(ec_fsm_slave_t *, ec_datagram_t *);
+void ec_fsm_slave_reg_finish(ec_fsm_slave_t *);
 int ec_fsm_slave_action_process_foe(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_foe_request(ec_fsm_slave_t *, ec_datagram_t *);
+void ec_fsm_slave_exec_foe(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_soe(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_soe_request(ec_fsm_slave_t *, ec_datagram_t *);
 #ifdef EC_EOE
@@ -69,6 +70,29 @@ void ec_fsm_slave_state_mbg_request(ec_fsm_slave_t *, ec_datagram_t *);
 
 /*****************************************************************************/
 
+/** External mailbox request types.
+ *
+ * They are served in a round-robin manner, so that a queue of requests of
+ * one protocol can not hold back the requests of the others.
+ */
+static int (* const ec_fsm_slave_mbox_actions[])(ec_fsm_slave_t *,
+        ec_datagram_t *) = {
+    ec_fsm_slave_action_process_sdo,
+    ec_fsm_slave_action_process_foe,
+    ec_fsm_slave_action_process_soe,
+#ifdef EC_EOE
+    ec_fsm_slave_action_process_eoe,
+#endif
+    ec_fsm_slave_action_process_mbg
+};
+
+/** Number of external mailbox request types.
+ */
+#define EC_FSM_SLAVE_MBOX_ACTIONS \
+    (sizeof(ec_fsm_slave_mbox_actions) / sizeof(ec_fsm_slave_mbox_actions[0]))
+
+/*****************************************************************************/
+
 /** Constructor.
  */
 void ec_fsm_slave_init(
@@ -81,8 +105,10 @@ void ec_fsm_slave_init(
 
     fsm->state = ec_fsm_slave_state_idle;
     fsm->datagram = NULL;
+    fsm->mbox_action = 0;
     fsm->sdo_request = NULL;
     fsm->reg_request = NULL;
+    fsm->reg_datagram = NULL;
     fsm->foe_request = NULL;
     fsm->soe_request = NULL;
 #ifdef EC_EOE
@@ -176,6 +202,33 @@ void ec_fsm_slave_clear(
 
 /*****************************************************************************/
 
+/** Returns the sending priority of the current state's datagrams.
+ *
+ * \return Datagram priority.
+ */
+static ec_datagram_priority_t ec_fsm_slave_priority(
+        const ec_fsm_slave_t *fsm /**< Slave state machine. */
+        )
+{
+    if (fsm->state == ec_fsm_slave_state_foe_request
+#ifdef EC_EOE
+            || fsm->state == ec_fsm_slave_state_eoe_request
+#endif
+            ) {
+        return EC_DATAGRAM_PRIO_LOW;
+    }
+
+    if (fsm->state == ec_fsm_slave_state_soe_request
+            || fsm->state == ec_fsm_slave_state_mbg_request
+            || fsm->state == ec_fsm_slave_state_dict_request) {
+        return EC_DATAGRAM_PRIO_NORMAL;
+    }
+
+    return EC_DATAGRAM_PRIO_HIGH;
+}
+
+/*****************************************************************************/
+
 /** Executes the current state of the state machine.
  *
  * \return 1 if \a datagram was used, else 0.
@@ -189,11 +242,17 @@ int ec_fsm_slave_exec(
 
     fsm->state(fsm, datagram);
 
+    if (fsm->datagram && fsm->datagram->ext_owner == fsm) {
+        fsm->datagram->ext_owner = NULL; // evaluated
+    }
+
     datagram_used = fsm->state != ec_fsm_slave_state_idle &&
         fsm->state != ec_fsm_slave_state_ready;
 
     if (datagram_used) {
         datagram->device_index = fsm->slave->device_index;
+        datagram->priority = ec_fsm_slave_priority(fsm);
+        datagram->ext_owner = fsm;
         fsm->datagram = datagram;
     } else {
         fsm->datagram = NULL;
@@ -204,6 +263,88 @@ int ec_fsm_slave_exec(
 
 /*****************************************************************************/
 
+/** Returns, if register requests may be started.
+ *
+ * \return Non-zero, if the slave is neither idle nor being scanned or
+ *         configured.
+ */
+static int ec_fsm_slave_reg_allowed(
+        const ec_fsm_slave_t *fsm /**< Slave state machine. */
+        )
+{
+    return fsm->state != ec_fsm_slave_state_idle
+        && fsm->state != ec_fsm_slave_state_scan
+        && fsm->state != ec_fsm_slave_state_acknowledge
+        && fsm->state != ec_fsm_slave_state_config;
+}
+
+/*****************************************************************************/
+
+/** Checks for register requests to process.
+ *
+ * \return Non-zero, if a register request is waiting.
+ */
+int ec_fsm_slave_reg_pending(
+        const ec_fsm_slave_t *fsm /**< Slave state machine. */
+        )
+{
+    const ec_slave_t *slave = fsm->slave;
+    const ec_reg_request_t *reg;
+
+    if (!ec_fsm_slave_reg_allowed(fsm)) {
+        return 0;
+    }
+
+    if (!list_empty(&slave->reg_requests)) {
+        return 1;
+    }
+
+    if (slave->config) {
+        list_for_each_entry(reg, &slave->config->reg_requests, list) {
+            if (reg->state == EC_INT_REQUEST_QUEUED) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Executes the register request channel of the state machine.
+ *
+ * Register requests do not use the mailbox. They are processed with a
+ * datagram of their own, in parallel to the mailbox requests.
+ *
+ * \return 1 if \a datagram was used, else 0.
+ */
+int ec_fsm_slave_exec_reg(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< New datagram to use. */
+        )
+{
+    if (fsm->reg_datagram) {
+        ec_fsm_slave_reg_finish(fsm);
+        if (fsm->reg_datagram->ext_owner == fsm) {
+            fsm->reg_datagram->ext_owner = NULL; // evaluated
+        }
+        fsm->reg_datagram = NULL;
+    }
+
+    if (!ec_fsm_slave_reg_pending(fsm) ||
+            !ec_fsm_slave_action_process_reg(fsm, datagram)) {
+        return 0;
+    }
+
+    datagram->priority = EC_DATAGRAM_PRIO_HIGH;
+    datagram->ext_owner = fsm;
+    fsm->reg_datagram = datagram;
+    return 1;
+}
+
+/*****************************************************************************/
+
 /** Sets the current state of the state machine to READY
  */
 void ec_fsm_slave_set_ready(
@@ -662,6 +803,10 @@ int ec_fsm_slave_set_unready(
         ec_fsm_slave_t *fsm /**< Slave state machine. */
         )
 {
+    if (fsm->reg_datagram) {
+        return 0; // register request in progress
+    }
+
     if (fsm->state == ec_fsm_slave_state_idle) {
         return 1;
     } else if (fsm->state == ec_fsm_slave_state_ready) {
@@ -708,6 +853,8 @@ void ec_fsm_slave_state_ready(
         ec_datagram_t *datagram /**< Datagram to use. */
         )
 {
+    unsigned int i, action;
+
     // Check for pending scan requests
     if (ec_fsm_slave_action_scan(fsm, datagram)) {
         return;
@@ -727,37 +874,15 @@ void ec_fsm_slave_state_ready(
     if (ec_fsm_slave_action_process_dict(fsm, datagram)) {
         return;
     }
-    
-    // Check for pending external SDO requests
-    if (ec_fsm_slave_action_process_sdo(fsm, datagram)) {
-        return;
-    }
-
-    // Check for pending external register requests
-    if (ec_fsm_slave_action_process_reg(fsm, datagram)) {
-        return;
-    }
 
-    // Check for pending FoE requests
-    if (ec_fsm_slave_action_process_foe(fsm, datagram)) {
-        return;
-    }
-
-    // Check for pending SoE requests
-    if (ec_fsm_slave_action_process_soe(fsm, datagram)) {
-        return;
-    }
-
-#ifdef EC_EOE
-    // Check for pending EoE IP parameter requests
-    if (ec_fsm_slave_action_process_eoe(fsm, datagram)) {
-        return;
-    }
-#endif
-    
-    // Check for pending MBox Gateway requests
-    if (ec_fsm_slave_action_process_mbg(fsm, datagram)) {
-        return;
+    // Check for pending external SDO, FoE, SoE, EoE and MBox Gateway
+    // requests, starting after the type served last
+    for (i = 0; i < EC_FSM_SLAVE_MBOX_ACTIONS; i++) {
+        action = (fsm->mbox_action + i) % EC_FSM_SLAVE_MBOX_ACTIONS;
+        if (ec_fsm_slave_mbox_actions[action](fsm, datagram)) {
+            fsm->mbox_action = (action + 1) % EC_FSM_SLAVE_MBOX_ACTIONS;
+            return;
+        }
     }
 }
 
@@ -832,19 +957,22 @@ void ec_fsm_slave_state_sdo_request(
     if (!ec_fsm_coe_success(&fsm->fsm_coe)) {
         EC_SLAVE_ERR(slave, "Failed to process SDO request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
-        fsm->sdo_request = NULL;
-        fsm->state = ec_fsm_slave_state_ready;
-        return;
+    } else {
+        EC_SLAVE_DBG(slave, 1, "Finished SDO request.\n");
+        request->state = EC_INT_REQUEST_SUCCESS;
     }
 
-    EC_SLAVE_DBG(slave, 1, "Finished SDO request.\n");
-
     // SDO request finished
-    request->state = EC_INT_REQUEST_SUCCESS;
     wake_up_all(&slave->master->request_queue);
     fsm->sdo_request = NULL;
-    fsm->state = ec_fsm_slave_state_ready;
+
+    if (fsm->foe_request) {
+        // continue the FoE transfer the request was interleaved with
+        fsm->state = ec_fsm_slave_state_foe_request;
+        ec_fsm_slave_exec_foe(fsm, datagram);
+    } else {
+        fsm->state = ec_fsm_slave_state_ready;
+    }
 }
 
 /*****************************************************************************/
@@ -897,7 +1025,6 @@ int ec_fsm_slave_action_process_reg(
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
         fsm->reg_request = NULL;
-        fsm->state = ec_fsm_slave_state_idle;
         return 0;
     }
 
@@ -932,62 +1059,56 @@ int ec_fsm_slave_action_process_reg(
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
         fsm->reg_request = NULL;
-        fsm->state = ec_fsm_slave_state_idle;
-        return 1;
+        return 0;
     }
     datagram->device_index = slave->device_index;
-    fsm->state = ec_fsm_slave_state_reg_request;
     return 1;
 }
 
 /*****************************************************************************/
 
-/** Slave state: Register request.
+/** Evaluates the datagram of the register request in progress.
  */
-void ec_fsm_slave_state_reg_request(
-        ec_fsm_slave_t *fsm, /**< Slave state machine. */
-        ec_datagram_t *datagram /**< Datagram to use. */
+void ec_fsm_slave_reg_finish(
+        ec_fsm_slave_t *fsm /**< Slave state machine. */
         )
 {
     ec_slave_t *slave = fsm->slave;
     ec_reg_request_t *reg = fsm->reg_request;
+    ec_datagram_t *datagram = fsm->reg_datagram;
 
     if (!reg) {
         // configuration was cleared in the meantime
-        fsm->state = ec_fsm_slave_state_ready;
-        fsm->reg_request = NULL;
         return;
     }
 
-    if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
+    fsm->reg_request = NULL;
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
         EC_SLAVE_ERR(slave, "Failed to receive register"
                 " request datagram: ");
-        ec_datagram_print_state(fsm->datagram);
+        ec_datagram_print_state(datagram);
         reg->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
-        fsm->reg_request = NULL;
-        fsm->state = ec_fsm_slave_state_ready;
         return;
     }
 
-    if (fsm->datagram->working_counter == ((reg->dir == EC_DIR_BOTH) ? 3 : 1)) {
+    if (datagram->working_counter == ((reg->dir == EC_DIR_BOTH) ? 3 : 1)) {
         if (reg->dir != EC_DIR_OUTPUT) { // read/read-write request
-            memcpy(reg->data, fsm->datagram->data, reg->transfer_size);
+            memcpy(reg->data, datagram->data, reg->transfer_size);
         }
 
         reg->state = EC_INT_REQUEST_SUCCESS;
         EC_SLAVE_DBG(slave, 1, "Register request successful.\n");
     } else {
         reg->state = EC_INT_REQUEST_FAILURE;
-        ec_datagram_print_state(fsm->datagram);
+        ec_datagram_print_state(datagram);
         EC_SLAVE_ERR(slave, "Register request failed"
                 " (working counter is %u).\n",
-                fsm->datagram->working_counter);
+                datagram->working_counter);
     }
 
     wake_up_all(&slave->master->request_queue);
-    fsm->reg_request = NULL;
-    fsm->state = ec_fsm_slave_state_ready;
 }
 
 /*****************************************************************************/
@@ -1047,16 +1168,61 @@ int ec_fsm_slave_action_process_foe(
 
 /*****************************************************************************/
 
+/** Returns, if an FoE transfer shall pause for pending SDO requests.
+ *
+ * SDO requests are only interleaved in states, where the slave can process
+ * them.
+ *
+ * \return Non-zero, if SDO requests are waiting.
+ */
+static int ec_fsm_slave_foe_yield(
+        const ec_fsm_slave_t *fsm /**< Slave state machine. */
+        )
+{
+    const ec_slave_t *slave = fsm->slave;
+
+    switch (slave->current_state) {
+    case EC_SLAVE_STATE_PREOP:
+    case EC_SLAVE_STATE_SAFEOP:
+    case EC_SLAVE_STATE_OP:
+        return !list_empty(&slave->sdo_requests);
+    default:
+        return 0;
+    }
+}
+
+/*****************************************************************************/
+
 /** Slave state: FOE REQUEST.
  */
 void ec_fsm_slave_state_foe_request(
         ec_fsm_slave_t *fsm, /**< Slave state machine. */
         ec_datagram_t *datagram /**< Datagram to use. */
         )
+{
+    // interleave pending SDO requests with the packets of a file transfer
+    if (ec_fsm_foe_paused(&fsm->fsm_foe) && ec_fsm_slave_foe_yield(fsm) &&
+            ec_fsm_slave_action_process_sdo(fsm, datagram)) {
+        return;
+    }
+
+    ec_fsm_slave_exec_foe(fsm, datagram);
+}
+
+/*****************************************************************************/
+
+/** Executes the FoE state machine of the request in progress.
+ */
+void ec_fsm_slave_exec_foe(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
 {
     ec_slave_t *slave = fsm->slave;
     ec_foe_request_t *request = fsm->foe_request;
 
+    fsm->fsm_foe.yield = ec_fsm_slave_foe_yield(fsm);
+
     if (ec_fsm_foe_exec(&fsm->fsm_foe, datagram)) {
         return;
     }
@@ -67,8 +67,11 @@ struct ec_fsm_slave {
 
     void (*state)(ec_fsm_slave_t *, ec_datagram_t *); /**< State function. */
     ec_datagram_t *datagram; /**< Previous state datagram. */
+    unsigned int mbox_action; /**< Next mailbox request type to serve. */
     ec_sdo_request_t *sdo_request; /**< SDO request to process. */
     ec_reg_request_t *reg_request; /**< Register request to process. */
+    ec_datagram_t *reg_datagram; /**< Datagram of the register request in
+                                   progress. */
     ec_foe_request_t *foe_request; /**< FoE request to process. */
     off_t foe_index; /**< Index to FoE write request data. */
     ec_soe_request_t *soe_request; /**< SoE request to process. */
@@ -97,6 +100,8 @@ void ec_fsm_slave_init(ec_fsm_slave_t *, ec_slave_t *);
 void ec_fsm_slave_clear(ec_fsm_slave_t *);
 
 int ec_fsm_slave_exec(ec_fsm_slave_t *, ec_datagram_t *);
+int ec_fsm_slave_reg_pending(const ec_fsm_slave_t *);
+int ec_fsm_slave_exec_reg(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_set_ready(ec_fsm_slave_t *);
 int ec_fsm_slave_set_unready(ec_fsm_slave_t *);
 int ec_fsm_slave_is_ready(const ec_fsm_slave_t *);
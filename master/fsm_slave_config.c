@@ -68,6 +68,7 @@ void ec_fsm_slave_config_state_clear_fmmus(ec_fsm_slave_config_t *, ec_datagram_
 void ec_fsm_slave_config_state_clear_sync(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_state_dc_clear_assign(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_state_mbox_sync(ec_fsm_slave_config_t *, ec_datagram_t *);
+void ec_fsm_slave_config_state_mbox_status(ec_fsm_slave_config_t *, ec_datagram_t *);
 #ifdef EC_SII_ASSIGN
 void ec_fsm_slave_config_state_assign_pdi(ec_fsm_slave_config_t *, ec_datagram_t *);
 #endif
@@ -94,6 +95,7 @@ void ec_fsm_slave_config_enter_init(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_clear_sync(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_dc_clear_assign(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_mbox_sync(ec_fsm_slave_config_t *, ec_datagram_t *);
+void ec_fsm_slave_config_enter_mbox_status(ec_fsm_slave_config_t *, ec_datagram_t *);
 #ifdef EC_SII_ASSIGN
 void ec_fsm_slave_config_enter_assign_pdi(ec_fsm_slave_config_t *, ec_datagram_t *);
 #endif
@@ -290,6 +292,9 @@ void ec_fsm_slave_config_state_init(
 
     EC_SLAVE_DBG(slave, 1, "Now in INIT.\n");
 
+    // the FMMUs are cleared below
+    ec_slave_mbox_status_set_mapped(slave, 0);
+
     if (!slave->base_fmmu_count) { // skip FMMU configuration
         ec_fsm_slave_config_enter_clear_sync(fsm, datagram);
         return;
@@ -664,6 +669,71 @@ void ec_fsm_slave_config_state_mbox_sync(
         return;
     }
 
+    ec_fsm_slave_config_enter_mbox_status(fsm, datagram);
+}
+
+/*****************************************************************************/
+
+/** Map the mailbox status into the mailbox status area.
+ *
+ * This lets the master check the mailboxes of all slaves with a single
+ * datagram. A spare FMMU is needed.
+ */
+void ec_fsm_slave_config_enter_mbox_status(
+        ec_fsm_slave_config_t *fsm, /**< slave state machine */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    int fmmu_index = ec_slave_mbox_status_fmmu(slave);
+
+    if (slave->requested_state == EC_SLAVE_STATE_BOOT || fmmu_index < 0) {
+#ifdef EC_SII_ASSIGN
+        ec_fsm_slave_config_enter_assign_pdi(fsm, datagram);
+#else
+        ec_fsm_slave_config_enter_boot_preop(fsm, datagram);
+#endif
+        return;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Mapping mailbox status with FMMU %i...\n",
+            fmmu_index);
+
+    ec_datagram_fpwr(datagram, slave->station_address,
+            0x0600 + EC_FMMU_PAGE_SIZE * fmmu_index, EC_FMMU_PAGE_SIZE);
+    ec_slave_mbox_status_page(slave, datagram->data);
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_slave_config_state_mbox_status;
+}
+
+/*****************************************************************************/
+
+/** Slave configuration state: MBOX STATUS.
+ */
+void ec_fsm_slave_config_state_mbox_status(
+        ec_fsm_slave_config_t *fsm, /**< slave state machine */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (fsm->datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        ec_datagram_repeat(datagram, fsm->datagram);
+        return;
+    }
+
+    if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
+        EC_SLAVE_WARN(slave, "Failed to receive mailbox status"
+                " mapping datagram: ");
+        ec_datagram_print_state(fsm->datagram);
+    } else if (fsm->datagram->working_counter != 1) {
+        EC_SLAVE_WARN(slave, "Failed to map mailbox status: ");
+        ec_datagram_print_wc_error(fsm->datagram);
+    } else {
+        ec_slave_mbox_status_set_mapped(slave, 1);
+    }
+
+    // the mailbox is checked per slave, if the mapping failed
 #ifdef EC_SII_ASSIGN
     ec_fsm_slave_config_enter_assign_pdi(fsm, datagram);
 #else
@@ -1338,6 +1408,17 @@ void ec_fsm_slave_config_enter_fmmu(
                 datagram->data + EC_FMMU_PAGE_SIZE * i);
     }
 
+    // keep the mailbox status mapping, unless the FMMU is needed now
+    if (slave->mbox_status_mapped) {
+        int fmmu_index = ec_slave_mbox_status_fmmu(slave);
+        if (fmmu_index >= 0) {
+            ec_slave_mbox_status_page(slave,
+                    datagram->data + EC_FMMU_PAGE_SIZE * fmmu_index);
+        } else {
+            ec_slave_mbox_status_set_mapped(slave, 0);
+        }
+    }
+
     fsm->retries = EC_FSM_RETRIES;
     fsm->state = ec_fsm_slave_config_state_fmmu;
 }
@@ -65,6 +65,7 @@ void ec_fsm_slave_scan_state_assign_sii(ec_fsm_slave_scan_t *, ec_datagram_t *);
 #endif
 #ifdef EC_SII_CACHE
 void ec_fsm_slave_scan_state_sii_identity(ec_fsm_slave_scan_t *, ec_datagram_t *);
+void ec_fsm_slave_scan_state_sii_cache(ec_fsm_slave_scan_t *, ec_datagram_t *);
 #endif
 #ifdef EC_SII_OVERRIDE
 void ec_fsm_slave_scan_state_sii_device(ec_fsm_slave_scan_t *, ec_datagram_t *);
@@ -92,6 +93,7 @@ void ec_fsm_slave_scan_enter_regalias(ec_fsm_slave_scan_t *, ec_datagram_t *);
 #endif
 #ifdef EC_SII_CACHE
 void ec_fsm_slave_scan_enter_sii_identity(ec_fsm_slave_scan_t *, ec_datagram_t *);
+void ec_fsm_slave_scan_enter_sii_cache(ec_fsm_slave_scan_t *, ec_datagram_t *);
 #endif
 #ifdef EC_SII_OVERRIDE
 void ec_fsm_slave_scan_enter_sii_request(ec_fsm_slave_scan_t *, ec_datagram_t *);
@@ -606,6 +608,12 @@ void ec_fsm_slave_scan_enter_attach_sii(
         // Store the SII image for later re-use
         list_add_tail(&sii_image->list, &slave->master->sii_images);
 
+#ifdef EC_SII_CACHE
+        if (ec_sii_cache_find(slave->master, slave)) {
+            ec_fsm_slave_scan_enter_sii_cache(fsm, datagram);
+            return;
+        }
+#endif
         ec_fsm_slave_scan_enter_sii_size(fsm, datagram);
     }
 }
@@ -842,6 +850,117 @@ void ec_fsm_slave_scan_state_sii_identity(
                 EC_FSM_SII_USE_CONFIGURED_ADDRESS);
     }
 }
+
+/*****************************************************************************/
+
+/** Enter slave scan state SII_CACHE.
+ *
+ * A persistent SII cache entry matches the identity of the slave. Read the
+ * leading SII words to verify it.
+ */
+void ec_fsm_slave_scan_enter_sii_cache(
+        ec_fsm_slave_scan_t *fsm, /**< slave state machine */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    EC_SLAVE_DBG(fsm->slave, 1, "Verifying persistent SII cache entry.\n");
+
+    fsm->sii_offset = 0x0000;
+    ec_fsm_sii_read(&fsm->fsm_sii, fsm->slave, fsm->sii_offset,
+            EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+    fsm->state = ec_fsm_slave_scan_state_sii_cache;
+    fsm->state(fsm, datagram); // execute state immediately
+}
+
+/*****************************************************************************/
+
+/**
+   Slave scan state: SII CACHE.
+*/
+
+void ec_fsm_slave_scan_state_sii_cache(
+        ec_fsm_slave_scan_t *fsm, /**< slave state machine */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    const ec_sii_cache_entry_t *entry;
+
+    if (ec_fsm_sii_exec(&fsm->fsm_sii, datagram))
+        return;
+
+    if (!ec_fsm_sii_success(&fsm->fsm_sii)) {
+        EC_SLAVE_WARN(slave, "Failed to verify persistent SII cache entry."
+                " Reading SII contents.\n");
+        ec_fsm_slave_scan_enter_sii_size(fsm, datagram);
+        return;
+    }
+
+    // 2 or 4 words fetched; the offsets stay aligned to the read size
+    memcpy(fsm->sii_cache_words + fsm->sii_offset, fsm->fsm_sii.value,
+            fsm->fsm_sii.value_size);
+
+    if (fsm->sii_offset + fsm->fsm_sii.value_size / 2
+            < EC_SII_CACHE_CRC_WORDS) {
+        // fetch the next words
+        fsm->sii_offset += fsm->fsm_sii.value_size / 2;
+        ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_offset,
+                        EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+        ec_fsm_sii_exec(&fsm->fsm_sii, datagram); // execute state immediately
+        return;
+    }
+
+    // the entry is looked up again, as the cache may have been reloaded
+    entry = ec_sii_cache_lookup(slave->master, fsm->sii_cache_words);
+    if (!entry) {
+        EC_SLAVE_DBG(slave, 1, "Persistent SII cache entry does not match."
+                " Reading SII contents.\n");
+        ec_fsm_slave_scan_enter_sii_size(fsm, datagram);
+        return;
+    }
+
+    if (slave->sii_image->words) {
+        kfree(slave->sii_image->words);
+    }
+
+    if (!(slave->sii_image->words =
+                (uint16_t *) kmalloc(entry->nwords * 2, GFP_KERNEL))) {
+        EC_SLAVE_ERR(slave, "Failed to allocate %zu words of SII data.\n",
+               entry->nwords);
+        slave->sii_image->nwords = 0;
+        slave->error_flag = 1;
+        fsm->state = ec_fsm_slave_scan_state_error;
+        return;
+    }
+
+    memcpy(slave->sii_image->words, entry->words, entry->nwords * 2);
+    slave->sii_image->nwords = entry->nwords;
+
+    EC_SLAVE_DBG(slave, 1, "Using %zu words of SII data from the persistent"
+            " SII cache.\n", entry->nwords);
+
+#ifdef EC_SII_OVERRIDE
+    // the identity is not evaluated when parsing overridden SII data
+    slave->sii_image->sii.alias =
+        EC_READ_U16(slave->sii_image->words + EC_ALIAS_SII_OFFSET);
+    slave->effective_alias = slave->sii_image->sii.alias;
+    slave->sii_image->sii.vendor_id =
+        EC_READ_U32(slave->sii_image->words + EC_VENDOR_SII_OFFSET);
+    slave->sii_image->sii.product_code =
+        EC_READ_U32(slave->sii_image->words + EC_PRODUCT_SII_OFFSET);
+    slave->sii_image->sii.revision_number =
+        EC_READ_U32(slave->sii_image->words + EC_REVISION_SII_OFFSET);
+    slave->sii_image->sii.serial_number =
+        EC_READ_U32(slave->sii_image->words + EC_SERIAL_SII_OFFSET);
+    slave->effective_vendor_id = slave->sii_image->sii.vendor_id;
+    slave->effective_product_code = slave->sii_image->sii.product_code;
+    slave->effective_revision_number = slave->sii_image->sii.revision_number;
+    slave->effective_serial_number = slave->sii_image->sii.serial_number;
+#endif
+
+    fsm->state = ec_fsm_slave_scan_state_sii_parse;
+    fsm->state(fsm, datagram); // execute state immediately
+}
 #endif
 
 #ifdef EC_SII_OVERRIDE
@@ -874,11 +993,12 @@ void ec_fsm_slave_scan_state_sii_device(
         return;
     }
 
-    memcpy(slave->vendor_words + fsm->sii_offset, fsm->fsm_sii.value, 4);
+    memcpy(slave->vendor_words + fsm->sii_offset, fsm->fsm_sii.value,
+            fsm->fsm_sii.value_size);
 
-    if (fsm->sii_offset + 2 < 16) {
-        // fetch the next 2 words
-        fsm->sii_offset += 2;
+    if (fsm->sii_offset + fsm->fsm_sii.value_size / 2 < 16) {
+        // fetch the next words
+        fsm->sii_offset += fsm->fsm_sii.value_size / 2;
         ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_offset,
                         EC_FSM_SII_USE_CONFIGURED_ADDRESS);
         ec_fsm_sii_exec(&fsm->fsm_sii, datagram); // execute state immediately
@@ -1150,6 +1270,7 @@ void ec_fsm_slave_scan_state_sii_data(
         )
 {
     ec_slave_t *slave = fsm->slave;
+    unsigned int words;
 
     if (ec_fsm_sii_exec(&fsm->fsm_sii, datagram)) return;
 
@@ -1171,17 +1292,18 @@ void ec_fsm_slave_scan_state_sii_data(
         return;
     }
 
-    // 2 words fetched
-
-    if (fsm->sii_offset + 2 <= slave->sii_image->nwords) { // 2 words fit
-        memcpy(slave->sii_image->words + fsm->sii_offset, fsm->fsm_sii.value, 4);
-    } else { // copy the last word
-        memcpy(slave->sii_image->words + fsm->sii_offset, fsm->fsm_sii.value, 2);
+    // 2 words fetched, or 4 words if the ESC supports 64 bit reads
+    words = fsm->fsm_sii.value_size / 2;
+    if (fsm->sii_offset + words > slave->sii_image->nwords) {
+        // copy only the remaining words
+        words = slave->sii_image->nwords - fsm->sii_offset;
     }
+    memcpy(slave->sii_image->words + fsm->sii_offset, fsm->fsm_sii.value,
+            words * 2);
 
-    if (fsm->sii_offset + 2 < slave->sii_image->nwords) {
-        // fetch the next 2 words
-        fsm->sii_offset += 2;
+    if (fsm->sii_offset + words < slave->sii_image->nwords) {
+        // fetch the next words
+        fsm->sii_offset += words;
         ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_offset,
                         EC_FSM_SII_USE_CONFIGURED_ADDRESS);
         ec_fsm_sii_exec(&fsm->fsm_sii, datagram); // execute state immediately
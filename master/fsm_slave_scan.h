@@ -44,6 +44,7 @@
 #include "fsm_change.h"
 #include "fsm_coe.h"
 #include "fsm_pdo.h"
+#include "sii_cache.h"
 
 /*****************************************************************************/
 
@@ -68,6 +69,11 @@ struct ec_fsm_slave_scan
 
     ec_fsm_sii_t fsm_sii; /**< SII state machine. */
 
+#ifdef EC_SII_CACHE
+    uint16_t sii_cache_words[EC_SII_CACHE_CRC_WORDS]; /**< Leading SII words
+                                                        to verify a persistent
+                                                        SII cache entry. */
+#endif
 #ifdef EC_SII_OVERRIDE
     const struct firmware *sii_firmware;
 #endif
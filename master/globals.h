@@ -37,11 +37,13 @@
 /** Datagram timeout in microseconds. */
 #define EC_IO_TIMEOUT 500
 
-/** Time to send a byte in nanoseconds.
+/** Default link speed in Mbit/s.
  *
- * t_ns = 1 / (100 MBit/s / 8 bit/byte) = 80 ns/byte
+ * The link speed determines the time to send a byte, which is
+ * t_ns = 1 / (100 MBit/s / 8 bit/byte) = 80 ns/byte by default. It can be
+ * changed with the link_speed module parameter.
  */
-#define EC_BYTE_TRANSMISSION_TIME_NS 80
+#define EC_DEFAULT_LINK_SPEED 100
 
 /** Number of state machine retries on datagram timeout. */
 #define EC_FSM_RETRIES 3
@@ -84,6 +86,15 @@
                           - EC_DATAGRAM_HEADER_SIZE - EC_DATAGRAM_FOOTER_SIZE)
 #endif // DEBUG_DATAGRAM_OVERFLOW
 
+/** Frame capture direction: Sent frames. */
+#define EC_PCAP_TX 0x01
+
+/** Frame capture direction: Received frames. */
+#define EC_PCAP_RX 0x02
+
+/** Frame capture datagram type mask matching all datagram types. */
+#define EC_PCAP_TYPES_ALL 0xffffffff
+
 /** Mailbox header size.  */
 #define EC_MBOX_HEADER_SIZE 6
 
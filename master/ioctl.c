@@ -41,6 +41,7 @@
 #include "slave_config.h"
 #include "voe_handler.h"
 #include "ethernet.h"
+#include "sii_cache.h"
 #include "ioctl.h"
 
 /** Set to 1 to enable ioctl() latency tracing.
@@ -194,8 +195,8 @@ static ATTRIBUTES int ec_ioctl_master(
     io.ref_clock =
         master->dc_ref_clock ? master->dc_ref_clock->ring_position : 0xffff;
 
-    if (master->pcap_data) {
-        io.pcap_size = sizeof(pcap_hdr_t) + pcap_size;
+    if (master->pcap.data) {
+        io.pcap_size = sizeof(pcap_hdr_t) + master->pcap.size;
     } else {
         io.pcap_size = 0;
     }
@@ -209,6 +210,104 @@ static ATTRIBUTES int ec_ioctl_master(
 
 /*****************************************************************************/
 
+/** Fills in slave information.
+ */
+static void ec_ioctl_fill_slave(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        ec_ioctl_slave_t *data /**< Slave information. */
+        )
+{
+    int i;
+
+    data->device_index = slave->device_index;
+    data->alias = slave->effective_alias;
+    if (slave->sii_image) {
+        data->vendor_id = slave->sii_image->sii.vendor_id;
+        data->product_code = slave->sii_image->sii.product_code;
+        data->revision_number = slave->sii_image->sii.revision_number;
+        data->serial_number = slave->sii_image->sii.serial_number;
+        data->boot_rx_mailbox_offset = slave->sii_image->sii.boot_rx_mailbox_offset;
+        data->boot_rx_mailbox_size = slave->sii_image->sii.boot_rx_mailbox_size;
+        data->boot_tx_mailbox_offset = slave->sii_image->sii.boot_tx_mailbox_offset;
+        data->boot_tx_mailbox_size = slave->sii_image->sii.boot_tx_mailbox_size;
+        data->std_rx_mailbox_offset = slave->sii_image->sii.std_rx_mailbox_offset;
+        data->std_rx_mailbox_size = slave->sii_image->sii.std_rx_mailbox_size;
+        data->std_tx_mailbox_offset = slave->sii_image->sii.std_tx_mailbox_offset;
+        data->std_tx_mailbox_size = slave->sii_image->sii.std_tx_mailbox_size;
+        data->mailbox_protocols = slave->sii_image->sii.mailbox_protocols;
+        data->has_general_category = slave->sii_image->sii.has_general;
+        data->coe_details = slave->sii_image->sii.coe_details;
+        data->general_flags = slave->sii_image->sii.general_flags;
+        data->current_on_ebus = slave->sii_image->sii.current_on_ebus;
+        data->sync_count = slave->sii_image->sii.sync_count;
+        data->sii_nwords = slave->sii_image->nwords;
+        ec_ioctl_strcpy(data->group, slave->sii_image->sii.group);
+        ec_ioctl_strcpy(data->image, slave->sii_image->sii.image);
+        ec_ioctl_strcpy(data->order, slave->sii_image->sii.order);
+        ec_ioctl_strcpy(data->name, slave->sii_image->sii.name);
+    }
+    else {
+        data->vendor_id = 0x00000000;
+        data->product_code = 0x00000000;
+        data->revision_number = 0x00000000;
+        data->serial_number = 0x00000000;
+        data->boot_rx_mailbox_offset = 0x0000;
+        data->boot_rx_mailbox_size = 0x0000;
+        data->boot_tx_mailbox_offset = 0x0000;
+        data->boot_tx_mailbox_size = 0x0000;
+        data->std_rx_mailbox_offset = 0x0000;
+        data->std_rx_mailbox_size = 0x0000;
+        data->std_tx_mailbox_offset = 0x0000;
+        data->std_tx_mailbox_size = 0x0000;
+        data->mailbox_protocols = 0;
+        data->has_general_category = 0;
+        data->coe_details.enable_pdo_assign = 0;
+        data->coe_details.enable_pdo_configuration = 0;
+        data->coe_details.enable_sdo = 0;
+        data->coe_details.enable_sdo_complete_access = 0;
+        data->coe_details.enable_sdo_info = 0;
+        data->coe_details.enable_upload_at_startup = 0;
+        data->general_flags.enable_not_lrw = 0;
+        data->general_flags.enable_safeop = 0;
+        data->sync_count = 0;
+        data->sii_nwords = 0;
+        ec_ioctl_strcpy(data->group, "");
+        ec_ioctl_strcpy(data->image, "");
+        ec_ioctl_strcpy(data->order, "");
+        ec_ioctl_strcpy(data->name, "");
+    }
+
+    for (i = 0; i < EC_MAX_PORTS; i++) {
+        data->ports[i].desc = slave->ports[i].desc;
+        data->ports[i].link.link_up = slave->ports[i].link.link_up;
+        data->ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
+        data->ports[i].link.signal_detected =
+            slave->ports[i].link.signal_detected;
+        data->ports[i].link.bypassed = slave->ports[i].link.bypassed;
+        data->ports[i].receive_time = slave->ports[i].receive_time;
+        if (slave->ports[i].next_slave) {
+            data->ports[i].next_slave =
+                slave->ports[i].next_slave->ring_position;
+        } else {
+            data->ports[i].next_slave = 0xffff;
+        }
+        data->ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
+    }
+    data->upstream_port = slave->upstream_port;
+    data->fmmu_bit = slave->base_fmmu_bit_operation;
+    data->dc_supported = slave->base_dc_supported;
+    data->dc_range = slave->base_dc_range;
+    data->has_dc_system_time = slave->has_dc_system_time;
+    data->transmission_delay = slave->transmission_delay;
+    data->al_state = slave->current_state;
+    data->error_flag = slave->error_flag;
+    data->scan_required = slave->scan_required;
+    data->sdo_count = ec_slave_sdo_count(slave);
+    data->ready = ec_fsm_slave_is_ready(&slave->fsm);
+}
+
+/*****************************************************************************/
+
 /** Get slave information.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -220,7 +319,6 @@ static ATTRIBUTES int ec_ioctl_slave(
 {
     ec_ioctl_slave_t data;
     const ec_slave_t *slave;
-    int i;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
@@ -236,91 +334,7 @@ static ATTRIBUTES int ec_ioctl_slave(
         return -EINVAL;
     }
 
-    data.device_index = slave->device_index;
-    data.alias = slave->effective_alias;
-    if (slave->sii_image) {
-        data.vendor_id = slave->sii_image->sii.vendor_id;
-        data.product_code = slave->sii_image->sii.product_code;
-        data.revision_number = slave->sii_image->sii.revision_number;
-        data.serial_number = slave->sii_image->sii.serial_number;
-        data.boot_rx_mailbox_offset = slave->sii_image->sii.boot_rx_mailbox_offset;
-        data.boot_rx_mailbox_size = slave->sii_image->sii.boot_rx_mailbox_size;
-        data.boot_tx_mailbox_offset = slave->sii_image->sii.boot_tx_mailbox_offset;
-        data.boot_tx_mailbox_size = slave->sii_image->sii.boot_tx_mailbox_size;
-        data.std_rx_mailbox_offset = slave->sii_image->sii.std_rx_mailbox_offset;
-        data.std_rx_mailbox_size = slave->sii_image->sii.std_rx_mailbox_size;
-        data.std_tx_mailbox_offset = slave->sii_image->sii.std_tx_mailbox_offset;
-        data.std_tx_mailbox_size = slave->sii_image->sii.std_tx_mailbox_size;
-        data.mailbox_protocols = slave->sii_image->sii.mailbox_protocols;
-        data.has_general_category = slave->sii_image->sii.has_general;
-        data.coe_details = slave->sii_image->sii.coe_details;
-        data.general_flags = slave->sii_image->sii.general_flags;
-        data.current_on_ebus = slave->sii_image->sii.current_on_ebus;
-        data.sync_count = slave->sii_image->sii.sync_count;
-        data.sii_nwords = slave->sii_image->nwords;
-        ec_ioctl_strcpy(data.group, slave->sii_image->sii.group);
-        ec_ioctl_strcpy(data.image, slave->sii_image->sii.image);
-        ec_ioctl_strcpy(data.order, slave->sii_image->sii.order);
-        ec_ioctl_strcpy(data.name, slave->sii_image->sii.name);
-    }
-    else {
-        data.vendor_id = 0x00000000;
-        data.product_code = 0x00000000;
-        data.revision_number = 0x00000000;
-        data.serial_number = 0x00000000;
-        data.boot_rx_mailbox_offset = 0x0000;
-        data.boot_rx_mailbox_size = 0x0000;
-        data.boot_tx_mailbox_offset = 0x0000;
-        data.boot_tx_mailbox_size = 0x0000;
-        data.std_rx_mailbox_offset = 0x0000;
-        data.std_rx_mailbox_size = 0x0000;
-        data.std_tx_mailbox_offset = 0x0000;
-        data.std_tx_mailbox_size = 0x0000;
-        data.mailbox_protocols = 0;
-        data.has_general_category = 0;
-        data.coe_details.enable_pdo_assign = 0;
-        data.coe_details.enable_pdo_configuration = 0;
-        data.coe_details.enable_sdo = 0;
-        data.coe_details.enable_sdo_complete_access = 0;
-        data.coe_details.enable_sdo_info = 0;
-        data.coe_details.enable_upload_at_startup = 0;
-        data.general_flags.enable_not_lrw = 0;
-        data.general_flags.enable_safeop = 0;
-        data.sync_count = 0;
-        data.sii_nwords = 0;
-        ec_ioctl_strcpy(data.group, "");
-        ec_ioctl_strcpy(data.image, "");
-        ec_ioctl_strcpy(data.order, "");
-        ec_ioctl_strcpy(data.name, "");
-    }
-
-    for (i = 0; i < EC_MAX_PORTS; i++) {
-        data.ports[i].desc = slave->ports[i].desc;
-        data.ports[i].link.link_up = slave->ports[i].link.link_up;
-        data.ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
-        data.ports[i].link.signal_detected =
-            slave->ports[i].link.signal_detected;
-        data.ports[i].link.bypassed = slave->ports[i].link.bypassed;
-        data.ports[i].receive_time = slave->ports[i].receive_time;
-        if (slave->ports[i].next_slave) {
-            data.ports[i].next_slave =
-                slave->ports[i].next_slave->ring_position;
-        } else {
-            data.ports[i].next_slave = 0xffff;
-        }
-        data.ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
-    }
-    data.upstream_port = slave->upstream_port;
-    data.fmmu_bit = slave->base_fmmu_bit_operation;
-    data.dc_supported = slave->base_dc_supported;
-    data.dc_range = slave->base_dc_range;
-    data.has_dc_system_time = slave->has_dc_system_time;
-    data.transmission_delay = slave->transmission_delay;
-    data.al_state = slave->current_state;
-    data.error_flag = slave->error_flag;
-    data.scan_required = slave->scan_required;
-    data.sdo_count = ec_slave_sdo_count(slave);
-    data.ready = ec_fsm_slave_is_ready(&slave->fsm);
+    ec_ioctl_fill_slave(slave, &data);
 
     ec_lock_up(&master->master_sem);
 
@@ -543,6 +557,180 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
 
 /*****************************************************************************/
 
+/** Serializes the slaves, sync managers, PDOs and PDO entries.
+ *
+ * With \a data being NULL, only the numbers are counted.
+ *
+ * \return Snapshot size in bytes.
+ */
+static size_t ec_ioctl_topology_fill(
+        const ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_topology_header_t *header, /**< Header. */
+        uint8_t *data /**< Snapshot memory, or NULL. */
+        )
+{
+    const ec_slave_t *slave;
+    const ec_sync_t *sync;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    ec_ioctl_slave_t *s = NULL;
+    ec_ioctl_slave_sync_t *sy = NULL;
+    ec_ioctl_slave_sync_pdo_t *p = NULL;
+    ec_ioctl_slave_sync_pdo_entry_t *e = NULL;
+    unsigned int i, pdo_pos, entry_pos;
+
+    if (data) {
+        memcpy(data, header, sizeof(*header));
+        s = (ec_ioctl_slave_t *) (data + sizeof(*header));
+        sy = (ec_ioctl_slave_sync_t *) (s + header->slave_count);
+        p = (ec_ioctl_slave_sync_pdo_t *) (sy + header->sync_count);
+        e = (ec_ioctl_slave_sync_pdo_entry_t *) (p + header->pdo_count);
+    } else {
+        memset(header, 0, sizeof(*header));
+        header->version = EC_IOCTL_TOPOLOGY_VERSION;
+        header->slave_count = master->slave_count;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (data) {
+            s->position = slave->ring_position;
+            ec_ioctl_fill_slave(slave, s++);
+        }
+
+        if (!slave->sii_image) {
+            continue;
+        }
+
+        for (i = 0; i < slave->sii_image->sii.sync_count; i++) {
+            sync = &slave->sii_image->sii.syncs[i];
+
+            if (data) {
+                sy->slave_position = slave->ring_position;
+                sy->sync_index = i;
+                sy->physical_start_address = sync->physical_start_address;
+                sy->default_size = sync->default_length;
+                sy->control_register = sync->control_register;
+                sy->enable = sync->enable;
+                sy->pdo_count = ec_pdo_list_count(&sync->pdos);
+                sy++;
+            } else {
+                header->sync_count++;
+            }
+
+            pdo_pos = 0;
+            list_for_each_entry(pdo, &sync->pdos.list, list) {
+                if (data) {
+                    p->slave_position = slave->ring_position;
+                    p->sync_index = i;
+                    p->pdo_pos = pdo_pos;
+                    p->index = pdo->index;
+                    p->entry_count = ec_pdo_entry_count(pdo);
+                    ec_ioctl_strcpy(p->name, pdo->name);
+                    p++;
+                } else {
+                    header->pdo_count++;
+                }
+
+                entry_pos = 0;
+                list_for_each_entry(entry, &pdo->entries, list) {
+                    if (data) {
+                        e->slave_position = slave->ring_position;
+                        e->sync_index = i;
+                        e->pdo_pos = pdo_pos;
+                        e->entry_pos = entry_pos;
+                        e->index = entry->index;
+                        e->subindex = entry->subindex;
+                        e->bit_length = entry->bit_length;
+                        ec_ioctl_strcpy(e->name, entry->name);
+                        e++;
+                    } else {
+                        header->entry_count++;
+                    }
+                    entry_pos++;
+                }
+                pdo_pos++;
+            }
+        }
+    }
+
+    return sizeof(*header)
+        + header->slave_count * sizeof(ec_ioctl_slave_t)
+        + header->sync_count * sizeof(ec_ioctl_slave_sync_t)
+        + header->pdo_count * sizeof(ec_ioctl_slave_sync_pdo_t)
+        + header->entry_count * sizeof(ec_ioctl_slave_sync_pdo_entry_t);
+}
+
+/*****************************************************************************/
+
+/** Get a snapshot of all slaves, sync managers, PDOs and PDO entries.
+ *
+ * Replaces the single requests of EC_IOCTL_SLAVE, EC_IOCTL_SLAVE_SYNC,
+ * EC_IOCTL_SLAVE_SYNC_PDO and EC_IOCTL_SLAVE_SYNC_PDO_ENTRY, taking the master
+ * semaphore only once. If the given size is too small, only the required
+ * size is returned.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_topology(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_topology_t io;
+    ec_ioctl_topology_header_t header;
+    uint8_t *data = NULL;
+    size_t size;
+    int ret = 0;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (io.version != EC_IOCTL_TOPOLOGY_VERSION) {
+        EC_MASTER_ERR(master, "Unsupported topology format version %u.\n",
+                io.version);
+        return -EINVAL;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    size = ec_ioctl_topology_fill(master, &header, NULL);
+
+    if (io.data && io.size >= size) {
+        if (!(data = vmalloc(size))) {
+            ec_lock_up(&master->master_sem);
+            return -ENOMEM;
+        }
+        memset(data, 0, size);
+        ec_ioctl_topology_fill(master, &header, data);
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (data) {
+        if (copy_to_user((void __user *) io.data, data, size)) {
+            ret = -EFAULT;
+        }
+        vfree(data);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    io.size = size;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Get domain information.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -686,6 +874,9 @@ static ATTRIBUTES int ec_ioctl_domain_data(
 /*****************************************************************************/
 
 /** Get pcap data.
+ *
+ * Copies the records since the last reset, that are still in the capture
+ * ring.
  *
  * \return Zero on success, otherwise a negative error code.
  */
@@ -696,11 +887,11 @@ static ATTRIBUTES int ec_ioctl_pcap_data(
 {
     ec_ioctl_pcap_data_t data;
     pcap_hdr_t pcaphdr;
-    size_t data_size;
-    size_t total_size;
-    void *curr_data;
+    unsigned long pos, lost;
+    size_t copied;
+    int ret;
 
-    if (!master->pcap_data) {
+    if (!master->pcap.data) {
         return -EOPNOTSUPP;
     }
 
@@ -708,52 +899,143 @@ static ATTRIBUTES int ec_ioctl_pcap_data(
         return -EFAULT;
     }
 
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    curr_data = master->pcap_curr_data;
-    data_size = curr_data - master->pcap_data;
-    total_size = sizeof(pcap_hdr_t) + data_size;
     if (data.data_size < sizeof(pcap_hdr_t)) {
-        ec_lock_up(&master->master_sem);
         EC_MASTER_ERR(master, "Pcap data size too small %u/%zu!\n",
                 data.data_size, sizeof(pcap_hdr_t));
         return -EFAULT;
     }
-    if (data.data_size > total_size) {
-        data.data_size = total_size;
-    }
-    
+
     // fill in pcap header and copy to user mem
-    pcaphdr.magic_number = 0xa1b2c3d4;
-    pcaphdr.version_major = 2;
-    pcaphdr.version_minor = 4;
-    pcaphdr.thiszone = 0;
-    pcaphdr.sigfigs = 0;
-    pcaphdr.snaplen = 65535;
-    pcaphdr.network = 1;
+    ec_pcap_header(&master->pcap, &pcaphdr);
     if (copy_to_user((void __user *) data.target, &pcaphdr,
                 sizeof(pcap_hdr_t))) {
-        ec_lock_up(&master->master_sem);
         return -EFAULT;
     }
-    
-    // copy pcap data, up to requested size; also copy updated data_size
-    if ( (data_size > 0) &&
-         (copy_to_user((void __user *) (data.target + sizeof(pcap_hdr_t)),
-                master->pcap_data, data.data_size - sizeof(pcap_hdr_t)) ||
-          copy_to_user((void __user *) arg, &data, sizeof(data)))) {
-        ec_lock_up(&master->master_sem);
+
+    // copy complete records, up to requested size
+    pos = READ_ONCE(master->pcap.start);
+    ret = ec_pcap_read(&master->pcap, &pos,
+            (u8 __user *) data.target + sizeof(pcap_hdr_t),
+            data.data_size - sizeof(pcap_hdr_t), &copied, &lost);
+    if (ret == -ENOSPC) {
+        copied = 0;
+    } else if (ret) {
+        return ret;
+    }
+
+    data.data_size = sizeof(pcap_hdr_t) + copied;
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
     }
-    
+
     // remove copied data?
-    // Note: will remove any data that has not been copied
     if (data.reset_data) {
-        master->pcap_curr_data = master->pcap_data;
+        WRITE_ONCE(master->pcap.start, pos);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get or set the frame capture filters.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_pcap_config(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< Userspace address to store the results. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_pcap_config_t io;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (io.set) {
+        if (!ctx->writable) {
+            return -EPERM;
+        }
+        WRITE_ONCE(master->pcap.snaplen, io.snaplen);
+        WRITE_ONCE(master->pcap.directions, io.directions);
+        WRITE_ONCE(master->pcap.types, io.types);
+    }
+
+    io.snaplen = master->pcap.snaplen;
+    io.directions = master->pcap.directions;
+    io.types = master->pcap.types;
+    io.size = master->pcap.size;
+    io.frames = master->pcap.frames;
+    io.filtered = master->pcap.filtered;
+    io.overwritten = master->pcap.overwritten;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Stream pcap records.
+ *
+ * Each file handle has its own position in the capture ring, starting at the
+ * oldest record. Unless \a nonblock is set, waits until records are
+ * available.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_pcap_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< Userspace address to store the results. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_pcap_read_t io;
+    unsigned long lost;
+    size_t copied;
+    long wait;
+    int ret;
+
+    if (!master->pcap.data) {
+        return -EOPNOTSUPP;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!ctx->pcap_streaming) {
+        ctx->pcap_pos = READ_ONCE(master->pcap.tail);
+        ctx->pcap_streaming = 1;
+    }
+
+    // the timeout catches a worker, that stopped before we started waiting
+    while (!io.nonblock && !ec_pcap_pending(&master->pcap, ctx->pcap_pos)) {
+        ec_pcap_watch(&master->pcap);
+        wait = wait_event_interruptible_timeout(master->pcap.wait,
+                ec_pcap_pending(&master->pcap, ctx->pcap_pos), HZ / 10);
+        if (wait < 0) {
+            return -EINTR;
+        }
+    }
+
+    ret = ec_pcap_read(&master->pcap, &ctx->pcap_pos, io.target, io.size,
+            &copied, &lost);
+    if (ret) {
+        return ret;
+    }
+
+    io.data_size = copied;
+    io.lost = min_t(unsigned long, lost, 0xffffffff);
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
     }
 
-    ec_lock_up(&master->master_sem);
     return 0;
 }
 
@@ -1486,80 +1768,277 @@ static ATTRIBUTES int ec_ioctl_slave_reg_readwrite(
 
 /*****************************************************************************/
 
-/** Get slave configuration information.
+/** Transfer register ranges of many slaves at once.
+ *
+ * All register requests are queued before waiting for any of them, so the
+ * slave FSMs process them concurrently and their datagrams share frames.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_config(
+static ATTRIBUTES int ec_ioctl_slave_reg_sweep(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_t data;
-    const ec_slave_config_t *sc;
-    uint8_t i;
+    ec_ioctl_slave_reg_sweep_t io;
+    ec_ioctl_reg_range_t ranges[EC_IOCTL_REG_SWEEP_MAX_RANGES];
+    size_t offsets[EC_IOCTL_REG_SWEEP_MAX_RANGES];
+    uint16_t *positions = NULL;
+    ec_reg_request_t *requests = NULL, *request;
+    uint8_t *success = NULL;
+    ec_slave_t *slave;
+    size_t stride = 0;
+    unsigned int i, j, count, initialized = 0;
+    int ret = 0;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
     }
 
-    if (ec_lock_down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config_const(
-                    master, data.config_index))) {
-        ec_lock_up(&master->master_sem);
-        EC_MASTER_ERR(master, "Slave config %u does not exist!\n",
-                data.config_index);
-        return -EINVAL;
+    if (!io.slave_count || !io.range_count) {
+        return 0;
     }
 
-    data.alias = sc->alias;
-    data.position = sc->position;
-    data.vendor_id = sc->vendor_id;
-    data.product_code = sc->product_code;
-    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
-        data.syncs[i].dir = sc->sync_configs[i].dir;
-        data.syncs[i].watchdog_mode = sc->sync_configs[i].watchdog_mode;
-        data.syncs[i].pdo_count =
-            ec_pdo_list_count(&sc->sync_configs[i].pdos);
-    }
-    data.watchdog_divider = sc->watchdog_divider;
-    data.watchdog_intervals = sc->watchdog_intervals;
-    data.sdo_count = ec_slave_config_sdo_count(sc);
-    data.idn_count = ec_slave_config_idn_count(sc);
-    data.flag_count = ec_slave_config_flag_count(sc);
-    data.slave_position = sc->slave ? sc->slave->ring_position : -1;
-    data.dc_assign_activate = sc->dc_assign_activate;
-    for (i = 0; i < EC_SYNC_SIGNAL_COUNT; i++) {
-        data.dc_sync[i] = sc->dc_sync[i];
+    if (io.range_count > EC_IOCTL_REG_SWEEP_MAX_RANGES
+            || io.slave_count > master->slave_count) {
+        return -EINVAL;
     }
 
-    ec_lock_up(&master->master_sem);
-
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+    if (copy_from_user(ranges, (void __user *) io.ranges,
+                io.range_count * sizeof(ec_ioctl_reg_range_t))) {
         return -EFAULT;
+    }
 
-    return 0;
-}
+    for (j = 0; j < io.range_count; j++) {
+        if (!ranges[j].size || ranges[j].size > EC_MAX_DATA_SIZE) {
+            return -EINVAL;
+        }
+        if (ranges[j].dir != EC_DIR_INPUT && ranges[j].dir != EC_DIR_OUTPUT
+                && ranges[j].dir != EC_DIR_BOTH) {
+            return -EINVAL;
+        }
+        if (ranges[j].dir != EC_DIR_INPUT && !ctx->writable) {
+            return -EPERM;
+        }
+        offsets[j] = stride;
+        stride += ranges[j].size;
+    }
 
-/*****************************************************************************/
+    count = io.slave_count * io.range_count;
 
-/** Get slave configuration PDO information.
- *
- * \return Zero on success, otherwise a negative error code.
- */
-static ATTRIBUTES int ec_ioctl_config_pdo(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
-        )
-{
-    ec_ioctl_config_pdo_t data;
-    const ec_slave_config_t *sc;
-    const ec_pdo_t *pdo;
+    if (!(positions = kmalloc(io.slave_count * sizeof(uint16_t),
+                    GFP_KERNEL))
+            || !(success = kzalloc(count, GFP_KERNEL))
+            || !(requests = vmalloc(count * sizeof(ec_reg_request_t)))) {
+        ret = -ENOMEM;
+        goto out_free;
+    }
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        return -EFAULT;
+    if (copy_from_user(positions, (void __user *) io.slave_positions,
+                io.slave_count * sizeof(uint16_t))) {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    for (i = 0; i < io.slave_count; i++) {
+        for (j = 0; j < io.range_count; j++) {
+            request = &requests[initialized];
+            ret = ec_reg_request_init(request, ranges[j].size);
+            if (ret) {
+                goto out_clear;
+            }
+            initialized++;
+
+            if (ranges[j].dir != EC_DIR_INPUT && copy_from_user(
+                        request->data, (void __user *)
+                        (io.data + i * stride + offsets[j]),
+                        ranges[j].size)) {
+                ret = -EFAULT;
+                goto out_clear;
+            }
+
+            switch (ranges[j].dir) {
+                case EC_DIR_OUTPUT:
+                    ecrt_reg_request_write(request, ranges[j].address,
+                            ranges[j].size);
+                    break;
+                case EC_DIR_BOTH:
+                    ecrt_reg_request_readwrite(request, ranges[j].address,
+                            ranges[j].size);
+                    break;
+                default:
+                    ecrt_reg_request_read(request, ranges[j].address,
+                            ranges[j].size);
+                    break;
+            }
+        }
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    // check all slaves before scheduling any request
+    for (i = 0; i < io.slave_count; i++) {
+        if (!ec_master_find_slave(master, 0, positions[i])) {
+            ec_lock_up(&master->master_sem);
+            EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                    positions[i]);
+            ret = -EINVAL;
+            goto out_clear;
+        }
+    }
+
+    // schedule requests
+    for (i = 0; i < io.slave_count; i++) {
+        slave = ec_master_find_slave(master, 0, positions[i]);
+        for (j = 0; j < io.range_count; j++) {
+            request = &requests[i * io.range_count + j];
+            list_add_tail(&request->list, &slave->reg_requests);
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    // wait for processing through the slave FSMs
+    for (i = 0; i < count; i++) {
+        if (wait_event_interruptible(master->request_queue,
+                    requests[i].state != EC_INT_REQUEST_QUEUED)) {
+            // interrupted by signal; abort the requests not yet started
+            ec_lock_down(&master->master_sem);
+            for (j = 0; j < count; j++) {
+                if (requests[j].state == EC_INT_REQUEST_QUEUED) {
+                    list_del(&requests[j].list);
+                    requests[j].state = EC_INT_REQUEST_FAILURE;
+                }
+            }
+            ec_lock_up(&master->master_sem);
+            ret = -EINTR;
+            break;
+        }
+    }
+
+    // wait until the slave FSMs have finished processing
+    for (i = 0; i < count; i++) {
+        wait_event(master->request_queue,
+                requests[i].state != EC_INT_REQUEST_BUSY);
+    }
+
+    if (ret) {
+        goto out_clear;
+    }
+
+    for (i = 0; i < io.slave_count; i++) {
+        for (j = 0; j < io.range_count; j++) {
+            request = &requests[i * io.range_count + j];
+            if (request->state != EC_INT_REQUEST_SUCCESS) {
+                continue;
+            }
+            success[i * io.range_count + j] = 1;
+            if (ranges[j].dir != EC_DIR_OUTPUT && copy_to_user(
+                        (void __user *) (io.data + i * stride + offsets[j]),
+                        request->data, ranges[j].size)) {
+                ret = -EFAULT;
+                goto out_clear;
+            }
+        }
+    }
+
+    if (copy_to_user((void __user *) io.success, success, count)) {
+        ret = -EFAULT;
+    }
+
+out_clear:
+    for (i = 0; i < initialized; i++) {
+        ec_reg_request_clear(&requests[i]);
+    }
+out_free:
+    if (requests) {
+        vfree(requests);
+    }
+    kfree(success);
+    kfree(positions);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Get slave configuration information.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_config(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_config_t data;
+    const ec_slave_config_t *sc;
+    uint8_t i;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(sc = ec_master_get_config_const(
+                    master, data.config_index))) {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave config %u does not exist!\n",
+                data.config_index);
+        return -EINVAL;
+    }
+
+    data.alias = sc->alias;
+    data.position = sc->position;
+    data.vendor_id = sc->vendor_id;
+    data.product_code = sc->product_code;
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        data.syncs[i].dir = sc->sync_configs[i].dir;
+        data.syncs[i].watchdog_mode = sc->sync_configs[i].watchdog_mode;
+        data.syncs[i].pdo_count =
+            ec_pdo_list_count(&sc->sync_configs[i].pdos);
+    }
+    data.watchdog_divider = sc->watchdog_divider;
+    data.watchdog_intervals = sc->watchdog_intervals;
+    data.sdo_count = ec_slave_config_sdo_count(sc);
+    data.idn_count = ec_slave_config_idn_count(sc);
+    data.flag_count = ec_slave_config_flag_count(sc);
+    data.slave_position = sc->slave ? sc->slave->ring_position : -1;
+    data.dc_assign_activate = sc->dc_assign_activate;
+    for (i = 0; i < EC_SYNC_SIGNAL_COUNT; i++) {
+        data.dc_sync[i] = sc->dc_sync[i];
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get slave configuration PDO information.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_config_pdo(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_config_pdo_t data;
+    const ec_slave_config_t *sc;
+    const ec_pdo_t *pdo;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
     }
 
     if (data.sync_index >= EC_MAX_SYNC_MANAGERS) {
@@ -2450,6 +2929,50 @@ static ATTRIBUTES int ec_ioctl_set_send_interval(
 
 /*****************************************************************************/
 
+/** Sends frames, using the application's send callback, if registered.
+ *
+ * The caller must hold the realtime lock.
+ *
+ * \return Number of bytes sent.
+ */
+static size_t ec_ioctl_master_send(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+#if defined(EC_RTDM) && defined(EC_EOE)
+    return ecrt_master_send(master);
+#else
+    if (master->send_cb != NULL) {
+        master->send_cb(master->cb_data);
+        return 0;
+    }
+
+    return ecrt_master_send(master);
+#endif
+}
+
+/*****************************************************************************/
+
+/** Receives frames, using the application's receive callback, if registered.
+ *
+ * The caller must hold the realtime lock.
+ */
+static void ec_ioctl_master_receive(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+#if defined(EC_RTDM) && defined(EC_EOE)
+    ecrt_master_receive(master);
+#else
+    if (master->receive_cb != NULL)
+        master->receive_cb(master->cb_data);
+    else
+        ecrt_master_receive(master);
+#endif
+}
+
+/*****************************************************************************/
+
 /** Send frames.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -2467,21 +2990,14 @@ static ATTRIBUTES int ec_ioctl_send(
     }
 
     /* Locking added as send is likely to be used by more than
-        one application tasks */
-    if (ec_ioctl_lock_down_interruptible(&master->master_sem))
+        one application tasks. The master_sem is not taken, so that the
+        realtime path does not wait for the master state machines. */
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
         return -EINTR;
 
-#if defined(EC_RTDM) && defined(EC_EOE)
-    sent_bytes = ecrt_master_send(master);
-#else
-    if (master->send_cb != NULL) {
-        master->send_cb(master->cb_data);
-        sent_bytes = 0;
-    } else
-        sent_bytes = ecrt_master_send(master);
-#endif
+    sent_bytes = ec_ioctl_master_send(master);
 
-    ec_ioctl_lock_up(&master->master_sem);
+    ec_ioctl_lock_up(&master->rt_sem);
 
     if (copy_to_user((void __user *) arg, &sent_bytes, sizeof(sent_bytes))) {
         return -EFAULT;
@@ -2508,19 +3024,12 @@ static ATTRIBUTES int ec_ioctl_receive(
 
     /* Locking added as receive is likely to be used by more than
        one application tasks */
-    if (ec_ioctl_lock_down_interruptible(&master->master_sem))
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
         return -EINTR;
 
-#if defined(EC_RTDM) && defined(EC_EOE)
-    ecrt_master_receive(master);
-#else
-    if (master->receive_cb != NULL)
-        master->receive_cb(master->cb_data);
-    else
-        ecrt_master_receive(master);
-#endif
+    ec_ioctl_master_receive(master);
 
-    ec_ioctl_lock_up(&master->master_sem);
+    ec_ioctl_lock_up(&master->rt_sem);
 
     return 0;
 }
@@ -2580,6 +3089,63 @@ static ATTRIBUTES int ec_ioctl_master_state(
 
 /*****************************************************************************/
 
+/** Configure the DC drift compensation controller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_dc_pll_config(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_dc_pll_config_t config;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&config, (void __user *) arg, sizeof(config))) {
+        return -EFAULT;
+    }
+
+    /* The controller is updated by the cyclic calls, which are serialized
+     * by rt_sem. */
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
+        return -EINTR;
+
+    ret = ecrt_master_dc_pll_config(master, &config);
+
+    ec_ioctl_lock_up(&master->rt_sem);
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Get the state of the DC drift compensation controller.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_dc_pll_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_dc_pll_state_t data;
+
+    ecrt_master_dc_pll_state(master, &data);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Get the link state.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -3804,223 +4370,773 @@ static ATTRIBUTES int ec_ioctl_sc_idn(
     if (!ioctl.size)
         return -EINVAL;
 
-    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
-        return -ENOMEM;
-    }
+    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
+        kfree(data);
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        kfree(data);
+        return -EINTR;
+    }
+
+    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
+        ec_lock_up(&master->master_sem);
+        kfree(data);
+        return -ENOENT;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    ret = ecrt_slave_config_idn(
+            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Configures a feature flag.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_flag(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_flag_t ioctl;
+    ec_slave_config_t *sc;
+    uint8_t *key;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
+        return -EFAULT;
+    }
+
+    if (!ioctl.key_size) {
+        return -EINVAL;
+    }
+
+    if (!(key = kmalloc(ioctl.key_size + 1, GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(key, (void __user *) ioctl.key, ioctl.key_size)) {
+        kfree(key);
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        kfree(key);
+        return -EINTR;
+    }
+
+    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
+        ec_lock_up(&master->master_sem);
+        kfree(key);
+        return -ENOENT;
+    }
+
+    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+
+    ret = ecrt_slave_config_flag(sc, key, ioctl.value);
+    kfree(key);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's data size.
+ *
+ * \return Domain size, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_size(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->index == (unsigned long) arg) {
+            size_t size = ecrt_domain_size(domain);
+            ec_lock_up(&master->master_sem);
+            return size;
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's offset in the total process data.
+ *
+ * \return Domain offset, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_offset(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    int offset = 0;
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (ec_lock_down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->index == (unsigned long) arg) {
+            ec_lock_up(&master->master_sem);
+            return offset;
+        }
+        offset += ecrt_domain_size(domain);
+    }
+
+    ec_lock_up(&master->master_sem);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
+/** Process the domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_process(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* Locking added as domain processing is likely to be used by more than
+       one application tasks */
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem)) {
+        return -EINTR;
+    }
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        ec_ioctl_lock_up(&master->rt_sem);
+        return -ENOENT;
+    }
+
+    ecrt_domain_process(domain);
+    ec_ioctl_lock_up(&master->rt_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queue the domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_queue(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* Locking added as domain queing is likely to be used by more than
+       one application tasks */
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
+        return -EINTR;
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        ec_ioctl_lock_up(&master->rt_sem);
+        return -ENOENT;
+    }
+
+    ecrt_domain_queue(domain);
+
+    ec_ioctl_lock_up(&master->rt_sem);
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Executes a single cyclic command.
+ *
+ * The caller must hold the realtime lock. Output values are stored in the
+ * command's \a value field.
+ *
+ * \return Non-negative result on success, otherwise a negative error code.
+ */
+static int ec_ioctl_exec_cmd(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_cmd_t *cmd /**< Command. */
+        )
+{
+    ec_domain_t *domain;
+    uint32_t time32;
+    uint64_t time64;
+    int ret;
+
+    switch (cmd->type) {
+        case EC_CMD_NONE:
+            return 0;
+        case EC_CMD_RECEIVE:
+            ec_ioctl_master_receive(master);
+            return 0;
+        case EC_CMD_SEND:
+            return min_t(size_t, ec_ioctl_master_send(master), INT_MAX);
+        case EC_CMD_DOMAIN_PROCESS:
+            if (!(domain = ec_master_find_domain(master, cmd->index))) {
+                return -ENOENT;
+            }
+            ecrt_domain_process(domain);
+            return 0;
+        case EC_CMD_DOMAIN_QUEUE:
+            if (!(domain = ec_master_find_domain(master, cmd->index))) {
+                return -ENOENT;
+            }
+            ecrt_domain_queue(domain);
+            return 0;
+        case EC_CMD_APP_TIME:
+            ecrt_master_application_time(master, cmd->value);
+            return 0;
+        case EC_CMD_SYNC_REF_CLOCK:
+            ecrt_master_sync_reference_clock(master);
+            return 0;
+        case EC_CMD_SYNC_REF_CLOCK_TO:
+            ecrt_master_sync_reference_clock_to(master, cmd->value);
+            return 0;
+        case EC_CMD_SYNC_SLAVE_CLOCKS:
+            ecrt_master_sync_slave_clocks(master);
+            return 0;
+        case EC_CMD_REF_CLOCK_TIME:
+            ret = ecrt_master_reference_clock_time(master, &time32);
+            if (!ret) {
+                cmd->value = time32;
+            }
+            return ret;
+        case EC_CMD_REF_CLOCK_TIME_64_QUEUE:
+            ecrt_master_64bit_reference_clock_time_queue(master);
+            return 0;
+        case EC_CMD_REF_CLOCK_TIME_64:
+            ret = ecrt_master_64bit_reference_clock_time(master, &time64);
+            if (!ret) {
+                cmd->value = time64;
+            }
+            return ret;
+        case EC_CMD_SYNC_MONITOR_QUEUE:
+            ecrt_master_sync_monitor_queue(master);
+            return 0;
+        case EC_CMD_SYNC_MONITOR_PROCESS:
+            cmd->value = ecrt_master_sync_monitor_process(master);
+            return 0;
+        default:
+            return -EINVAL;
+    }
+}
+
+/*****************************************************************************/
+
+/** Set up the cyclic command ring.
+ *
+ * The ring is mapped by the application at #EC_IOCTL_CMD_RING_OFFSET.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_setup_cmd_ring(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+#ifdef EC_IOCTL_RTDM
+    return -EOPNOTSUPP;
+#else
+    size_t size = PAGE_ALIGN(sizeof(ec_ioctl_cmd_ring_t));
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (ctx->cmd_ring) {
+        return 0;
+    }
+
+    ctx->cmd_ring = vmalloc(size);
+    if (!ctx->cmd_ring) {
+        EC_MASTER_ERR(master, "Failed to allocate %zu bytes"
+                " of command ring memory!\n", size);
+        return -ENOMEM;
+    }
+
+    memset(ctx->cmd_ring, 0, size);
+    ctx->cmd_ring_tail = 0;
+
+    EC_MASTER_DBG(master, 1, "Command ring with %u slots set up.\n",
+            EC_IOCTL_CMD_RING_SIZE);
+    return 0;
+#endif
+}
+
+/*****************************************************************************/
+
+/** Execute the pending commands of the cyclic command ring.
+ *
+ * All commands are executed with a single acquisition of the realtime lock.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_cmd_ring_exec(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_cmd_ring_t *ring = ctx->cmd_ring;
+    ec_ioctl_cmd_t *cmd;
+    uint32_t head, tail = ctx->cmd_ring_tail;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (unlikely(!ring))
+        return -ENXIO;
+
+    /* the head is written by the application; read it only once */
+    head = *(volatile uint32_t *) &ring->head;
+    smp_rmb();
+
+    if (unlikely(head - tail > EC_IOCTL_CMD_RING_SIZE)) {
+        ring->tail = ctx->cmd_ring_tail = head;
+        return -EOVERFLOW;
+    }
+
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
+        return -EINTR;
+
+    for (; tail != head; tail++) {
+        cmd = &ring->cmd[tail & (EC_IOCTL_CMD_RING_SIZE - 1)];
+        cmd->result = ec_ioctl_exec_cmd(master, cmd);
+    }
+
+    ec_ioctl_lock_up(&master->rt_sem);
+
+    smp_wmb();
+    ring->tail = ctx->cmd_ring_tail = tail;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Execute a batch of cyclic commands.
+ *
+ * All commands are executed with a single acquisition of the realtime lock,
+ * the results are copied back with a single copy_to_user().
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_batch(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_batch_t io;
+    ec_ioctl_cmd_t cmds[EC_IOCTL_BATCH_SIZE];
+    uint32_t i;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (unlikely(io.count > EC_IOCTL_BATCH_SIZE)) {
+        return -EINVAL;
+    }
+
+    if (copy_from_user(cmds, (void __user *) io.cmds,
+                io.count * sizeof(*cmds))) {
+        return -EFAULT;
+    }
+
+    if (ec_ioctl_lock_down_interruptible(&master->rt_sem))
+        return -EINTR;
+
+    for (i = 0; i < io.count; i++) {
+        cmds[i].result = ec_ioctl_exec_cmd(master, &cmds[i]);
+    }
+
+    ec_ioctl_lock_up(&master->rt_sem);
+
+    if (copy_to_user((void __user *) io.cmds, cmds,
+                io.count * sizeof(*cmds))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get a latency histogram.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_latency(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_latency_t io;
+    ec_latency_hist_t *hist;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+        return -EFAULT;
+
+    if (io.type >= EC_LATENCY_COUNT)
+        return -EINVAL;
+
+    if (io.reset && !ctx->writable)
+        return -EPERM;
+
+    /* The histograms are updated by the realtime side without locking, so
+     * the copy may be slightly inconsistent. This is acceptable for
+     * statistics. */
+    hist = &master->latency[io.type];
 
-    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
-        kfree(data);
+    if (copy_to_user((void __user *) io.hist, hist, sizeof(*hist)))
         return -EFAULT;
-    }
-
-    if (ec_lock_down_interruptible(&master->master_sem)) {
-        kfree(data);
-        return -EINTR;
-    }
 
-    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
-        ec_lock_up(&master->master_sem);
-        kfree(data);
-        return -ENOENT;
+    if (io.reset) {
+        ec_latency_hist_reset(hist);
     }
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
-
-    ret = ecrt_slave_config_idn(
-            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
-    kfree(data);
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Configures a feature flag.
+/** Get the DC system time difference statistics of a slave.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_flag(
+static ATTRIBUTES int ec_ioctl_slave_dc_stats(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_flag_t ioctl;
-    ec_slave_config_t *sc;
-    uint8_t *key;
-    int ret;
+    ec_ioctl_slave_dc_stats_t io;
+    ec_slave_t *slave;
+    int ret = 0;
 
-    if (unlikely(!ctx->requested)) {
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+        return -EFAULT;
+
+    if (io.reset && !ctx->writable)
         return -EPERM;
-    }
 
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
-        return -EFAULT;
-    }
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!ioctl.key_size) {
+    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_DBG(master, 1, "Slave %u does not exist!\n",
+                io.slave_position);
         return -EINVAL;
     }
 
-    if (!(key = kmalloc(ioctl.key_size + 1, GFP_KERNEL))) {
-        return -ENOMEM;
+    if (copy_to_user((void __user *) io.stats, &slave->dc_stats,
+                sizeof(slave->dc_stats))) {
+        ret = -EFAULT;
+    } else if (io.reset) {
+        ec_dc_stats_reset(&slave->dc_stats);
     }
 
-    if (copy_from_user(key, (void __user *) ioctl.key, ioctl.key_size)) {
-        kfree(key);
+    ec_lock_up(&master->master_sem);
+
+    if (ret)
+        return ret;
+
+    io.interval = master->dc_monitor_interval;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io)))
         return -EFAULT;
-    }
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
-        kfree(key);
-        return -EINTR;
-    }
+    return 0;
+}
 
-    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
-        ec_lock_up(&master->master_sem);
-        kfree(key);
-        return -ENOENT;
-    }
+/*****************************************************************************/
 
-    ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
+/** Set the DC monitor interval.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_dc_monitor(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    uint32_t interval;
 
-    ret = ecrt_slave_config_flag(sc, key, ioctl.value);
-    kfree(key);
-    return ret;
+    if (copy_from_user(&interval, (void __user *) arg, sizeof(interval)))
+        return -EFAULT;
+
+    return ec_master_dc_monitor_enable(master, interval);
 }
 
 /*****************************************************************************/
 
-/** Gets the domain's data size.
+/** Get the ESC error counter statistics of a slave.
  *
- * \return Domain size, or a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_size(
+static ATTRIBUTES int ec_ioctl_slave_esc_stats(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    const ec_domain_t *domain;
+    ec_ioctl_slave_esc_stats_t io;
+    ec_slave_t *slave;
+    int ret = 0;
 
-    if (unlikely(!ctx->requested)) {
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+        return -EFAULT;
+
+    if (io.reset && !ctx->writable)
         return -EPERM;
-    }
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
+    if (ec_lock_down_interruptible(&master->master_sem))
         return -EINTR;
+
+    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_DBG(master, 1, "Slave %u does not exist!\n",
+                io.slave_position);
+        return -EINVAL;
     }
 
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            size_t size = ecrt_domain_size(domain);
-            ec_lock_up(&master->master_sem);
-            return size;
-        }
+    // the statistics are updated by the master thread under master_sem
+    if (copy_to_user((void __user *) io.stats, &slave->esc_stats,
+                sizeof(slave->esc_stats))) {
+        ret = -EFAULT;
+    } else if (io.reset) {
+        ec_esc_stats_reset(&slave->esc_stats);
     }
 
+    io.monitor.interval = master->esc_monitor_interval;
+    io.monitor.threshold = master->esc_monitor_threshold;
+
     ec_lock_up(&master->master_sem);
-    return -ENOENT;
+
+    if (ret)
+        return ret;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io)))
+        return -EFAULT;
+
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Gets the domain's offset in the total process data.
+/** Configure the ESC error monitor.
  *
- * \return Domain offset, or a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_offset(
+static ATTRIBUTES int ec_ioctl_esc_monitor(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    int offset = 0;
-    const ec_domain_t *domain;
+    ec_ioctl_esc_monitor_t io;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+        return -EFAULT;
 
-    if (ec_lock_down_interruptible(&master->master_sem)) {
+    if (ec_lock_down_interruptible(&master->master_sem))
         return -EINTR;
-    }
 
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            ec_lock_up(&master->master_sem);
-            return offset;
-        }
-        offset += ecrt_domain_size(domain);
+    if (io.interval != master->esc_monitor_interval ||
+            io.threshold != master->esc_monitor_threshold) {
+        master->esc_monitor_interval = io.interval;
+        master->esc_monitor_threshold = io.threshold;
+        // start with a new sweep
+        master->esc_monitor_start = jiffies;
+        master->esc_monitor_next = 0;
+        EC_MASTER_INFO(master, "ESC monitor interval set to %u ms,"
+                " threshold %u errors per minute.\n", io.interval,
+                io.threshold);
     }
 
     ec_lock_up(&master->master_sem);
-    return -ENOENT;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Process the domain.
+/** Load the persistent SII cache.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_process(
+static ATTRIBUTES int ec_ioctl_sii_cache_load(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_domain_t *domain;
+#ifdef EC_SII_CACHE
+    ec_ioctl_sii_cache_t io;
+    uint8_t *data;
+    int ret;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.size || io.size > EC_SII_CACHE_MAX_SIZE) {
+        return -EINVAL;
+    }
+
+    if (!(data = vmalloc(io.size))) {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *) io.data, io.size)) {
+        vfree(data);
+        return -EFAULT;
+    }
 
-    /* Locking added as domain processing is likely to be used by more than
-       one application tasks */
     if (ec_ioctl_lock_down_interruptible(&master->master_sem)) {
+        vfree(data);
         return -EINTR;
     }
 
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
-        ec_ioctl_lock_up(&master->master_sem);
-        return -ENOENT;
-    }
+    ret = ec_sii_cache_load(master, data, io.size);
 
-    ecrt_domain_process(domain);
     ec_ioctl_lock_up(&master->master_sem);
+    vfree(data);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    io.count = ret;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
     return 0;
+#else
+    return -EOPNOTSUPP;
+#endif
 }
 
 /*****************************************************************************/
 
-/** Queue the domain.
+/** Save the persistent SII cache.
+ *
+ * If the provided buffer is too small, only the required size is returned.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_queue(
+static ATTRIBUTES int ec_ioctl_sii_cache_save(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_domain_t *domain;
+#ifdef EC_SII_CACHE
+    ec_ioctl_sii_cache_t io;
+    uint8_t *data = NULL;
+    size_t size;
+    int ret = 0;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
 
-    /* Locking added as domain queing is likely to be used by more than
-       one application tasks */
-    if (ec_ioctl_lock_down_interruptible(&master->master_sem))
+    if (ec_ioctl_lock_down_interruptible(&master->master_sem)) {
         return -EINTR;
+    }
 
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+    size = ec_sii_cache_save(master, NULL, 0);
+
+    if (size > EC_SII_CACHE_MAX_SIZE) {
         ec_ioctl_lock_up(&master->master_sem);
-        return -ENOENT;
+        return -EFBIG;
     }
 
-    ecrt_domain_queue(domain);
+    io.count = 0;
+
+    if (io.data && io.size >= size) {
+        if (!(data = vmalloc(size))) {
+            ec_ioctl_lock_up(&master->master_sem);
+            return -ENOMEM;
+        }
+        ec_sii_cache_save(master, data, size);
+        io.count = EC_READ_U32(data + 8);
+    }
 
     ec_ioctl_lock_up(&master->master_sem);
 
+    if (data) {
+        if (copy_to_user((void __user *) io.data, data, size)) {
+            ret = -EFAULT;
+        }
+        vfree(data);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    io.size = size;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
     return 0;
+#else
+    return -EOPNOTSUPP;
+#endif
 }
 
 /*****************************************************************************/
@@ -5550,6 +6666,9 @@ long EC_IOCTL(
         case EC_IOCTL_SLAVE_SYNC_PDO_ENTRY:
             ret = ec_ioctl_slave_sync_pdo_entry(master, arg);
             break;
+        case EC_IOCTL_TOPOLOGY:
+            ret = ec_ioctl_topology(master, arg);
+            break;
         case EC_IOCTL_DOMAIN:
             ret = ec_ioctl_domain(master, arg);
             break;
@@ -5562,6 +6681,12 @@ long EC_IOCTL(
         case EC_IOCTL_PCAP_DATA:
             ret = ec_ioctl_pcap_data(master, arg);
             break;
+        case EC_IOCTL_PCAP_CONFIG:
+            ret = ec_ioctl_pcap_config(master, arg, ctx);
+            break;
+        case EC_IOCTL_PCAP_READ:
+            ret = ec_ioctl_pcap_read(master, arg, ctx);
+            break;
         case EC_IOCTL_MASTER_DEBUG:
             if (!ctx->writable) {
                 ret = -EPERM;
@@ -5633,6 +6758,9 @@ long EC_IOCTL(
             }
             ret = ec_ioctl_slave_reg_readwrite(master, arg);
             break;
+        case EC_IOCTL_SLAVE_REG_SWEEP:
+            ret = ec_ioctl_slave_reg_sweep(master, arg, ctx);
+            break;
         case EC_IOCTL_SLAVE_FOE_READ:
             ret = ec_ioctl_slave_foe_read(master, arg);
             break;
@@ -6200,6 +7328,70 @@ long EC_IOCTL(
             }
             ret = ec_ioctl_mbox_gateway(master, arg, ctx);
             break;
+        case EC_IOCTL_SETUP_CMD_RING:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_setup_cmd_ring(master, arg, ctx);
+            break;
+        case EC_IOCTL_CMD_RING_EXEC:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cmd_ring_exec(master, arg, ctx);
+            break;
+        case EC_IOCTL_BATCH:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_batch(master, arg, ctx);
+            break;
+        case EC_IOCTL_LATENCY:
+            ret = ec_ioctl_latency(master, arg, ctx);
+            break;
+        case EC_IOCTL_SII_CACHE_LOAD:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sii_cache_load(master, arg, ctx);
+            break;
+        case EC_IOCTL_SII_CACHE_SAVE:
+            ret = ec_ioctl_sii_cache_save(master, arg, ctx);
+            break;
+        case EC_IOCTL_DC_PLL_CONFIG:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_dc_pll_config(master, arg, ctx);
+            break;
+        case EC_IOCTL_DC_PLL_STATE:
+            ret = ec_ioctl_dc_pll_state(master, arg, ctx);
+            break;
+        case EC_IOCTL_SLAVE_DC_STATS:
+            ret = ec_ioctl_slave_dc_stats(master, arg, ctx);
+            break;
+        case EC_IOCTL_DC_MONITOR:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_dc_monitor(master, arg, ctx);
+            break;
+        case EC_IOCTL_SLAVE_ESC_STATS:
+            ret = ec_ioctl_slave_esc_stats(master, arg, ctx);
+            break;
+        case EC_IOCTL_ESC_MONITOR:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_esc_monitor(master, arg, ctx);
+            break;
         default:
             ret = -ENOTTY;
             break;
@@ -31,6 +31,8 @@
 #include <linux/ioctl.h>
 
 #include "globals.h"
+#include "latency.h"
+#include "esc_stats.h"
 
 /*****************************************************************************/
 
@@ -47,7 +49,7 @@
  *
  * Increment this when changing the ioctl interface!
  */
-#define EC_IOCTL_VERSION_MAGIC 37
+#define EC_IOCTL_VERSION_MAGIC 48
 
 // Command-line tool
 #define EC_IOCTL_MODULE                EC_IOR(0x00, ec_ioctl_module_t)
@@ -184,6 +186,40 @@
 // Mailbox Gateway
 #define EC_IOCTL_MBOX_GATEWAY         EC_IOWR(0x73, ec_ioctl_mbox_gateway_t)
 
+// Cyclic command ring
+#define EC_IOCTL_SETUP_CMD_RING         EC_IO(0x74)
+#define EC_IOCTL_CMD_RING_EXEC          EC_IO(0x75)
+#define EC_IOCTL_BATCH                EC_IOWR(0x76, ec_ioctl_batch_t)
+
+// Latency histograms
+#define EC_IOCTL_LATENCY              EC_IOWR(0x77, ec_ioctl_latency_t)
+
+// Persistent SII cache
+#define EC_IOCTL_SII_CACHE_LOAD        EC_IOWR(0x78, ec_ioctl_sii_cache_t)
+#define EC_IOCTL_SII_CACHE_SAVE        EC_IOWR(0x79, ec_ioctl_sii_cache_t)
+
+// DC drift compensation controller
+#define EC_IOCTL_DC_PLL_CONFIG          EC_IOW(0x7a, ec_dc_pll_config_t)
+#define EC_IOCTL_DC_PLL_STATE           EC_IOR(0x7b, ec_dc_pll_state_t)
+
+// DC monitor
+#define EC_IOCTL_SLAVE_DC_STATS       EC_IOWR(0x7c, ec_ioctl_slave_dc_stats_t)
+#define EC_IOCTL_DC_MONITOR             EC_IOW(0x7d, uint32_t)
+
+// Frame capture
+#define EC_IOCTL_PCAP_CONFIG         EC_IOWR(0x7e, ec_ioctl_pcap_config_t)
+#define EC_IOCTL_PCAP_READ             EC_IOWR(0x80, ec_ioctl_pcap_read_t)
+
+// Bulk topology snapshot
+#define EC_IOCTL_TOPOLOGY              EC_IOWR(0x81, ec_ioctl_topology_t)
+
+// Register sweep
+#define EC_IOCTL_SLAVE_REG_SWEEP  EC_IOWR(0x82, ec_ioctl_slave_reg_sweep_t)
+
+// ESC error monitor
+#define EC_IOCTL_SLAVE_ESC_STATS     EC_IOWR(0x83, ec_ioctl_slave_esc_stats_t)
+#define EC_IOCTL_ESC_MONITOR           EC_IOW(0x84, ec_ioctl_esc_monitor_t)
+
 /*****************************************************************************/
 
 #define EC_IOCTL_STRING_SIZE 64
@@ -336,6 +372,40 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Format version of the topology snapshot. */
+#define EC_IOCTL_TOPOLOGY_VERSION 1
+
+/** Header of a topology snapshot.
+ *
+ * The header is followed by the arrays of ec_ioctl_slave_t,
+ * ec_ioctl_slave_sync_t, ec_ioctl_slave_sync_pdo_t and
+ * ec_ioctl_slave_sync_pdo_entry_t, each ordered by slave position, sync
+ * manager index, PDO position and entry position. The number of sync
+ * managers, PDOs and entries of each element is given by its \a sync_count,
+ * \a pdo_count and \a entry_count fields.
+ */
+typedef struct {
+    uint32_t version; /**< Format version. */
+    uint32_t slave_count; /**< Number of slaves. */
+    uint32_t sync_count; /**< Total number of sync managers. */
+    uint32_t pdo_count; /**< Total number of PDOs. */
+    uint32_t entry_count; /**< Total number of PDO entries. */
+    uint32_t reserved; /**< Reserved. */
+} ec_ioctl_topology_header_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input
+    uint32_t version; /**< Requested format version. */
+    // input / output
+    uint32_t size; /**< Size of \a data. The required size is returned. */
+    // input
+    uint8_t *data; /**< Snapshot, if \a size is large enough. */
+} ec_ioctl_topology_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t index;
@@ -384,6 +454,35 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // input
+    uint32_t set; /**< Apply the filter settings below. */
+    // input / output
+    uint32_t snaplen; /**< Bytes captured per frame, zero for all. */
+    uint32_t directions; /**< Captured directions (EC_PCAP_TX/RX). */
+    uint32_t types; /**< Bit mask of captured datagram types. */
+    // output
+    uint32_t size; /**< Ring size in bytes, zero if capturing is
+                     disabled. */
+    uint64_t frames; /**< Number of captured frames. */
+    uint64_t filtered; /**< Number of frames rejected by the filters. */
+    uint64_t overwritten; /**< Number of records dropped to make room. */
+} ec_ioctl_pcap_config_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input
+    uint8_t *target; /**< Target for the pcap records. */
+    uint32_t size; /**< Size of \a target. */
+    uint32_t nonblock; /**< Return immediately, if there are no records. */
+    // output
+    uint32_t data_size; /**< Number of bytes copied. */
+    uint32_t lost; /**< Bytes overwritten before they could be read. */
+} ec_ioctl_pcap_read_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
@@ -473,6 +572,33 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Maximum number of register ranges of a register sweep. */
+#define EC_IOCTL_REG_SWEEP_MAX_RANGES 16
+
+typedef struct {
+    uint16_t address; /**< Register address. */
+    uint16_t size; /**< Number of bytes. */
+    uint8_t dir; /**< EC_DIR_INPUT (read), EC_DIR_OUTPUT (write) or
+                   EC_DIR_BOTH (read and write). */
+    uint8_t reserved[3]; /**< Reserved. */
+} ec_ioctl_reg_range_t;
+
+typedef struct {
+    // inputs
+    uint32_t slave_count; /**< Number of slaves. */
+    uint32_t range_count; /**< Number of register ranges. */
+    uint16_t *slave_positions; /**< Slave positions. */
+    ec_ioctl_reg_range_t *ranges; /**< Register ranges. */
+    // input / output
+    uint8_t *data; /**< Register data. For each slave, the data of all
+                     ranges one after another. */
+    // output
+    uint8_t *success; /**< For each slave and range, 1 if the transfer
+                        succeeded, else 0. */
+} ec_ioctl_slave_reg_sweep_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
@@ -911,6 +1037,109 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Number of command slots in the cyclic command ring.
+ *
+ * Must be a power of two.
+ */
+#define EC_IOCTL_CMD_RING_SIZE 64
+
+/** mmap() offset of the cyclic command ring.
+ *
+ * Lower offsets map the process data.
+ */
+#define EC_IOCTL_CMD_RING_OFFSET 0x40000000UL
+
+typedef struct {
+    // input
+    uint32_t type; /**< Command type, see ec_cmd_type_t. */
+    uint32_t index; /**< Domain index, if applicable. */
+    // input / output
+    uint64_t value; /**< Command value, if applicable. */
+    // output
+    int32_t result; /**< Result of the command. */
+    uint32_t reserved;
+} ec_ioctl_cmd_t;
+
+/** Cyclic command ring, shared between the application and the master.
+ *
+ * The application fills the slots starting at \a head, the master executes
+ * them up to \a head and advances \a tail.
+ */
+typedef struct ec_ioctl_cmd_ring {
+    uint32_t head; /**< Next slot to be filled, written by the application. */
+    uint32_t tail; /**< Next slot to be executed, written by the master. */
+    ec_ioctl_cmd_t cmd[EC_IOCTL_CMD_RING_SIZE]; /**< Command slots. */
+} ec_ioctl_cmd_ring_t;
+
+/*****************************************************************************/
+
+/** Maximum number of commands per EC_IOCTL_BATCH call.
+ */
+#define EC_IOCTL_BATCH_SIZE EC_CYCLE_MAX_CMDS
+
+typedef struct {
+    // input
+    uint32_t count; /**< Number of commands, at most #EC_IOCTL_BATCH_SIZE. */
+    // input / output
+    ec_ioctl_cmd_t *cmds; /**< Commands. */
+} ec_ioctl_batch_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input
+    uint32_t type; /**< Histogram type, see ec_latency_type_t. */
+    uint32_t reset; /**< Reset the histogram after reading it. */
+    ec_latency_hist_t *hist; /**< Target for the histogram. */
+} ec_ioctl_latency_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input / output
+    uint32_t size; /**< Size of \a data. When saving, the required size is
+                     returned. */
+    // output
+    uint32_t count; /**< Number of loaded entries. */
+    // input
+    uint8_t *data; /**< SII cache blob. */
+} ec_ioctl_sii_cache_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input
+    uint16_t slave_position; /**< Slave position. */
+    uint16_t reset; /**< Reset the statistics after reading them. */
+    // output
+    uint32_t interval; /**< Current DC monitor interval. */
+    // input
+    ec_dc_stats_t *stats; /**< Target for the statistics. */
+} ec_ioctl_slave_dc_stats_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    uint32_t interval; /**< Interval between two sweeps in ms. Zero disables
+                         the ESC monitor. */
+    uint32_t threshold; /**< Errors per minute, from which on a port raises
+                          an event. Zero disables the rate events. */
+} ec_ioctl_esc_monitor_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // input
+    uint16_t slave_position; /**< Slave position. */
+    uint16_t reset; /**< Reset the statistics after reading them. */
+    // output
+    ec_ioctl_esc_monitor_t monitor; /**< Current ESC monitor settings. */
+    // input
+    ec_esc_stats_t *stats; /**< Target for the statistics. */
+} ec_ioctl_slave_esc_stats_t;
+
+/*****************************************************************************/
+
 #ifdef __KERNEL__
 
 /** Context data structure for file handles.
@@ -920,6 +1149,10 @@ typedef struct {
     unsigned int requested; /**< Master was requested via this file handle. */
     uint8_t *process_data; /**< Total process data area. */
     size_t process_data_size; /**< Size of the \a process_data. */
+    ec_ioctl_cmd_ring_t *cmd_ring; /**< Cyclic command ring, or NULL. */
+    uint32_t cmd_ring_tail; /**< Master's copy of the ring tail. */
+    unsigned long pcap_pos; /**< Stream position in the capture ring. */
+    unsigned int pcap_streaming; /**< \a pcap_pos is valid. */
 } ec_ioctl_context_t;
 
 long ec_ioctl(ec_master_t *, ec_ioctl_context_t *, unsigned int,
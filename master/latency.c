@@ -0,0 +1,146 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   EtherCAT latency histograms.
+*/
+
+/****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/bitops.h>
+#include <linux/math64.h>
+
+#include "globals.h"
+#include "latency.h"
+
+/****************************************************************************/
+
+/** Resets a histogram.
+ */
+void ec_latency_hist_reset(
+        ec_latency_hist_t *hist /**< Latency histogram. */
+        )
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min_ns = 0xffffffff;
+}
+
+/****************************************************************************/
+
+/** Adds a sample to a histogram.
+ */
+void ec_latency_hist_add(
+        ec_latency_hist_t *hist, /**< Latency histogram. */
+        uint32_t ns /**< Sample in ns. */
+        )
+{
+    unsigned int bucket, msb;
+
+    if (ns < (1U << EC_LATENCY_SUB_BITS)) {
+        bucket = ns;
+    } else {
+        msb = fls(ns) - 1;
+        bucket = ((msb - EC_LATENCY_SUB_BITS + 1) << EC_LATENCY_SUB_BITS)
+            | ((ns >> (msb - EC_LATENCY_SUB_BITS))
+                    & ((1U << EC_LATENCY_SUB_BITS) - 1));
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_ns += ns;
+    hist->last_ns = ns;
+    if (ns < hist->min_ns) {
+        hist->min_ns = ns;
+    }
+    if (ns > hist->max_ns) {
+        hist->max_ns = ns;
+    }
+}
+
+/****************************************************************************/
+
+/** Adds the time between two time stamps to a histogram.
+ *
+ * Spans exceeding the 32 bit nanosecond range are saturated.
+ */
+void ec_latency_hist_add_span(
+        ec_latency_hist_t *hist, /**< Latency histogram. */
+        ec_latency_time_t start, /**< Start time stamp. */
+        ec_latency_time_t end /**< End time stamp. */
+        )
+{
+    u64 ns;
+#ifdef EC_HAVE_CYCLES
+    u64 cycles = (u64) (end - start);
+
+    if (cycles > ~0ULL / 1000000) {
+        ns = ~0ULL;
+    } else {
+        ns = div_u64(cycles * 1000000, cpu_khz);
+    }
+#else
+    ns = end > start ? end - start : 0;
+#endif
+
+    ec_latency_hist_add(hist, ns > 0xffffffff ? 0xffffffff : (uint32_t) ns);
+}
+
+/****************************************************************************/
+
+/** Resets DC system time difference statistics.
+ */
+void ec_dc_stats_reset(
+        ec_dc_stats_t *stats /**< DC statistics. */
+        )
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min_ns = S32_MAX;
+    stats->max_ns = S32_MIN;
+    ec_latency_hist_reset(&stats->hist);
+}
+
+/****************************************************************************/
+
+/** Adds a system time difference register value to DC statistics.
+ */
+void ec_dc_stats_add(
+        ec_dc_stats_t *stats, /**< DC statistics. */
+        uint32_t reg /**< Register value in sign-and-magnitude coding. */
+        )
+{
+    uint32_t abs_ns = reg & 0x7fffffff;
+    int32_t ns = reg & 0x80000000 ? -(int32_t) abs_ns : (int32_t) abs_ns;
+
+    stats->last_ns = ns;
+    stats->sum_ns += ns;
+    if (ns < stats->min_ns) {
+        stats->min_ns = ns;
+    }
+    if (ns > stats->max_ns) {
+        stats->max_ns = ns;
+    }
+    ec_latency_hist_add(&stats->hist, abs_ns);
+}
+
+/****************************************************************************/
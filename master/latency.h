@@ -0,0 +1,160 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   EtherCAT latency histograms.
+*/
+
+/****************************************************************************/
+
+#ifndef __EC_LATENCY_H__
+#define __EC_LATENCY_H__
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/ktime.h>
+#include <linux/timex.h>
+#else
+#include <stdint.h>
+#endif
+
+/****************************************************************************/
+
+/** Number of bits used for sub-buckets per power of two.
+ *
+ * The relative resolution of a histogram is 2^-EC_LATENCY_SUB_BITS.
+ */
+#define EC_LATENCY_SUB_BITS 3
+
+/** Number of histogram buckets, covering the full 32 bit nanosecond range.
+ */
+#define EC_LATENCY_BUCKETS ((32 - EC_LATENCY_SUB_BITS + 1) \
+        << EC_LATENCY_SUB_BITS)
+
+/****************************************************************************/
+
+/** Latency histogram types.
+ */
+typedef enum {
+    EC_LATENCY_RTT, /**< Datagram round-trip time from sending to
+                      receiving. */
+    EC_LATENCY_SEND_INTERVAL, /**< Interval between consecutive calls of
+                                ecrt_master_send(). */
+    EC_LATENCY_DOMAIN_PROCESS, /**< Time spent in ecrt_domain_process(). */
+    EC_LATENCY_DOMAIN_QUEUE, /**< Time spent in ecrt_domain_queue(). */
+    EC_LATENCY_COUNT /**< Number of histogram types. */
+} ec_latency_type_t;
+
+/****************************************************************************/
+
+/** Latency histogram.
+ *
+ * The buckets are log-linear: Values below 2^EC_LATENCY_SUB_BITS have
+ * their own bucket, each higher power of two is split into
+ * 2^EC_LATENCY_SUB_BITS equally sized buckets.
+ */
+typedef struct {
+    uint64_t count; /**< Number of samples. */
+    uint64_t sum_ns; /**< Sum of all samples in ns. */
+    uint32_t min_ns; /**< Minimum sample in ns. */
+    uint32_t max_ns; /**< Maximum sample in ns. */
+    uint32_t last_ns; /**< Last sample in ns. */
+    uint32_t reserved;
+    uint32_t buckets[EC_LATENCY_BUCKETS]; /**< Sample counts. */
+} ec_latency_hist_t;
+
+/****************************************************************************/
+
+/** Statistics of the DC system time difference of a slave.
+ *
+ * The system time difference register (0x092C) holds the deviation of the
+ * slave's copy of the system time from the last received system time. The
+ * signed values are the local time minus the received time.
+ */
+typedef struct {
+    int32_t min_ns; /**< Minimum difference in ns. */
+    int32_t max_ns; /**< Maximum difference in ns. */
+    int32_t last_ns; /**< Last difference in ns. */
+    uint32_t reserved;
+    int64_t sum_ns; /**< Sum of all differences in ns. */
+    ec_latency_hist_t hist; /**< Histogram of the absolute differences. */
+} ec_dc_stats_t;
+
+/****************************************************************************/
+
+/** Returns the lowest value of a histogram bucket.
+ *
+ * \return Lower bound in ns.
+ */
+static inline uint32_t ec_latency_bucket_floor(
+        unsigned int bucket /**< Bucket index. */
+        )
+{
+    unsigned int shift;
+
+    if (bucket < (1U << EC_LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+
+    shift = (bucket >> EC_LATENCY_SUB_BITS) - 1;
+    return ((1U << EC_LATENCY_SUB_BITS)
+            | (bucket & ((1U << EC_LATENCY_SUB_BITS) - 1))) << shift;
+}
+
+/****************************************************************************/
+
+#ifdef __KERNEL__
+
+/** Time stamp for latency measurements.
+ */
+#ifdef EC_HAVE_CYCLES
+typedef cycles_t ec_latency_time_t;
+#else
+typedef s64 ec_latency_time_t;
+#endif
+
+/** Returns the current latency time stamp.
+ *
+ * \return Time stamp.
+ */
+static inline ec_latency_time_t ec_latency_time(void)
+{
+#ifdef EC_HAVE_CYCLES
+    return get_cycles();
+#else
+    return ktime_to_ns(ktime_get());
+#endif
+}
+
+void ec_latency_hist_reset(ec_latency_hist_t *);
+void ec_latency_hist_add(ec_latency_hist_t *, uint32_t);
+void ec_latency_hist_add_span(ec_latency_hist_t *, ec_latency_time_t,
+        ec_latency_time_t);
+
+void ec_dc_stats_reset(ec_dc_stats_t *);
+void ec_dc_stats_add(ec_dc_stats_t *, uint32_t);
+
+#endif // __KERNEL__
+
+/****************************************************************************/
+
+#endif
@@ -40,6 +40,7 @@
 #include "mailbox.h"
 #include "datagram.h"
 #include "master.h"
+#include "slave_config.h"
 
 /*****************************************************************************/
 
@@ -96,24 +97,105 @@ uint8_t *ec_slave_mbox_prepare_send(const ec_slave_t *slave, /**< slave */
 
 /**
    Prepares a datagram for checking the mailbox state.
+
+   If the sync manager status of the slave is mapped into the mailbox status
+   area, the datagram is not sent. Instead, it is answered by the master with
+   the result of the next mailbox status datagram (see
+   ec_master_exec_slave_fsms()).
+
    \todo Determine sync manager used for receive mailbox
    \return 0 in case of success, else < 0
 */
 
-int ec_slave_mbox_prepare_check(const ec_slave_t *slave, /**< slave */
+int ec_slave_mbox_prepare_check(ec_slave_t *slave, /**< slave */
                                 ec_datagram_t *datagram /**< datagram */
                                 )
 {
+    ec_master_t *master = slave->master;
     int ret = ec_datagram_fprd(datagram, slave->station_address, 0x808, 8);
     if (ret)
         return ret;
 
     ec_datagram_zero(datagram);
+
+    if (slave->mbox_status_mapped && !master->mbox_status_degraded
+            && ec_master_is_external_datagram(master, datagram)) {
+        // not injected, but waiting for the mailbox status
+        datagram->state = EC_DATAGRAM_SENT;
+        slave->mbox_status_check = datagram;
+        slave->mbox_status_seq = master->mbox_status_seq;
+    }
+
     return 0;
 }
 
 /*****************************************************************************/
 
+/**
+   Determines the FMMU used for mapping the mailbox status.
+
+   The last FMMU of the slave is used, if it is not needed for process data.
+
+   \return FMMU index, or < 0 if the mailbox status can not be mapped.
+*/
+
+int ec_slave_mbox_status_fmmu(const ec_slave_t *slave /**< slave */)
+{
+    unsigned int used_fmmus = slave->config ? slave->config->used_fmmus : 0;
+
+    if (!slave->sii_image || !slave->sii_image->sii.mailbox_protocols
+            || slave->device_index != EC_DEVICE_MAIN
+            || slave->base_fmmu_count <= used_fmmus
+            || slave->ring_position >= EC_MBOX_STATUS_MAX_SLAVES) {
+        return -1;
+    }
+
+    return slave->base_fmmu_count - 1;
+}
+
+/*****************************************************************************/
+
+/**
+   Writes the FMMU configuration page for the mailbox status.
+
+   The sync manager 1 status byte is mapped to the byte of the slave's ring
+   position in the mailbox status area.
+*/
+
+void ec_slave_mbox_status_page(const ec_slave_t *slave, /**< slave */
+                               uint8_t *data /**< configuration page */
+                               )
+{
+    EC_WRITE_U32(data,      EC_MBOX_STATUS_ADDRESS + slave->ring_position);
+    EC_WRITE_U16(data + 4,  1); // size of fmmu
+    EC_WRITE_U8 (data + 6,  0x00); // logical start bit
+    EC_WRITE_U8 (data + 7,  0x07); // logical end bit
+    EC_WRITE_U16(data + 8,  0x080D); // sync manager 1 status
+    EC_WRITE_U8 (data + 10, 0x00); // physical start bit
+    EC_WRITE_U8 (data + 11, 0x01); // read access
+    EC_WRITE_U16(data + 12, 0x0001); // enable
+    EC_WRITE_U16(data + 14, 0x0000); // reserved
+}
+
+/*****************************************************************************/
+
+/**
+   Marks the mailbox status of a slave as mapped or unmapped.
+*/
+
+void ec_slave_mbox_status_set_mapped(ec_slave_t *slave, /**< slave */
+                                     uint8_t mapped /**< mapping state */
+                                     )
+{
+    if (slave->mbox_status_mapped != mapped) {
+        slave->mbox_status_mapped = mapped;
+        // the expected working counter of a datagram in flight is invalid
+        slave->master->mbox_status_generation++;
+    }
+}
+
+/*****************************************************************************/
+
 /**
    Processes a mailbox state checking datagram.
    \return 0 in case of success, else < 0
@@ -45,6 +45,18 @@
  */
 #define EC_MBOX_HEADER_SIZE 6
 
+/** Logical address of the mailbox status area.
+ *
+ * The sync manager 1 status of every mailbox slave is mapped to the byte
+ * given by its ring position, so that a single LRD reads the mailbox states
+ * of all slaves.
+ */
+#define EC_MBOX_STATUS_ADDRESS 0xFFFF0000
+
+/** Maximum number of slaves covered by the mailbox status area.
+ */
+#define EC_MBOX_STATUS_MAX_SLAVES EC_MAX_DATA_SIZE
+
 /** Mailbox types.
  *
  * These are used in the 'Type' field of the mailbox header.
@@ -70,8 +82,11 @@ extern const ec_code_msg_t mbox_error_messages[];
 
 uint8_t *ec_slave_mbox_prepare_send(const ec_slave_t *, ec_datagram_t *,
                                     uint8_t, size_t);
-int      ec_slave_mbox_prepare_check(const ec_slave_t *, ec_datagram_t *);
+int      ec_slave_mbox_prepare_check(ec_slave_t *, ec_datagram_t *);
 int      ec_slave_mbox_check(const ec_datagram_t *);
+int      ec_slave_mbox_status_fmmu(const ec_slave_t *);
+void     ec_slave_mbox_status_page(const ec_slave_t *, uint8_t *);
+void     ec_slave_mbox_status_set_mapped(ec_slave_t *, uint8_t);
 int      ec_slave_mbox_prepare_fetch(const ec_slave_t *, ec_datagram_t *);
 uint8_t *ec_slave_mbox_fetch(const ec_slave_t *, ec_mbox_data_t *,
                              uint8_t *, size_t *);
@@ -63,6 +63,7 @@
 #endif
 
 #include "master.h"
+#include "sii_cache.h"
 
 /*****************************************************************************/
 
@@ -111,6 +112,8 @@ void ec_master_clear_slave_configs(ec_master_t *);
 void ec_master_clear_domains(ec_master_t *);
 static int ec_master_idle_thread(void *);
 static int ec_master_operation_thread(void *);
+static int ec_master_ext_ring_grow(ec_master_t *, unsigned int);
+static void ec_master_ext_ring_clear(ec_master_t *);
 #ifdef EC_EOE
 static int ec_master_eoe_thread(void *);
 #endif
@@ -159,6 +162,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     master->reserved = 0;
 
     ec_lock_init(&master->master_sem);
+    ec_lock_init(&master->rt_sem);
 
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < EC_MAX_NUM_DEVICES; dev_idx++) {
         master->macs[dev_idx] = NULL;
@@ -192,10 +196,12 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     INIT_LIST_HEAD(&master->configs);
     INIT_LIST_HEAD(&master->domains);
     INIT_LIST_HEAD(&master->sii_images);
+    INIT_LIST_HEAD(&master->sii_cache);
 
     master->app_time = 0ULL;
     master->dc_ref_time = 0ULL;
     master->dc_offset_valid = 0;
+    ec_dc_pll_init(&master->dc_pll);
 
     master->scan_busy = 0;
     master->allow_scan = 1;
@@ -208,22 +214,20 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     INIT_LIST_HEAD(&master->datagram_queue);
     master->datagram_index = 0;
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        master->datagram_lookup[i] = NULL;
+    }
 
     INIT_LIST_HEAD(&master->ext_datagram_queue);
     ec_lock_init(&master->ext_queue_sem);
 
     master->ext_ring_idx_rt = 0;
     master->ext_ring_idx_fsm = 0;
+    master->ext_ring_size = 0;
+    master->ext_ring_starved = 0;
     master->rt_slave_requests = 0;
     master->rt_slaves_available = 0;
 
-    // init external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
-        ec_datagram_t *datagram = &master->ext_datagram_ring[i];
-        ec_datagram_init(datagram);
-        snprintf(datagram->name, EC_DATAGRAM_NAME_SIZE, "ext-%u", i);
-    }
-
     // send interval in IDLE phase
     ec_master_set_send_interval(master, 1000000 / HZ);
 
@@ -231,20 +235,33 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     INIT_LIST_HEAD(&master->fsm_exec_list);
     master->fsm_exec_count = 0U;
 
+    master->mbox_status_datagram = NULL;
+    master->mbox_status_seq = 0;
+    master->mbox_status_generation = 0;
+    master->mbox_status_sent_generation = 0;
+    master->mbox_status_expected = 0;
+    master->mbox_status_degraded = 0;
+
+    master->esc_monitor_interval = 0;
+    master->esc_monitor_threshold = 0;
+    master->esc_monitor_start = jiffies;
+    master->esc_monitor_next = 0;
+    memset(master->esc_monitor_readings, 0,
+            sizeof(master->esc_monitor_readings));
+
     master->debug_level = debug_level;
     master->stats.timeouts = 0;
     master->stats.corrupted = 0;
     master->stats.unmatched = 0;
     master->stats.output_jiffies = 0;
+    ec_master_reset_latency(master);
 
     // set up pcap debugging
-    if (pcap_size > 0) {
-        master->pcap_data = vmalloc(pcap_size);
-    } else {
-        master->pcap_data = NULL;
+    if (ec_pcap_init(&master->pcap, pcap_size)) {
+        EC_MASTER_WARN(master, "Failed to allocate %lu bytes of pcap"
+                " memory. Frame capturing disabled.\n", pcap_size);
     }
-    master->pcap_curr_data = master->pcap_data;
-    
+
     master->thread = NULL;
 
 #ifdef EC_EOE
@@ -288,14 +305,9 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     ec_fsm_master_init(&master->fsm, master, &master->fsm_datagram);
 
     // alloc external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
-        ec_datagram_t *datagram = &master->ext_datagram_ring[i];
-        ret = ec_datagram_prealloc(datagram, EC_MAX_DATA_SIZE);
-        if (ret) {
-            EC_MASTER_ERR(master, "Failed to allocate external"
-                    " datagram %u.\n", i);
-            goto out_clear_ext_datagrams;
-        }
+    ret = ec_master_ext_ring_grow(master, EC_EXT_RING_SIZE);
+    if (ret) {
+        goto out_clear_ext_datagrams;
     }
 
     // init reference sync datagram
@@ -344,13 +356,33 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
         goto out_clear_sync64;
     }
 
+    // init DC monitor datagram
+    ec_datagram_init(&master->dc_monitor_datagram);
+    snprintf(master->dc_monitor_datagram.name, EC_DATAGRAM_NAME_SIZE,
+            "dcmon");
+    ret = ec_datagram_prealloc(&master->dc_monitor_datagram, 4);
+    if (ret < 0) {
+        ec_datagram_clear(&master->dc_monitor_datagram);
+        EC_MASTER_ERR(master, "Failed to allocate DC monitor datagram.\n");
+        goto out_clear_sync_mon;
+    }
+    master->dc_monitor_interval = 0;
+    master->dc_monitor_cycle = 0;
+    master->dc_monitor_stations = NULL;
+    master->dc_monitor_station_count = 0;
+    master->dc_monitor_next = 0;
+    master->dc_monitor_pending = 0;
+    master->dc_monitor_station = 0;
+    master->dc_monitor_rd_idx_rt = 0;
+    master->dc_monitor_rd_idx_fsm = 0;
+
     master->dc_ref_config = NULL;
     master->dc_ref_clock = NULL;
 
     // init character device
     ret = ec_cdev_init(&master->cdev, master, device_number);
     if (ret)
-        goto out_clear_sync_mon;
+        goto out_clear_dc_monitor;
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 27)
     master->class_device = device_create(class, NULL,
@@ -395,6 +427,8 @@ out_unregister_class_device:
 #endif
 out_clear_cdev:
     ec_cdev_clear(&master->cdev);
+out_clear_dc_monitor:
+    ec_datagram_clear(&master->dc_monitor_datagram);
 out_clear_sync_mon:
     ec_datagram_clear(&master->sync_mon_datagram);
 out_clear_sync64:
@@ -404,9 +438,7 @@ out_clear_sync:
 out_clear_ref_sync:
     ec_datagram_clear(&master->ref_sync_datagram);
 out_clear_ext_datagrams:
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
-        ec_datagram_clear(&master->ext_datagram_ring[i]);
-    }
+    ec_master_ext_ring_clear(master);
     ec_fsm_master_clear(&master->fsm);
     ec_datagram_clear(&master->fsm_datagram);
 out_clear_devices:
@@ -424,7 +456,7 @@ void ec_master_clear(
         ec_master_t *master /**< EtherCAT master */
         )
 {
-    unsigned int dev_idx, i;
+    unsigned int dev_idx;
 
 #ifdef EC_RTDM
     ec_rtdm_dev_clear(&master->rtdm_dev);
@@ -447,15 +479,18 @@ void ec_master_clear(
     ec_master_clear_slave_configs(master);
     ec_master_clear_slaves(master);
     ec_master_clear_sii_images(master);
+    ec_sii_cache_clear(master);
 
+    ec_datagram_clear(&master->dc_monitor_datagram);
+    if (master->dc_monitor_stations) {
+        vfree(master->dc_monitor_stations);
+    }
     ec_datagram_clear(&master->sync_mon_datagram);
     ec_datagram_clear(&master->sync64_datagram);
     ec_datagram_clear(&master->sync_datagram);
     ec_datagram_clear(&master->ref_sync_datagram);
 
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
-        ec_datagram_clear(&master->ext_datagram_ring[i]);
-    }
+    ec_master_ext_ring_clear(master);
 
     ec_fsm_master_clear(&master->fsm);
     ec_datagram_clear(&master->fsm_datagram);
@@ -464,12 +499,8 @@ void ec_master_clear(
             dev_idx++) {
         ec_device_clear(&master->devices[dev_idx]);
     }
-    
-    if (master->pcap_data) {
-        vfree(master->pcap_data);
-        master->pcap_data = NULL;
-        master->pcap_curr_data = NULL;
-    }
+
+    ec_pcap_clear(&master->pcap);
 }
 
 /*****************************************************************************/
@@ -607,9 +638,14 @@ void ec_master_slaves_available(ec_master_t *master)
 void ec_master_clear_slaves(ec_master_t *master)
 {
     ec_slave_t *slave;
+    unsigned int i;
 
     master->dc_ref_clock = NULL;
 
+    // the realtime side must not read the old stations any more
+    master->dc_monitor_station_count = 0;
+    master->dc_monitor_rd_idx_fsm = master->dc_monitor_rd_idx_rt;
+
     // External requests are obsolete, so we wake pending waiters and remove
     // them from the list.
 
@@ -635,6 +671,21 @@ void ec_master_clear_slaves(ec_master_t *master)
         ec_slave_clear(slave);
     }
 
+    // a mailbox status datagram in flight refers to the old ring positions
+    master->mbox_status_datagram = NULL;
+    master->mbox_status_generation++;
+    master->mbox_status_degraded = 0;
+
+    // ESC error counter readings in flight refer to the old slaves
+    memset(master->esc_monitor_readings, 0,
+            sizeof(master->esc_monitor_readings));
+    master->esc_monitor_next = 0;
+
+    // the owners of external datagrams are gone
+    for (i = 0; i < master->ext_ring_size; i++) {
+        master->ext_datagram_ring[i]->ext_owner = NULL;
+    }
+
     if (master->slaves) {
         kfree(master->slaves);
         master->slaves = NULL;
@@ -667,7 +718,9 @@ void ec_master_clear_config(
         )
 {
     ec_lock_down(&master->master_sem);
+    ec_lock_down(&master->rt_sem);
     ec_master_clear_domains(master);
+    ec_lock_up(&master->rt_sem);
     ec_master_clear_slave_configs(master);
     ec_lock_up(&master->master_sem);
 }
@@ -935,6 +988,10 @@ void ec_master_leave_operation_phase(
 /*****************************************************************************/
 
 /** Injects external datagrams that fit into the datagram queue.
+ *
+ * The space left in the send interval is filled with the waiting datagrams,
+ * highest priority first. Datagrams that do not fit are deferred, but do not
+ * hold back smaller datagrams behind them.
  */
 void ec_master_inject_external_datagrams(
         ec_master_t *master /**< EtherCAT master */
@@ -942,15 +999,21 @@ void ec_master_inject_external_datagrams(
 {
     ec_datagram_t *datagram;
     size_t queue_size = 0, new_queue_size = 0;
+    unsigned int idx, idx_end, prio;
 #if DEBUG_INJECT
     unsigned int datagram_count = 0;
 #endif
 
-    if (master->ext_ring_idx_rt == master->ext_ring_idx_fsm) {
+    idx_end = master->ext_ring_idx_fsm;
+    if (master->ext_ring_idx_rt == idx_end) {
         // nothing to inject
         return;
     }
 
+    /* The ring is filled by the slave FSMs without any lock held by this
+     * side. Pairs with the smp_wmb() in ec_master_exec_slave_fsms(). */
+    smp_rmb();
+
     list_for_each_entry(datagram, &master->datagram_queue, queue) {
         if (datagram->state == EC_DATAGRAM_QUEUED) {
             queue_size += datagram->data_size;
@@ -962,82 +1025,89 @@ void ec_master_inject_external_datagrams(
             queue_size);
 #endif
 
-    while (master->ext_ring_idx_rt != master->ext_ring_idx_fsm) {
-        datagram = &master->ext_datagram_ring[master->ext_ring_idx_rt];
+    for (prio = EC_DATAGRAM_PRIO_COUNT; prio-- > 0; ) {
+        for (idx = master->ext_ring_idx_rt; idx != idx_end;
+                idx = (idx + 1) % master->ext_ring_size) {
+            datagram = master->ext_datagram_ring[idx];
 
-        if (datagram->state != EC_DATAGRAM_INIT) {
-            // skip datagram
-            master->ext_ring_idx_rt =
-                (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
-            continue;
-        }
+            if (datagram->state != EC_DATAGRAM_INIT ||
+                    datagram->priority != prio) {
+                continue;
+            }
 
-        new_queue_size = queue_size + datagram->data_size;
-        if (new_queue_size <= master->max_queue_size) {
+            new_queue_size = queue_size + datagram->data_size;
+            if (new_queue_size <= master->max_queue_size) {
 #if DEBUG_INJECT
-            EC_MASTER_DBG(master, 1, "Injecting datagram %s"
-                    " size=%zu, queue_size=%zu\n", datagram->name,
-                    datagram->data_size, new_queue_size);
-            datagram_count++;
+                EC_MASTER_DBG(master, 1, "Injecting datagram %s"
+                        " size=%zu, queue_size=%zu\n", datagram->name,
+                        datagram->data_size, new_queue_size);
+                datagram_count++;
 #endif
 #ifdef EC_HAVE_CYCLES
-            datagram->cycles_sent = 0;
+                datagram->cycles_sent = 0;
 #endif
-            datagram->jiffies_sent = 0;
-            ec_master_queue_datagram(master, datagram);
-            queue_size = new_queue_size;
-        }
-        else if (datagram->data_size > master->max_queue_size) {
-            datagram->state = EC_DATAGRAM_ERROR;
-            EC_MASTER_ERR(master, "External datagram %s is too large,"
-                    " size=%zu, max_queue_size=%zu\n",
-                    datagram->name, datagram->data_size,
-                    master->max_queue_size);
-        }
-        else { // datagram does not fit in the current cycle
+                datagram->jiffies_sent = 0;
+                ec_master_queue_datagram(master, datagram);
+                queue_size = new_queue_size;
+            }
+            else if (datagram->data_size > master->max_queue_size) {
+                datagram->state = EC_DATAGRAM_ERROR;
+                EC_MASTER_ERR(master, "External datagram %s is too large,"
+                        " size=%zu, max_queue_size=%zu\n",
+                        datagram->name, datagram->data_size,
+                        master->max_queue_size);
+            }
+            else { // datagram does not fit in the current cycle
 #ifdef EC_HAVE_CYCLES
-            cycles_t cycles_now = get_cycles();
+                cycles_t cycles_now = get_cycles();
 
-            if (cycles_now - datagram->cycles_sent
-                    > ext_injection_timeout_cycles)
+                if (cycles_now - datagram->cycles_sent
+                        > ext_injection_timeout_cycles)
 #else
-            if (jiffies - datagram->jiffies_sent
-                    > ext_injection_timeout_jiffies)
+                if (jiffies - datagram->jiffies_sent
+                        > ext_injection_timeout_jiffies)
 #endif
-            {
+                {
 #if defined EC_RT_SYSLOG || DEBUG_INJECT
-                unsigned int time_us;
+                    unsigned int time_us;
 #endif
 
-                datagram->state = EC_DATAGRAM_ERROR;
+                    datagram->state = EC_DATAGRAM_ERROR;
 
 #if defined EC_RT_SYSLOG || DEBUG_INJECT
 #ifdef EC_HAVE_CYCLES
-                time_us = (unsigned int)
-                    ((cycles_now - datagram->cycles_sent) * 1000LL)
-                    / cpu_khz;
+                    time_us = (unsigned int)
+                        ((cycles_now - datagram->cycles_sent) * 1000LL)
+                        / cpu_khz;
 #else
-                time_us = (unsigned int)
-                    ((jiffies - datagram->jiffies_sent) * 1000000 / HZ);
+                    time_us = (unsigned int)
+                        ((jiffies - datagram->jiffies_sent) * 1000000 / HZ);
 #endif
-                EC_MASTER_ERR(master, "Timeout %u us: Injecting"
-                        " external datagram %s size=%zu,"
-                        " max_queue_size=%zu\n", time_us, datagram->name,
-                        datagram->data_size, master->max_queue_size);
+                    EC_MASTER_ERR(master, "Timeout %u us: Injecting"
+                            " external datagram %s size=%zu,"
+                            " max_queue_size=%zu\n", time_us,
+                            datagram->name, datagram->data_size,
+                            master->max_queue_size);
 #endif
-            }
-            else {
+                }
 #if DEBUG_INJECT
-                EC_MASTER_DBG(master, 1, "Deferred injecting"
-                        " external datagram %s size=%u, queue_size=%u\n",
-                        datagram->name, datagram->data_size, queue_size);
+                else {
+                    EC_MASTER_DBG(master, 1, "Deferred injecting"
+                            " external datagram %s size=%zu,"
+                            " queue_size=%zu\n", datagram->name,
+                            datagram->data_size, queue_size);
+                }
 #endif
-                break;
             }
         }
+    }
 
+    // release the datagrams up to the first deferred one
+    while (master->ext_ring_idx_rt != idx_end &&
+            master->ext_datagram_ring[master->ext_ring_idx_rt]->state
+            != EC_DATAGRAM_INIT) {
         master->ext_ring_idx_rt =
-            (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
+            (master->ext_ring_idx_rt + 1) % master->ext_ring_size;
     }
 
 #if DEBUG_INJECT
@@ -1055,14 +1125,275 @@ void ec_master_set_send_interval(
         unsigned int send_interval /**< Send interval */
         )
 {
+    unsigned int speed = link_speed ? link_speed : EC_DEFAULT_LINK_SPEED;
+
     master->send_interval = send_interval;
-    master->max_queue_size =
-        (send_interval * 1000) / EC_BYTE_TRANSMISSION_TIME_NS;
+    master->max_queue_size = (size_t) send_interval * speed / 8;
     master->max_queue_size -= master->max_queue_size / 10;
 }
 
 /*****************************************************************************/
 
+/** Resets all latency histograms.
+ */
+void ec_master_reset_latency(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_LATENCY_COUNT; i++) {
+        ec_latency_hist_reset(&master->latency[i]);
+    }
+
+    master->last_send_time = 0;
+}
+
+/*****************************************************************************/
+
+/** Evaluates the datagrams queued for the DC drift compensation controller.
+ *
+ * This is called by ecrt_master_receive(), if the controller is enabled.
+ */
+void ec_master_dc_pll_receive(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_dc_pll_t *pll = &master->dc_pll;
+    ec_datagram_t *datagram = &master->sync64_datagram;
+
+    if (!pll->pending) {
+        return;
+    }
+
+    switch (datagram->state) {
+        case EC_DATAGRAM_QUEUED:
+        case EC_DATAGRAM_SENT:
+            return; // not evaluated yet
+        case EC_DATAGRAM_RECEIVED:
+            if (datagram->working_counter && master->dc_ref_clock) {
+                ec_dc_pll_ref_time(pll, EC_READ_U64(datagram->data) -
+                        master->dc_ref_clock->transmission_delay);
+                break;
+            }
+            // fall through
+        default:
+            ec_dc_pll_missed(pll);
+            break;
+    }
+
+    if (master->sync_mon_datagram.state == EC_DATAGRAM_RECEIVED) {
+        ec_dc_pll_sync_monitor(pll,
+                EC_READ_U32(master->sync_mon_datagram.data) & 0x7fffffff);
+    } else {
+        ec_dc_pll_sync_monitor(pll, 0xffffffff);
+    }
+}
+
+/*****************************************************************************/
+
+/** Number of entries of the DC monitor station table.
+ */
+#define EC_DC_MONITOR_MAX_STATIONS 0x10000
+
+/** Updates the stations read by the DC monitor.
+ *
+ * Called with master_sem held, after the slaves were scanned. The table is
+ * never freed while the master exists, so the realtime side reads at most a
+ * stale station address, if it is updated meanwhile.
+ */
+void ec_master_dc_monitor_update(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    const ec_slave_t *slave;
+    unsigned int count = 0;
+
+    if (!master->dc_monitor_stations) {
+        return; // monitor never enabled
+    }
+
+    master->dc_monitor_station_count = 0;
+    smp_wmb();
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count
+            && count < EC_DC_MONITOR_MAX_STATIONS; slave++) {
+        if (slave->has_dc_system_time) {
+            master->dc_monitor_stations[count++] = slave->station_address;
+        }
+    }
+
+    smp_wmb(); // publish the table before the count
+    master->dc_monitor_station_count = count;
+}
+
+/*****************************************************************************/
+
+/** Sets the DC monitor interval.
+ *
+ * The station table is allocated, when the monitor is enabled for the first
+ * time.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_dc_monitor_enable(
+        ec_master_t *master, /**< EtherCAT master */
+        unsigned int interval /**< Calls between two readings, or zero. */
+        )
+{
+    uint16_t *stations;
+
+    if (interval && !master->dc_monitor_stations) {
+        stations = vmalloc(sizeof(uint16_t) * EC_DC_MONITOR_MAX_STATIONS);
+        if (!stations) {
+            EC_MASTER_ERR(master, "Failed to allocate DC monitor"
+                    " station table.\n");
+            return -ENOMEM;
+        }
+
+        if (ec_lock_down_interruptible(&master->master_sem)) {
+            vfree(stations);
+            return -EINTR;
+        }
+        if (master->dc_monitor_stations) {
+            vfree(stations); // enabled concurrently
+        } else {
+            master->dc_monitor_stations = stations;
+            ec_master_dc_monitor_update(master);
+        }
+        ec_lock_up(&master->master_sem);
+    }
+
+    if (interval != master->dc_monitor_interval) {
+        master->dc_monitor_cycle = 0;
+        smp_wmb(); // publish the station table before enabling
+        master->dc_monitor_interval = interval;
+        EC_MASTER_INFO(master, "DC monitor interval set to %u.\n",
+                interval);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queues the DC monitor datagram, if a reading is due.
+ *
+ * Every dc_monitor_interval calls, the system time difference register of
+ * the next slave with DC system time support is read, so that all slaves
+ * are monitored in turn with a single small datagram.
+ *
+ * This runs in the application's context without master_sem, so only the
+ * station table is used, never the slaves.
+ */
+void ec_master_dc_monitor_queue(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    unsigned int count;
+
+    if (master->dc_monitor_pending) {
+        return; // last reading not evaluated yet
+    }
+
+    if (++master->dc_monitor_cycle < master->dc_monitor_interval) {
+        return;
+    }
+    master->dc_monitor_cycle = 0;
+
+    count = master->dc_monitor_station_count;
+    if (!count) {
+        return;
+    }
+    smp_rmb(); // see ec_master_dc_monitor_update()
+
+    if (master->dc_monitor_next >= count) {
+        master->dc_monitor_next = 0;
+    }
+    master->dc_monitor_station =
+        master->dc_monitor_stations[master->dc_monitor_next++];
+
+    // always succeeds, because the datagram is pre-allocated
+    ec_datagram_fprd(&master->dc_monitor_datagram,
+            master->dc_monitor_station, 0x092c, 4);
+    ec_datagram_zero(&master->dc_monitor_datagram);
+    ec_master_queue_datagram(master, &master->dc_monitor_datagram);
+    master->dc_monitor_pending = 1;
+}
+
+/*****************************************************************************/
+
+/** Evaluates the DC monitor datagram.
+ *
+ * This is called by ecrt_master_receive(), if a reading is pending. The
+ * reading is passed to the master thread, which adds it to the statistics
+ * of the slave (see ec_master_dc_monitor_process()). If the master thread
+ * did not keep up, the reading is dropped.
+ */
+void ec_master_dc_monitor_receive(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_datagram_t *datagram = &master->dc_monitor_datagram;
+    unsigned int idx = master->dc_monitor_rd_idx_rt,
+                 next = (idx + 1) % EC_DC_MONITOR_READINGS;
+
+    switch (datagram->state) {
+        case EC_DATAGRAM_QUEUED:
+        case EC_DATAGRAM_SENT:
+            return; // not evaluated yet
+        case EC_DATAGRAM_RECEIVED:
+            if (datagram->working_counter == 1
+                    && next != master->dc_monitor_rd_idx_fsm) {
+                master->dc_monitor_readings[idx].station_address =
+                    master->dc_monitor_station;
+                master->dc_monitor_readings[idx].value =
+                    EC_READ_U32(datagram->data);
+                smp_wmb(); // publish the reading before the index
+                master->dc_monitor_rd_idx_rt = next;
+            }
+            break;
+        default:
+            break;
+    }
+
+    master->dc_monitor_pending = 0;
+}
+
+/*****************************************************************************/
+
+/** Adds the DC monitor readings to the statistics of the slaves.
+ *
+ * Called with master_sem held.
+ */
+static void ec_master_dc_monitor_process(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_slave_t *slave;
+    unsigned int idx;
+
+    while ((idx = master->dc_monitor_rd_idx_fsm) !=
+            master->dc_monitor_rd_idx_rt) {
+        smp_rmb(); // see ec_master_dc_monitor_receive()
+
+        for (slave = master->slaves;
+                slave < master->slaves + master->slave_count; slave++) {
+            if (slave->station_address ==
+                    master->dc_monitor_readings[idx].station_address) {
+                ec_dc_stats_add(&slave->dc_stats,
+                        master->dc_monitor_readings[idx].value);
+                break;
+            }
+        }
+
+        master->dc_monitor_rd_idx_fsm = (idx + 1) % EC_DC_MONITOR_READINGS;
+    }
+}
+
+/*****************************************************************************/
+
 /** Requests that all slaves on this master be rebooted (if supported).
  */
 void ec_master_reboot_slaves(
@@ -1074,7 +1405,165 @@ void ec_master_reboot_slaves(
 
 /*****************************************************************************/
 
+/** Checks, if an external datagram is still in use.
+ *
+ * Slave FSMs run independently of each other, so the ring may wrap around a
+ * datagram that is still in flight or whose response was not evaluated yet
+ * by its FSM. Each user sets itself as the owner of the datagram, until it
+ * has evaluated the response.
+ *
+ * \return Non-zero, if the datagram must not be reused.
+ */
+static int ec_master_external_datagram_busy(
+        const ec_master_t *master, /**< EtherCAT master */
+        const ec_datagram_t *datagram /**< Datagram of the external ring. */
+        )
+{
+    if (datagram->state == EC_DATAGRAM_QUEUED ||
+            datagram->state == EC_DATAGRAM_SENT) {
+        return 1;
+    }
+
+    if (datagram->state == EC_DATAGRAM_INVALID) {
+        return 0;
+    }
+
+    return datagram->ext_owner != NULL;
+}
+
+/*****************************************************************************/
+
+/** Checks, if a datagram belongs to the external datagram ring.
+ *
+ * \return Non-zero, if the datagram is part of the ring.
+ */
+int ec_master_is_external_datagram(
+        const ec_master_t *master, /**< EtherCAT master */
+        const ec_datagram_t *datagram /**< Datagram to check. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < master->ext_ring_size; i++) {
+        if (master->ext_datagram_ring[i] == datagram) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Allocates external datagrams, until the ring has the given size.
+ *
+ * Must only be called while the ring is empty, i. e. the realtime side has
+ * nothing to inject. The realtime side reads the ring size only after it
+ * found new datagrams in the ring.
+ *
+ * \return Zero on success, otherwise a negative error code. The ring keeps
+ *         the datagrams that could be allocated.
+ */
+static int ec_master_ext_ring_grow(
+        ec_master_t *master, /**< EtherCAT master */
+        unsigned int size /**< New ring size. */
+        )
+{
+    ec_datagram_t *datagram;
+    int ret;
+
+    while (master->ext_ring_size < size) {
+        datagram = kmalloc(sizeof(ec_datagram_t), GFP_KERNEL);
+        if (!datagram) {
+            EC_MASTER_ERR(master, "Failed to allocate external"
+                    " datagram %u.\n", master->ext_ring_size);
+            return -ENOMEM;
+        }
+
+        ec_datagram_init(datagram);
+        snprintf(datagram->name, EC_DATAGRAM_NAME_SIZE, "ext-%u",
+                master->ext_ring_size);
+        ret = ec_datagram_prealloc(datagram, EC_MAX_DATA_SIZE);
+        if (ret) {
+            EC_MASTER_ERR(master, "Failed to allocate external"
+                    " datagram %u.\n", master->ext_ring_size);
+            ec_datagram_clear(datagram);
+            kfree(datagram);
+            return ret;
+        }
+
+        master->ext_datagram_ring[master->ext_ring_size++] = datagram;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Frees the external datagram ring.
+ */
+static void ec_master_ext_ring_clear(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    while (master->ext_ring_size) {
+        ec_datagram_t *datagram =
+            master->ext_datagram_ring[--master->ext_ring_size];
+        ec_datagram_clear(datagram);
+        kfree(datagram);
+    }
+}
+
+/*****************************************************************************/
+
+/** Adapts the size of the external datagram ring to the bus.
+ *
+ * The ring shall be large enough for two datagrams of every slave FSM that
+ * may run concurrently (see ec_master_slave_fsm_window()), and the same
+ * number again for deferred datagrams. If slave FSMs nevertheless found no
+ * free datagram, it is doubled. The ring never shrinks.
+ *
+ * The ring is only resized while the realtime side has nothing to inject,
+ * and only from the master threads, so that no allocation happens in the
+ * application context.
+ */
+static void ec_master_ext_ring_adjust(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    size_t fsms = master->max_queue_size / EC_FSM_SLAVE_DATAGRAM_SIZE;
+    size_t size;
+
+    if (fsms > master->slave_count) {
+        fsms = master->slave_count;
+    }
+
+    size = 4 * fsms;
+    if (master->ext_ring_starved && size < 2 * master->ext_ring_size) {
+        size = 2 * master->ext_ring_size;
+    }
+    size = roundup(size, EC_EXT_RING_GROW_STEP);
+    if (size > EC_EXT_RING_MAX_SIZE) {
+        size = EC_EXT_RING_MAX_SIZE;
+    }
+
+    if (size <= master->ext_ring_size ||
+            master->ext_ring_idx_rt != master->ext_ring_idx_fsm) {
+        return;
+    }
+
+    EC_MASTER_DBG(master, 1, "Growing external datagram ring"
+            " from %u to %zu datagrams.\n", master->ext_ring_size, size);
+    ec_master_ext_ring_grow(master, size);
+    master->ext_ring_starved = 0;
+}
+
+/*****************************************************************************/
+
 /** Searches for a free datagram in the external datagram ring.
+ *
+ * Datagrams that are still in use are skipped. This is safe, because the
+ * injection only picks up datagrams in the EC_DATAGRAM_INIT state.
  *
  * \return Next free datagram, or NULL.
  */
@@ -1082,10 +1571,17 @@ ec_datagram_t *ec_master_get_external_datagram(
         ec_master_t *master /**< EtherCAT master */
         )
 {
-    if ((master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE !=
+    while ((master->ext_ring_idx_fsm + 1) % master->ext_ring_size !=
             master->ext_ring_idx_rt) {
         ec_datagram_t *datagram =
-            &master->ext_datagram_ring[master->ext_ring_idx_fsm];
+            master->ext_datagram_ring[master->ext_ring_idx_fsm];
+
+        if (ec_master_external_datagram_busy(master, datagram)) {
+            master->ext_ring_idx_fsm =
+                (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
+            continue;
+        }
+
         /* Record the queued time for ec_master_inject_external_datagrams */
 #ifdef EC_HAVE_CYCLES
         datagram->cycles_sent = get_cycles();
@@ -1094,9 +1590,9 @@ ec_datagram_t *ec_master_get_external_datagram(
 
         return datagram;
     }
-    else {
-        return NULL;
-    }
+
+    master->ext_ring_starved = 1;
+    return NULL;
 }
 
 /*****************************************************************************/
@@ -1123,6 +1619,7 @@ void ec_master_queue_datagram(
             EC_MASTER_DBG(master, 1,
                     "Datagram %p already queued (skipping).\n", datagram);
 #endif
+            ec_datagram_release_index(datagram);
             datagram->state = EC_DATAGRAM_QUEUED;
             return;
         }
@@ -1148,19 +1645,171 @@ void ec_master_queue_datagram_ext(
     ec_lock_up(&master->ext_queue_sem);
 }
 
-/*****************************************************************************/
+/*****************************************************************************/
+
+/** Looks up a sent datagram via its index.
+ *
+ * Entries of the lookup table may be outdated, if a datagram was
+ * re-initialized or re-queued after sending. So the datagram's state and
+ * index are checked, too.
+ *
+ * \return Sent datagram with the given index, or NULL.
+ */
+static inline ec_datagram_t *ec_master_lookup_datagram(
+        ec_master_t *master, /**< EtherCAT master */
+        uint8_t index /**< Datagram index. */
+        )
+{
+    ec_datagram_t *datagram = master->datagram_lookup[index];
+
+    if (datagram && datagram->state == EC_DATAGRAM_SENT
+            && datagram->index == index) {
+        return datagram;
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Enters a sent datagram into the index lookup table.
+ */
+static inline void ec_master_register_datagram(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< Sent datagram. */
+        )
+{
+    ec_datagram_release_index(datagram);
+    master->datagram_lookup[datagram->index] = datagram;
+    datagram->lookup_entry = &master->datagram_lookup[datagram->index];
+}
+
+/*****************************************************************************/
+
+/** Assigns an index to a datagram that is about to be sent.
+ *
+ * The index of a pending datagram is not reused to avoid confusion in
+ * ec_master_receive_datagrams().
+ *
+ * \retval       0 Success.
+ * \retval -EBUSY No free index.
+ */
+static int ec_master_assign_datagram_index(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< Datagram to send. */
+        )
+{
+    uint8_t last_index = master->datagram_index;
+
+    while (ec_master_lookup_datagram(master, master->datagram_index)) {
+        if (++master->datagram_index == last_index) {
+            EC_MASTER_ERR(master, "No free datagram index, sending delayed\n");
+            return -EBUSY;
+        }
+    }
+
+    datagram->index = master->datagram_index++;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Estimates the number of datagrams the master FSM may send at once.
+ *
+ * All datagrams in flight share the 8 bit index space. Indices of sent
+ * datagrams are in use, and all datagrams of the external ring may be in
+ * flight at the same time, so their number is reserved. Half of the rest is
+ * left to the cyclic datagrams of the application.
+ *
+ * The lookup table is read without io_sem, so this is only an estimate.
+ *
+ * \return Number of datagrams, at least one.
+ */
+unsigned int ec_master_fsm_datagram_budget(
+        const ec_master_t *master /**< EtherCAT master */
+        )
+{
+    unsigned int i, free = 0;
+
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        const ec_datagram_t *datagram = master->datagram_lookup[i];
+
+        if (!datagram || datagram->state != EC_DATAGRAM_SENT
+                || datagram->index != i) {
+            free++;
+        }
+    }
+
+    if (free <= master->ext_ring_size + 2) {
+        return 1;
+    }
+
+    return (free - master->ext_ring_size) / 2;
+}
+
+/*****************************************************************************/
+
+/** Sends the queued datagrams that have a dedicated transmit frame.
+ *
+ * The datagram contents are already in place, so only the index and the
+ * working counter have to be written.
+ *
+ * A dedicated frame is only reused, if its last transmission was received
+ * and the network stack released it. Otherwise the datagram stays queued and
+ * is copied into a frame of the transmit ring, like any other datagram.
+ *
+ * \return Number of bytes sent, including preamble and inter-frame gap.
+ */
+static size_t ec_master_send_datagram_frames(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index /**< Device index. */
+        )
+{
+    ec_datagram_t *datagram;
+    size_t sent_bytes = 0;
+
+    list_for_each_entry(datagram, &master->datagram_queue, queue) {
+        if (!datagram->tx_frame || datagram->state != EC_DATAGRAM_QUEUED ||
+                datagram->device_index != device_index) {
+            continue;
+        }
+
+        if (datagram->tx_frame_pending || skb_shared(datagram->tx_frame)) {
+            continue; // still in flight
+        }
+
+        if (ec_master_assign_datagram_index(master, datagram)) {
+            break;
+        }
+
+        EC_WRITE_U8(datagram->data - EC_DATAGRAM_HEADER_SIZE + 1,
+                datagram->index);
+        EC_WRITE_U16(datagram->data + datagram->data_size, 0x0000);
 
-static int index_in_use(ec_master_t *master, uint8_t index)
-{
-    ec_datagram_t *datagram;
-    list_for_each_entry(datagram, &master->datagram_queue, queue)
-        if (datagram->state == EC_DATAGRAM_SENT && datagram->index == index)
-            return 1;
-    return 0;
+        ec_device_send_frame(&master->devices[device_index],
+                datagram->tx_frame, datagram->tx_frame_size);
+        sent_bytes += ETH_HLEN + datagram->tx_frame_size + ETH_FCS_LEN + 20;
+        datagram->tx_frame_pending = 1;
+
+        ec_master_register_datagram(master, datagram);
+        datagram->state = EC_DATAGRAM_SENT;
+#ifdef EC_HAVE_CYCLES
+        datagram->cycles_sent = get_cycles();
+#endif
+        datagram->jiffies_sent = jiffies;
+        datagram->app_time_sent = master->app_time;
+    }
+
+    return sent_bytes;
 }
 
+/*****************************************************************************/
+
 /** Sends the datagrams in the queue for a certain device.
  *
+ * Each frame is filled with the cyclic datagrams in the order they were
+ * queued. The space left is filled with the other datagrams that fit,
+ * highest priority first, before another frame is started.
  */
 size_t ec_master_send_datagrams(
         ec_master_t *master, /**< EtherCAT master */
@@ -1175,10 +1824,9 @@ size_t ec_master_send_datagrams(
     cycles_t cycles_start, cycles_sent, cycles_end;
 #endif
     unsigned long jiffies_sent;
-    unsigned int frame_count, more_datagrams_waiting;
+    unsigned int frame_count, more_datagrams_waiting, prio;
     struct list_head sent_datagrams;
-    size_t sent_bytes = 0;
-    uint8_t last_index;
+    size_t sent_bytes;
 
 #ifdef EC_HAVE_CYCLES
     cycles_start = get_cycles();
@@ -1189,71 +1837,72 @@ size_t ec_master_send_datagrams(
     EC_MASTER_DBG(master, 2, "%s(device_index = %u)\n",
             __func__, device_index);
 
+    sent_bytes = ec_master_send_datagram_frames(master, device_index);
+
     do {
         frame_data = NULL;
         follows_word = NULL;
         more_datagrams_waiting = 0;
 
         // fill current frame with datagrams
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->state != EC_DATAGRAM_QUEUED ||
-                    datagram->device_index != device_index) {
-                continue;
-            }
+        for (prio = EC_DATAGRAM_PRIO_COUNT; prio-- > 0; ) {
+            list_for_each_entry(datagram, &master->datagram_queue, queue) {
+                if (datagram->state != EC_DATAGRAM_QUEUED ||
+                        datagram->device_index != device_index ||
+                        datagram->priority != prio) {
+                    continue;
+                }
 
-            if (!frame_data) {
-                // fetch pointer to transmit socket buffer
-                frame_data =
-                    ec_device_tx_data(&master->devices[device_index]);
-                cur_data = frame_data + EC_FRAME_HEADER_SIZE;
-            }
+                if (!frame_data) {
+                    // fetch pointer to transmit socket buffer
+                    frame_data =
+                        ec_device_tx_data(&master->devices[device_index]);
+                    cur_data = frame_data + EC_FRAME_HEADER_SIZE;
+                }
 
-            // does the current datagram fit in the frame?
-            datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
-                + EC_DATAGRAM_FOOTER_SIZE;
-            if (cur_data - frame_data + datagram_size > ETH_DATA_LEN) {
-                more_datagrams_waiting = 1;
-                break;
-            }
+                // does the current datagram fit in the frame?
+                datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+                    + EC_DATAGRAM_FOOTER_SIZE;
+                if (cur_data - frame_data + datagram_size > ETH_DATA_LEN) {
+                    more_datagrams_waiting = 1;
+                    if (prio == EC_DATAGRAM_PRIO_CYCLIC) {
+                        break; // keep the order of cyclic datagrams
+                    }
+                    continue;
+                }
 
-            // do not reuse the index of a pending datagram to avoid confusion
-            // in ec_master_receive_datagrams()
-            last_index = master->datagram_index;
-            while (index_in_use(master, master->datagram_index)) {
-                if (++master->datagram_index == last_index) {
-                    EC_MASTER_ERR(master, "No free datagram index, sending delayed\n");
+                if (ec_master_assign_datagram_index(master, datagram)) {
                     goto break_send;
                 }
-            }
-            datagram->index = master->datagram_index++;
 
-            list_add_tail(&datagram->sent, &sent_datagrams);
+                list_add_tail(&datagram->sent, &sent_datagrams);
 
-            EC_MASTER_DBG(master, 2, "Adding datagram 0x%02X\n",
-                    datagram->index);
+                EC_MASTER_DBG(master, 2, "Adding datagram 0x%02X\n",
+                        datagram->index);
 
-            // set "datagram following" flag in previous datagram
-            if (follows_word) {
-                EC_WRITE_U16(follows_word,
-                        EC_READ_U16(follows_word) | 0x8000);
-            }
+                // set "datagram following" flag in previous datagram
+                if (follows_word) {
+                    EC_WRITE_U16(follows_word,
+                            EC_READ_U16(follows_word) | 0x8000);
+                }
 
-            // EtherCAT datagram header
-            EC_WRITE_U8 (cur_data, datagram->type);
-            EC_WRITE_U8 (cur_data + 1, datagram->index);
-            memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
-            EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
-            EC_WRITE_U16(cur_data + 8, 0x0000);
-            follows_word = cur_data + 6;
-            cur_data += EC_DATAGRAM_HEADER_SIZE;
-
-            // EtherCAT datagram data
-            memcpy(cur_data, datagram->data, datagram->data_size);
-            cur_data += datagram->data_size;
-
-            // EtherCAT datagram footer
-            EC_WRITE_U16(cur_data, 0x0000); // reset working counter
-            cur_data += EC_DATAGRAM_FOOTER_SIZE;
+                // EtherCAT datagram header
+                EC_WRITE_U8 (cur_data, datagram->type);
+                EC_WRITE_U8 (cur_data + 1, datagram->index);
+                memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+                EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+                EC_WRITE_U16(cur_data + 8, 0x0000);
+                follows_word = cur_data + 6;
+                cur_data += EC_DATAGRAM_HEADER_SIZE;
+
+                // EtherCAT datagram data
+                memcpy(cur_data, datagram->data, datagram->data_size);
+                cur_data += datagram->data_size;
+
+                // EtherCAT datagram footer
+                EC_WRITE_U16(cur_data, 0x0000); // reset working counter
+                cur_data += EC_DATAGRAM_FOOTER_SIZE;
+            }
         }
 
 break_send:
@@ -1284,6 +1933,7 @@ break_send:
 
         // set datagram states and sending timestamps
         list_for_each_entry_safe(datagram, next, &sent_datagrams, sent) {
+            ec_master_register_datagram(master, datagram);
             datagram->state = EC_DATAGRAM_SENT;
 #ifdef EC_HAVE_CYCLES
             datagram->cycles_sent = cycles_sent;
@@ -1394,17 +2044,11 @@ void ec_master_receive_datagrams(
             return;
         }
 
-        // search for matching datagram in the queue
-        matched = 0;
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->index == datagram_index
-                && datagram->state == EC_DATAGRAM_SENT
-                && datagram->type == datagram_type
-                && datagram->data_size == data_size) {
-                matched = 1;
-                break;
-            }
-        }
+        // search for matching datagram in the lookup table
+        datagram = ec_master_lookup_datagram(master, datagram_index);
+        matched = datagram
+            && datagram->type == datagram_type
+            && datagram->data_size == data_size;
 
         // no matching datagram was found
         if (!matched) {
@@ -1427,6 +2071,10 @@ void ec_master_receive_datagrams(
             continue;
         }
 
+        // frames are transmitted in order, so an earlier transmission of
+        // the dedicated frame has left the device as well
+        datagram->tx_frame_pending = 0;
+
         if (datagram->type != EC_DATAGRAM_APWR &&
                 datagram->type != EC_DATAGRAM_FPWR &&
                 datagram->type != EC_DATAGRAM_BWR &&
@@ -1567,9 +2215,22 @@ void ec_master_receive_datagrams(
         datagram->jiffies_received =
             master->devices[EC_DEVICE_MAIN].jiffies_poll;
 
-        barrier(); /* reordering might lead to races */
+#ifdef EC_HAVE_CYCLES
+        ec_latency_hist_add_span(&master->latency[EC_LATENCY_RTT],
+                datagram->cycles_sent, datagram->cycles_received);
+#else
+        ec_latency_hist_add(&master->latency[EC_LATENCY_RTT],
+                min(jiffies_to_usecs(datagram->jiffies_received
+                        - datagram->jiffies_sent), 4294967U) * 1000);
+#endif
+
+        /* Reordering might lead to races. The state machines read the
+         * datagram without the master lock, so order the data before the
+         * state. Pairs with the smp_rmb() in the state machine execution. */
+        smp_wmb();
 
         // dequeue the received datagram
+        ec_datagram_release_index(datagram);
         datagram->state = EC_DATAGRAM_RECEIVED;
         list_del_init(&datagram->queue);
     }
@@ -1770,7 +2431,361 @@ void ec_master_nanosleep(const unsigned long nsecs)
 
 /*****************************************************************************/
 
+/** Calculates the number of slave FSMs that may execute concurrently.
+ *
+ * Every executing slave FSM has at most one datagram in flight. The number
+ * is limited by half of the external datagram ring (to leave room for
+ * deferred datagrams) and by the amount of data that can be injected in one
+ * send interval.
+ *
+ * \return Maximum number of slave FSMs in the execution list.
+ */
+static unsigned int ec_master_slave_fsm_window(
+        const ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    size_t window = master->max_queue_size / EC_FSM_SLAVE_DATAGRAM_SIZE;
+
+    if (window < 1) {
+        window = 1;
+    } else if (window > master->ext_ring_size / 2) {
+        window = master->ext_ring_size / 2;
+    }
+
+    return window;
+}
+
+/*****************************************************************************/
+
+/** Evaluates the mailbox status datagram.
+ *
+ * Mailbox checks that were prepared before the datagram was sent are
+ * answered with the sync manager status of their slave, as if they had been
+ * sent as FPRD. If the datagram was lost or incomplete, they time out, so
+ * that their FSMs retry.
+ */
+static void ec_master_mbox_status_process(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_datagram_t *datagram = master->mbox_status_datagram;
+    ec_fsm_slave_t *fsm;
+    int received;
+
+    if (!datagram || datagram->state == EC_DATAGRAM_INIT ||
+            datagram->state == EC_DATAGRAM_QUEUED ||
+            datagram->state == EC_DATAGRAM_SENT) {
+        return;
+    }
+
+    master->mbox_status_datagram = NULL;
+    datagram->ext_owner = NULL;
+    received = datagram->state == EC_DATAGRAM_RECEIVED;
+
+    /* A working counter mismatch is only meaningful, if no mapping changed
+     * while the datagram was in flight. */
+    if (received && master->mbox_status_sent_generation ==
+            master->mbox_status_generation) {
+        if (datagram->working_counter != master->mbox_status_expected) {
+            if (!master->mbox_status_degraded) {
+                EC_MASTER_WARN(master, "Mailbox status incomplete"
+                        " (working counter %u/%u). Checking mailboxes"
+                        " per slave.\n", datagram->working_counter,
+                        master->mbox_status_expected);
+                master->mbox_status_degraded = 1;
+            }
+            received = 0;
+        } else if (master->mbox_status_degraded) {
+            EC_MASTER_INFO(master, "Mailbox status complete again.\n");
+            master->mbox_status_degraded = 0;
+        }
+    }
+
+    list_for_each_entry(fsm, &master->fsm_exec_list, list) {
+        ec_slave_t *slave = fsm->slave;
+        ec_datagram_t *check = slave->mbox_status_check;
+
+        if (!check || slave->mbox_status_seq == master->mbox_status_seq) {
+            // nothing pending, or prepared after the datagram was sent
+            continue;
+        }
+
+        slave->mbox_status_check = NULL;
+
+        if (!received || slave->ring_position >= datagram->data_size) {
+            check->state = EC_DATAGRAM_TIMED_OUT;
+            continue;
+        }
+
+        EC_WRITE_U8(check->data + 5,
+                EC_READ_U8(datagram->data + slave->ring_position));
+        check->working_counter = 1;
+#ifdef EC_HAVE_CYCLES
+        check->cycles_sent = datagram->cycles_sent;
+        check->cycles_received = datagram->cycles_received;
+#endif
+        check->jiffies_sent = datagram->jiffies_sent;
+        check->jiffies_received = datagram->jiffies_received;
+        check->state = EC_DATAGRAM_RECEIVED;
+    }
+}
+
+/*****************************************************************************/
+
+/** Sends the mailbox status datagram.
+ *
+ * A single LRD reads the mapped sync manager status bytes of all slaves. It
+ * is only sent while mailbox checks are waiting for it, or, while slave
+ * FSMs are busy, to find out if a degraded mailbox status area is complete
+ * again.
+ */
+static void ec_master_mbox_status_queue(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_datagram_t *datagram;
+    const ec_fsm_slave_t *fsm;
+    const ec_slave_t *slave;
+    unsigned int waiting, expected = 0;
+
+    if (master->mbox_status_datagram) {
+        return; // still in flight
+    }
+
+    waiting = master->mbox_status_degraded && master->fsm_exec_count;
+    list_for_each_entry(fsm, &master->fsm_exec_list, list) {
+        if (fsm->slave->mbox_status_check) {
+            waiting = 1;
+            break;
+        }
+    }
+
+    if (!waiting) {
+        return;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (slave->mbox_status_mapped) {
+            expected++;
+        }
+    }
+
+    if (!expected) {
+        master->mbox_status_degraded = 0;
+        return;
+    }
+
+    datagram = ec_master_get_external_datagram(master);
+    if (!datagram) {
+        return; // retry on next execution
+    }
+
+    if (ec_datagram_lrd(datagram, EC_MBOX_STATUS_ADDRESS,
+                min_t(size_t, master->slave_count,
+                    EC_MBOX_STATUS_MAX_SLAVES))) {
+        return;
+    }
+    ec_datagram_zero(datagram);
+    datagram->device_index = EC_DEVICE_MAIN;
+    datagram->priority = EC_DATAGRAM_PRIO_HIGH;
+
+    datagram->ext_owner = master;
+    master->mbox_status_datagram = datagram;
+    master->mbox_status_seq++;
+    master->mbox_status_expected = expected;
+    master->mbox_status_sent_generation = master->mbox_status_generation;
+
+    smp_wmb(); // publish datagram contents before the index
+    master->ext_ring_idx_fsm =
+        (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
+}
+
+/*****************************************************************************/
+
+/** Evaluates the ESC error counter readings that are done.
+ */
+static void ec_master_esc_monitor_process(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int i, port, events;
+
+    for (i = 0; i < EC_ESC_MONITOR_READINGS; i++) {
+        datagram = master->esc_monitor_readings[i].datagram;
+
+        if (!datagram || datagram->state == EC_DATAGRAM_INIT ||
+                datagram->state == EC_DATAGRAM_QUEUED ||
+                datagram->state == EC_DATAGRAM_SENT) {
+            continue;
+        }
+
+        smp_rmb(); // see ec_master_exec_slave_fsms()
+
+        slave = master->esc_monitor_readings[i].slave;
+        master->esc_monitor_readings[i].datagram = NULL;
+        datagram->ext_owner = NULL;
+
+        if (datagram->state != EC_DATAGRAM_RECEIVED ||
+                datagram->working_counter !=
+                (datagram->type == EC_DATAGRAM_FPRW ? 3 : 1)) {
+            slave->esc_stats.failures++;
+            continue;
+        }
+
+        events = ec_esc_stats_update(&slave->esc_stats, datagram->data,
+                master->esc_monitor_readings[i].clear,
+                master->esc_monitor_threshold);
+
+        for (port = 0; port < EC_MAX_PORTS; port++) {
+            const ec_esc_port_stats_t *ps = &slave->esc_stats.ports[port];
+
+            if (events & (1 << port)) {
+                EC_SLAVE_WARN(slave, "Port %u: %u errors per minute,"
+                        " %u lost links.\n", port, ps->rate,
+                        ps->lost_links);
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Queues readings of the ESC error counters.
+ *
+ * Every esc_monitor_interval ms, the error counter registers of all slaves
+ * are read. The readings are low-priority external datagrams, so they are
+ * only injected into the space the cyclic datagrams leave in the frames.
+ * They are only queued as far as the slave FSMs leave room in the execution
+ * window.
+ *
+ * Counters close to saturation are read and cleared at once with an FPRW.
+ */
+static void ec_master_esc_monitor_queue(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int i, busy = 0, window = ec_master_slave_fsm_window(master);
+    int ret;
+
+    if (!master->esc_monitor_interval || master->scan_busy) {
+        return;
+    }
+
+    if (master->esc_monitor_next >= master->slave_count) {
+        if (jiffies - master->esc_monitor_start <
+                msecs_to_jiffies(master->esc_monitor_interval)) {
+            return;
+        }
+        // start a new sweep
+        master->esc_monitor_start = jiffies;
+        master->esc_monitor_next = 0;
+    }
+
+    for (i = 0; i < EC_ESC_MONITOR_READINGS; i++) {
+        if (master->esc_monitor_readings[i].datagram) {
+            busy++;
+        }
+    }
+
+    for (i = 0; i < EC_ESC_MONITOR_READINGS
+            && master->esc_monitor_next < master->slave_count; i++) {
+        if (master->esc_monitor_readings[i].datagram) {
+            continue;
+        }
+
+        if (master->fsm_exec_count + busy >= window) {
+            return; // no room left by the slave FSMs
+        }
+
+        datagram = ec_master_get_external_datagram(master);
+        if (!datagram) {
+            return; // retry on next execution
+        }
+
+        slave = master->slaves + master->esc_monitor_next;
+        if (slave->esc_stats.clear) {
+            ret = ec_datagram_fprw(datagram, slave->station_address,
+                    EC_ESC_ERRORS_ADDRESS, EC_ESC_ERRORS_SIZE);
+        } else {
+            ret = ec_datagram_fprd(datagram, slave->station_address,
+                    EC_ESC_ERRORS_ADDRESS, EC_ESC_ERRORS_SIZE);
+        }
+        if (ret) {
+            return;
+        }
+        ec_datagram_zero(datagram);
+        datagram->device_index = slave->device_index;
+        datagram->priority = EC_DATAGRAM_PRIO_LOW;
+
+        datagram->ext_owner = &master->esc_monitor_readings[i];
+        master->esc_monitor_readings[i].datagram = datagram;
+        master->esc_monitor_readings[i].slave = slave;
+        master->esc_monitor_readings[i].clear = slave->esc_stats.clear;
+        master->esc_monitor_next++;
+        busy++;
+
+        smp_wmb(); // publish datagram contents before the index
+        master->ext_ring_idx_fsm =
+            (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
+    }
+}
+
+/*****************************************************************************/
+
+/** Executes the register request channel of a slave FSM.
+ *
+ * \return Non-zero, if a register datagram is still in use.
+ */
+static int ec_master_exec_slave_reg(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_fsm_slave_t *fsm /**< Slave FSM. */
+        )
+{
+    ec_datagram_t *datagram;
+
+    if (fsm->reg_datagram) {
+        if (fsm->reg_datagram->state == EC_DATAGRAM_INIT ||
+                fsm->reg_datagram->state == EC_DATAGRAM_QUEUED ||
+                fsm->reg_datagram->state == EC_DATAGRAM_SENT) {
+            return 1;
+        }
+        smp_rmb(); // see ec_master_exec_slave_fsms()
+    } else if (!ec_fsm_slave_reg_pending(fsm)) {
+        return 0;
+    }
+
+    datagram = ec_master_get_external_datagram(master);
+    if (!datagram) {
+        // retry on next execution
+        return fsm->reg_datagram != NULL;
+    }
+
+    if (!ec_fsm_slave_exec_reg(fsm, datagram)) {
+        return 0;
+    }
+
+    smp_wmb(); // publish datagram contents before the index
+    master->ext_ring_idx_fsm =
+        (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
+    return 1;
+}
+
+/*****************************************************************************/
+
 /** Execute slave FSMs.
+ *
+ * Slave FSMs are executed independently of each other: an FSM waiting for
+ * its datagram does not hold back the others. New FSMs are admitted in a
+ * round-robin manner as long as the execution window allows.
+ *
+ * Register requests do not use the mailbox, so each FSM may have a second
+ * datagram in flight for them. An FSM stays in the execution list until
+ * both are done.
  */
 void ec_master_exec_slave_fsms(
         ec_master_t *master /**< EtherCAT master. */
@@ -1778,32 +2793,38 @@ void ec_master_exec_slave_fsms(
 {
     ec_datagram_t *datagram;
     ec_fsm_slave_t *fsm, *next;
-    unsigned int count = 0;
+    unsigned int count = 0, window = ec_master_slave_fsm_window(master);
+    int reg_busy;
+
+    ec_master_mbox_status_process(master);
+    ec_master_esc_monitor_process(master);
+    ec_master_dc_monitor_process(master);
 
     list_for_each_entry_safe(fsm, next, &master->fsm_exec_list, list) {
-        if (!fsm->datagram) {
-            EC_MASTER_WARN(master, "Slave %s-%u FSM has zero datagram."
-                    "This is a bug!\n", ec_device_names[fsm->slave->device_index!=0],
-                    fsm->slave->ring_position);
-            list_del_init(&fsm->list);
-            master->fsm_exec_count--;
-            return;
-        }
+        reg_busy = ec_master_exec_slave_reg(master, fsm);
 
-        if (fsm->datagram->state == EC_DATAGRAM_INIT ||
+        if (fsm->datagram && (fsm->datagram->state == EC_DATAGRAM_INIT ||
                 fsm->datagram->state == EC_DATAGRAM_QUEUED ||
-                fsm->datagram->state == EC_DATAGRAM_SENT) {
+                fsm->datagram->state == EC_DATAGRAM_SENT)) {
             // previous datagram was not sent or received yet.
-            // wait until next thread execution
-            return;
+            // check again on next thread execution
+            continue;
         }
 
+        /* The datagram was received by the realtime side without the master
+         * lock. Pairs with the smp_wmb() in ec_master_receive_datagrams(). */
+        smp_rmb();
+
         datagram = ec_master_get_external_datagram(master);
         if (!datagram) {
-            // no free datagrams at the moment
-            EC_MASTER_WARN(master, "No free datagram during"
-                    " slave FSM execution. This is a bug!\n");
-            continue;
+            // no free datagrams at the moment, retry on next execution,
+            // starting with this FSM, so that all FSMs get their turn
+            list_move_tail(&master->fsm_exec_list, &fsm->list);
+#if DEBUG_INJECT
+            EC_MASTER_DBG(master, 1, "No free datagram during"
+                    " slave FSM execution.\n");
+#endif
+            return;
         }
 
 #if DEBUG_INJECT
@@ -1818,11 +2839,12 @@ void ec_master_exec_slave_fsms(
                 EC_MASTER_DBG(master, 1, "FSM consumed datagram %s\n",
                         datagram->name);
 #endif
+                smp_wmb(); // publish datagram contents before the index
                 master->ext_ring_idx_fsm =
-                    (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
+                    (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
             }
         }
-        else {
+        else if (!reg_busy) {
             // FSM finished
             list_del_init(&fsm->list);
             master->fsm_exec_count--;
@@ -1833,17 +2855,26 @@ void ec_master_exec_slave_fsms(
         }
     }
 
-    while (master->fsm_exec_count < EC_EXT_RING_SIZE / 2
+    while (master->fsm_exec_count < window
             && count < master->slave_count) {
 
-        if (ec_fsm_slave_is_ready(&master->fsm_slave->fsm)) {
+        fsm = &master->fsm_slave->fsm;
+
+        if (ec_fsm_slave_is_ready(fsm) && list_empty(&fsm->list)) {
             datagram = ec_master_get_external_datagram(master);
+            if (!datagram) {
+                break;
+            }
 
-            if (ec_fsm_slave_exec(&master->fsm_slave->fsm, datagram)) {
+            if (ec_fsm_slave_exec(fsm, datagram)) {
                 if (datagram->state != EC_DATAGRAM_INVALID) {
+                    smp_wmb(); // publish datagram contents before the index
                     master->ext_ring_idx_fsm =
-                        (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
+                        (master->ext_ring_idx_fsm + 1) % master->ext_ring_size;
                 }
+            }
+
+            if (ec_master_exec_slave_reg(master, fsm) || fsm->datagram) {
                 list_add_tail(&master->fsm_slave->fsm.list,
                         &master->fsm_exec_list);
                 master->fsm_exec_count++;
@@ -1863,6 +2894,9 @@ void ec_master_exec_slave_fsms(
         }
         count++;
     }
+
+    ec_master_mbox_status_queue(master);
+    ec_master_esc_monitor_queue(master);
 }
 
 /*****************************************************************************/
@@ -1898,6 +2932,7 @@ static int ec_master_idle_thread(void *priv_data)
         fsm_exec = ec_fsm_master_exec(&master->fsm);
 
         // idle thread will still be in charge of calling the slave requests
+        ec_master_ext_ring_adjust(master);
         ec_master_exec_slave_fsms(master);
 
         ec_lock_up(&master->master_sem);
@@ -1905,7 +2940,7 @@ static int ec_master_idle_thread(void *priv_data)
         // queue and send
         ec_lock_down(&master->io_sem);
         if (fsm_exec) {
-            ec_master_queue_datagram(master, &master->fsm_datagram);
+            ec_fsm_master_queue_datagrams(&master->fsm);
         }
         sent_bytes = ecrt_master_send(master);
         ec_lock_up(&master->io_sem);
@@ -1919,8 +2954,9 @@ static int ec_master_idle_thread(void *priv_data)
 #endif
         } else {
 #ifdef EC_USE_HRTIMER
-            ec_master_nanosleep(
-                    sent_bytes * EC_BYTE_TRANSMISSION_TIME_NS * 6 / 5);
+            ec_master_nanosleep(sent_bytes * 8000 /
+                    (link_speed ? link_speed : EC_DEFAULT_LINK_SPEED)
+                    * 6 / 5);
 #else
             schedule();
 #endif
@@ -1959,9 +2995,12 @@ static int ec_master_operation_thread(void *priv_data)
             if (ec_fsm_master_exec(&master->fsm)) {
                 // Inject datagrams (let the RT thread queue them, see
                 // ecrt_master_send())
+                smp_wmb();
                 master->injection_seq_fsm++;
             }
 
+            ec_master_ext_ring_adjust(master);
+
             // if rt_slave_requests is true and the slaves are available
             // this will be handled by the app explicitly calling
             // ecrt_master_exec_slave_request()
@@ -2870,6 +3909,9 @@ int ecrt_master_activate(ec_master_t *master)
     master->injection_seq_fsm = 0;
     master->injection_seq_rt = 0;
 
+    // the histograms shall only cover the operation phase
+    ec_master_reset_latency(master);
+
     master->send_cb = master->app_send_cb;
     master->receive_cb = master->app_receive_cb;
     master->cb_data = master->app_cb_data;
@@ -2979,6 +4021,7 @@ void ecrt_master_deactivate(ec_master_t *master)
     master->app_time = 0ULL;
     master->dc_ref_time = 0ULL;
     master->dc_offset_valid = 0;
+    ec_dc_pll_init(&master->dc_pll);
 
     /* Disallow scanning to get into the same state like after a master
      * request (after ec_master_enter_operation_phase() is called). */
@@ -3002,11 +4045,20 @@ size_t ecrt_master_send(ec_master_t *master)
     ec_datagram_t *datagram, *n;
     ec_device_index_t dev_idx;
     size_t sent_bytes = 0;
+    ec_latency_time_t now = ec_latency_time();
 
+    if (master->last_send_time) {
+        ec_latency_hist_add_span(
+                &master->latency[EC_LATENCY_SEND_INTERVAL],
+                master->last_send_time, now);
+    }
+    master->last_send_time = now;
 
     if (master->injection_seq_rt != master->injection_seq_fsm) {
         // inject datagram produced by master FSM
-        ec_master_queue_datagram(master, &master->fsm_datagram);
+        smp_rmb();
+        ec_fsm_master_queue_datagrams(&master->fsm);
+        smp_wmb();
         master->injection_seq_rt = master->injection_seq_fsm;
     }
 
@@ -3019,6 +4071,7 @@ size_t ecrt_master_send(ec_master_t *master)
             list_for_each_entry_safe(datagram, n,
                     &master->datagram_queue, queue) {
                 if (datagram->device_index == dev_idx) {
+                    ec_datagram_release_index(datagram);
                     datagram->state = EC_DATAGRAM_ERROR;
                     list_del_init(&datagram->queue);
                 }
@@ -3070,6 +4123,7 @@ void ecrt_master_receive(ec_master_t *master)
                 datagram->jiffies_sent > timeout_jiffies) {
 #endif
             list_del_init(&datagram->queue);
+            ec_datagram_release_index(datagram);
             datagram->state = EC_DATAGRAM_TIMED_OUT;
             master->stats.timeouts++;
 
@@ -3094,6 +4148,14 @@ void ecrt_master_receive(ec_master_t *master)
 #endif /* RT_SYSLOG */
         }
     }
+
+    if (unlikely(master->dc_pll.config.mode != EC_DC_PLL_OFF)) {
+        ec_master_dc_pll_receive(master);
+    }
+
+    if (unlikely(master->dc_monitor_pending)) {
+        ec_master_dc_monitor_receive(master);
+    }
 }
 
 /*****************************************************************************/
@@ -3355,6 +4417,10 @@ void ecrt_master_application_time(ec_master_t *master, uint64_t app_time)
 {
     master->app_time = app_time;
 
+    if (master->dc_pll.config.mode == EC_DC_PLL_REF_CLOCK) {
+        ec_dc_pll_app_time(&master->dc_pll, app_time);
+    }
+
     if (unlikely(!master->dc_ref_time)) {
         master->dc_ref_time = app_time;
     }
@@ -3388,7 +4454,12 @@ int ecrt_master_reference_clock_time(ec_master_t *master, uint32_t *time)
 void ecrt_master_sync_reference_clock(ec_master_t *master)
 {
     if (master->dc_ref_clock && master->dc_offset_valid) {
-        EC_WRITE_U32(master->ref_sync_datagram.data, master->app_time);
+        if (master->dc_pll.config.mode == EC_DC_PLL_REF_CLOCK
+                && master->dc_pll.started) {
+            EC_WRITE_U32(master->ref_sync_datagram.data, master->dc_pll.time);
+        } else {
+            EC_WRITE_U32(master->ref_sync_datagram.data, master->app_time);
+        }
         ec_master_queue_datagram(master, &master->ref_sync_datagram);
     }
 }
@@ -3413,6 +4484,18 @@ void ecrt_master_sync_slave_clocks(ec_master_t *master)
     if (master->dc_ref_clock && master->dc_offset_valid) {
         ec_datagram_zero(&master->sync_datagram);
         ec_master_queue_datagram(master, &master->sync_datagram);
+
+        if (master->dc_pll.config.mode != EC_DC_PLL_OFF) {
+            ec_datagram_zero(&master->sync64_datagram);
+            ec_master_queue_datagram(master, &master->sync64_datagram);
+            ec_datagram_zero(&master->sync_mon_datagram);
+            ec_master_queue_datagram(master, &master->sync_mon_datagram);
+            ec_dc_pll_queued(&master->dc_pll, master->app_time);
+        }
+
+        if (unlikely(master->dc_monitor_interval)) {
+            ec_master_dc_monitor_queue(master);
+        }
     }
 }
 
@@ -3470,6 +4553,35 @@ uint32_t ecrt_master_sync_monitor_process(ec_master_t *master)
 
 /*****************************************************************************/
 
+int ecrt_master_dc_pll_config(ec_master_t *master,
+        const ec_dc_pll_config_t *config)
+{
+    int ret;
+
+    ret = ec_dc_pll_configure(&master->dc_pll, config);
+    if (ret) {
+        EC_MASTER_ERR(master, "Invalid DC controller configuration.\n");
+        return ret;
+    }
+
+    EC_MASTER_DBG(master, 1, "DC controller mode %u, period %u ns,"
+            " kp %u, ki %u, filter shift %u.\n",
+            master->dc_pll.config.mode, master->dc_pll.config.period_ns,
+            master->dc_pll.config.kp, master->dc_pll.config.ki,
+            master->dc_pll.config.filter_shift);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_dc_pll_state(ec_master_t *master, ec_dc_pll_state_t *state)
+{
+    ec_dc_pll_state(&master->dc_pll, state);
+    return 0;
+}
+
+/*****************************************************************************/
+
 int ecrt_master_sdo_download(ec_master_t *master, uint16_t slave_position,
         uint16_t index, uint8_t subindex, const uint8_t *data,
         size_t data_size, uint32_t *abort_code)
@@ -4691,6 +5803,8 @@ EXPORT_SYMBOL(ecrt_master_64bit_reference_clock_time_queue);
 EXPORT_SYMBOL(ecrt_master_64bit_reference_clock_time);
 EXPORT_SYMBOL(ecrt_master_sync_monitor_queue);
 EXPORT_SYMBOL(ecrt_master_sync_monitor_process);
+EXPORT_SYMBOL(ecrt_master_dc_pll_config);
+EXPORT_SYMBOL(ecrt_master_dc_pll_state);
 EXPORT_SYMBOL(ecrt_master_sdo_download);
 EXPORT_SYMBOL(ecrt_master_sdo_download_complete);
 EXPORT_SYMBOL(ecrt_master_sdo_upload);
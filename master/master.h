@@ -49,6 +49,9 @@
 #include "fsm_master.h"
 #include "locks.h"
 #include "cdev.h"
+#include "latency.h"
+#include "dc_pll.h"
+#include "pcap.h"
 
 #ifdef EC_RTDM
 #include "rtdm.h"
@@ -112,12 +115,50 @@
     } while (0)
 
 
-/** Size of the external datagram ring.
+/** Initial size of the external datagram ring.
  *
- * The external datagram ring is used for slave FSMs.
+ * The external datagram ring is used for slave FSMs. It grows with the
+ * number of slave FSMs that can run concurrently.
  */
 #define EC_EXT_RING_SIZE 32
 
+/** Maximum size of the external datagram ring.
+ *
+ * More datagrams can not be in flight anyway, see EC_DATAGRAM_INDEX_COUNT.
+ */
+#define EC_EXT_RING_MAX_SIZE 256
+
+/** Granularity the external datagram ring grows with.
+ */
+#define EC_EXT_RING_GROW_STEP 16
+
+/** Estimated bus footprint of a single slave FSM datagram in byte.
+ *
+ * Slave FSMs mostly exchange register accesses and mailbox telegrams with a
+ * common mailbox size of 128 byte. This is used to derive the number of slave
+ * FSMs that may run concurrently from the maximum queue size.
+ */
+#define EC_FSM_SLAVE_DATAGRAM_SIZE \
+    (EC_DATAGRAM_HEADER_SIZE + 128 + EC_DATAGRAM_FOOTER_SIZE)
+
+/** Number of datagram indices.
+ *
+ * The datagram index is an 8 bit value. This is the size of the lookup table
+ * for datagrams that were sent and are waiting to be received.
+ */
+#define EC_DATAGRAM_INDEX_COUNT 256
+
+/** Maximum number of ESC error counter readings in flight.
+ *
+ * The readings of the ESC monitor only use the space left by the slave
+ * FSMs, so this is just an upper limit.
+ */
+#define EC_ESC_MONITOR_READINGS 8
+
+/** Maximum number of DC monitor readings waiting to be evaluated.
+ */
+#define EC_DC_MONITOR_READINGS 16
+
 /** return flag from ecrt_master_eoe_process() to indicate there is
  * something to send.  if this flag is set call ecrt_master_send_ext()
  */
@@ -215,6 +256,10 @@ struct ec_master {
 #endif
 
     ec_lock_t master_sem; /**< Master semaphore. */
+    ec_lock_t rt_sem; /**< Serializes the application's cyclic calls
+                        (send, receive, domain processing). Never taken by
+                        the master threads, so the realtime path does not
+                        wait for state machine execution. */
 
     ec_device_t devices[EC_MAX_NUM_DEVICES]; /**< EtherCAT devices. */
     const uint8_t *macs[EC_MAX_NUM_DEVICES]; /**< Device MAC addresses. */
@@ -245,6 +290,7 @@ struct ec_master {
 
     /* Configuration applied during bus scanning. */
     struct list_head sii_images; /**< List of slave SII images. */
+    struct list_head sii_cache; /**< Persistent SII cache entries. */
 
     u64 app_time; /**< Time of the last ecrt_master_sync() call. */
     u64 dc_ref_time; /**< Common reference timestamp for DC start times. */
@@ -260,6 +306,36 @@ struct ec_master {
     ec_slave_config_t *dc_ref_config; /**< Application-selected DC reference
                                         clock slave config. */
     ec_slave_t *dc_ref_clock; /**< DC reference clock slave. */
+    ec_dc_pll_t dc_pll; /**< DC drift compensation controller. */
+    unsigned int dc_monitor_interval; /**< Number of
+                                        ecrt_master_sync_slave_clocks()
+                                        calls between two system time
+                                        difference readings. Zero disables
+                                        the DC monitor. */
+    unsigned int dc_monitor_cycle; /**< Calls since the last reading. */
+    uint16_t *dc_monitor_stations; /**< Station addresses of the slaves with
+                                     DC system time. The realtime side reads
+                                     these instead of the slaves, which may
+                                     be rescanned at any time. Allocated
+                                     when the monitor is first enabled, for
+                                     all possible station addresses. */
+    unsigned int dc_monitor_station_count; /**< Number of valid entries in
+                                             \a dc_monitor_stations. */
+    unsigned int dc_monitor_next; /**< Index of the next station to read. */
+    ec_datagram_t dc_monitor_datagram; /**< Datagram for reading the system
+                                         time difference of one slave. */
+    unsigned int dc_monitor_pending; /**< The DC monitor datagram is queued
+                                       and not evaluated yet. */
+    uint16_t dc_monitor_station; /**< Station read by the DC monitor
+                                   datagram. */
+    struct {
+        uint16_t station_address; /**< Station address of the slave. */
+        uint32_t value; /**< System time difference register value. */
+    } dc_monitor_readings[EC_DC_MONITOR_READINGS]; /**< Readings passed from
+                                                     the realtime side to the
+                                                     master thread. */
+    unsigned int dc_monitor_rd_idx_rt; /**< Next reading to write. */
+    unsigned int dc_monitor_rd_idx_fsm; /**< Next reading to evaluate. */
 
     unsigned int reboot; /**< Reboot requested. */
     unsigned int scan_busy; /**< Current scan state. */
@@ -277,14 +353,20 @@ struct ec_master {
 
     struct list_head datagram_queue; /**< Datagram queue. */
     uint8_t datagram_index; /**< Current datagram index. */
+    ec_datagram_t *datagram_lookup[EC_DATAGRAM_INDEX_COUNT]; /**< Sent
+                                                 datagrams by index. */
 
     struct list_head ext_datagram_queue; /**< Queue for non-application
                                            datagrams. */
     ec_lock_t ext_queue_sem; /**< Semaphore protecting the \a
                                       ext_datagram_queue. */
 
-    ec_datagram_t ext_datagram_ring[EC_EXT_RING_SIZE]; /**< External datagram
-                                                         ring. */
+    ec_datagram_t *ext_datagram_ring[EC_EXT_RING_MAX_SIZE]; /**< External
+                                                        datagram ring. */
+    unsigned int ext_ring_size; /**< Number of datagrams in the external
+                                  datagram ring. */
+    unsigned int ext_ring_starved; /**< Slave FSMs found no free datagram
+                                     since the ring was adjusted. */
     unsigned int ext_ring_idx_rt; /**< Index in external datagram ring for RT
                                     side. */
     unsigned int ext_ring_idx_fsm; /**< Index in external datagram ring for
@@ -307,11 +389,46 @@ struct ec_master {
     struct list_head fsm_exec_list; /**< Slave FSM execution list. */
     unsigned int fsm_exec_count; /**< Number of entries in execution list. */
 
+    ec_datagram_t *mbox_status_datagram; /**< External datagram reading the
+                                           mailbox status area, or NULL. */
+    unsigned int mbox_status_seq; /**< Number of mailbox status datagrams
+                                    sent. */
+    unsigned int mbox_status_generation; /**< Incremented, whenever the
+                                           mailbox status of a slave is
+                                           (un-)mapped. */
+    unsigned int mbox_status_sent_generation; /**< Generation, when the
+                                                mailbox status datagram was
+                                                sent. */
+    unsigned int mbox_status_expected; /**< Expected working counter of the
+                                         mailbox status datagram. */
+    unsigned int mbox_status_degraded; /**< The mailbox status datagram was
+                                         incomplete, so the mailbox states
+                                         are checked per slave. */
+
+    unsigned int esc_monitor_interval; /**< Interval between two sweeps of
+                                         the ESC error counters in ms. Zero
+                                         disables the ESC monitor. */
+    uint32_t esc_monitor_threshold; /**< Errors per minute, from which on a
+                                      slave port raises an event. */
+    unsigned long esc_monitor_start; /**< Start of the last sweep
+                                       [jiffies]. */
+    unsigned int esc_monitor_next; /**< Position of the next slave to read
+                                     in the current sweep. */
+    struct {
+        ec_datagram_t *datagram; /**< External datagram, or NULL. */
+        ec_slave_t *slave; /**< Slave, whose counters are read. */
+        int clear; /**< The datagram clears the counters. */
+    } esc_monitor_readings[EC_ESC_MONITOR_READINGS]; /**< ESC error counter
+                                                       readings in flight. */
+
     unsigned int debug_level; /**< Master debug level. */
     ec_stats_t stats; /**< Cyclic statistics. */
+    ec_latency_hist_t latency[EC_LATENCY_COUNT]; /**< Latency
+                                                   histograms. */
+    ec_latency_time_t last_send_time; /**< Time of the last call of
+                                        ecrt_master_send(), or zero. */
 
-    void *pcap_data; /**< pcap debug output memory pointer */
-    void *pcap_curr_data; /**< pcap debug output current memory pointer */
+    ec_pcap_t pcap; /**< Frame capture ring. */
 
     struct task_struct *thread; /**< Master thread. */
 
@@ -376,9 +493,18 @@ void ec_master_receive_datagrams(ec_master_t *, ec_device_t *,
         const uint8_t *, size_t);
 void ec_master_queue_datagram(ec_master_t *, ec_datagram_t *);
 void ec_master_queue_datagram_ext(ec_master_t *, ec_datagram_t *);
+int ec_master_is_external_datagram(const ec_master_t *,
+        const ec_datagram_t *);
+unsigned int ec_master_fsm_datagram_budget(const ec_master_t *);
 
 // misc.
 void ec_master_set_send_interval(ec_master_t *, unsigned int);
+void ec_master_reset_latency(ec_master_t *);
+void ec_master_dc_pll_receive(ec_master_t *);
+void ec_master_dc_monitor_queue(ec_master_t *);
+void ec_master_dc_monitor_receive(ec_master_t *);
+void ec_master_dc_monitor_update(ec_master_t *);
+int ec_master_dc_monitor_enable(ec_master_t *, unsigned int);
 void ec_master_attach_slave_configs(ec_master_t *);
 void ec_master_expire_slave_config_requests(ec_master_t *);
 ec_slave_t *ec_master_find_slave(ec_master_t *, uint16_t, uint16_t);
@@ -439,6 +565,8 @@ extern unsigned int eoe_count; // see module.c
 extern bool eoe_autocreate; // see module.c
 #endif
 extern unsigned long pcap_size;  // see module.c
+extern bool zero_copy_domains;  // see module.c
+extern unsigned int link_speed;  // see module.c
 
 /*****************************************************************************/
 
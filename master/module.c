@@ -65,6 +65,9 @@ bool eoe_autocreate = 1;  /**< Auto-create EOE interfaces. */
 #endif
 static unsigned int debug_level;  /**< Debug level parameter. */
 unsigned long pcap_size;  /**< Pcap buffer size in bytes. */
+bool zero_copy_domains;  /**< Keep domain data in dedicated frames. */
+unsigned int link_speed = EC_DEFAULT_LINK_SPEED;  /**< Link speed in
+                                                    Mbit/s. */
 
 static ec_master_t *masters; /**< Array of masters. */
 static ec_lock_t master_sem; /**< Master semaphore. */
@@ -98,7 +101,11 @@ MODULE_PARM_DESC(eoe_autocreate, "EOE atuo create mode");
 module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "Debug level");
 module_param_named(pcap_size, pcap_size, ulong, S_IRUGO);
-MODULE_PARM_DESC(pcap_size, "Pcap buffer size");
+MODULE_PARM_DESC(pcap_size, "Pcap ring size (rounded down to a power of 2)");
+module_param_named(zero_copy_domains, zero_copy_domains, bool, S_IRUGO);
+MODULE_PARM_DESC(zero_copy_domains, "Keep domain data in transmit frames");
+module_param_named(link_speed, link_speed, uint, S_IRUGO);
+MODULE_PARM_DESC(link_speed, "Link speed in Mbit/s");
 
 /** \endcond */
 
@@ -0,0 +1,420 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Frame capture ring.
+*/
+
+/****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/log2.h>
+#include <linux/vmalloc.h>
+#include <linux/uaccess.h>
+#include <linux/if_ether.h>
+
+#include "pcap.h"
+
+/****************************************************************************/
+
+/** Number of attempts of a reader to copy records, before giving up because
+ * the writer keeps overwriting them.
+ */
+#define EC_PCAP_READ_ATTEMPTS 4
+
+/****************************************************************************/
+
+static void ec_pcap_work(struct work_struct *);
+
+/****************************************************************************/
+
+/** Initializes the capture ring.
+ *
+ * The ring size is rounded down to a power of two. A size of zero disables
+ * capturing.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_pcap_init(
+        ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long size /**< Requested ring size in bytes. */
+        )
+{
+    memset(pcap, 0, sizeof(*pcap));
+    pcap->directions = EC_PCAP_TX | EC_PCAP_RX;
+    pcap->types = EC_PCAP_TYPES_ALL;
+    init_waitqueue_head(&pcap->wait);
+    INIT_DELAYED_WORK(&pcap->work, ec_pcap_work);
+
+    if (!size) {
+        return 0;
+    }
+
+    size = rounddown_pow_of_two(size);
+    pcap->data = vmalloc(size);
+    if (!pcap->data) {
+        return -ENOMEM;
+    }
+
+    pcap->size = size;
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Frees the capture ring.
+ */
+void ec_pcap_clear(
+        ec_pcap_t *pcap /**< Capture ring. */
+        )
+{
+    cancel_delayed_work_sync(&pcap->work);
+
+    if (pcap->data) {
+        vfree(pcap->data);
+        pcap->data = NULL;
+    }
+    pcap->size = 0;
+}
+
+/****************************************************************************/
+
+/** Copies data into the ring, wrapping around at the end.
+ */
+static void ec_pcap_put(
+        ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long pos, /**< Ring position. */
+        const void *source, /**< Source data. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    unsigned long offset = pos & (pcap->size - 1);
+    size_t first = min_t(size_t, size, pcap->size - offset);
+
+    memcpy(pcap->data + offset, source, first);
+    memcpy(pcap->data, (const u8 *) source + first, size - first);
+}
+
+/****************************************************************************/
+
+/** Copies data out of the ring, wrapping around at the end.
+ */
+static void ec_pcap_get(
+        const ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long pos, /**< Ring position. */
+        void *target, /**< Target memory. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    unsigned long offset = pos & (pcap->size - 1);
+    size_t first = min_t(size_t, size, pcap->size - offset);
+
+    memcpy(target, pcap->data + offset, first);
+    memcpy((u8 *) target + first, pcap->data, size - first);
+}
+
+/****************************************************************************/
+
+/** Copies data out of the ring to user space, wrapping around at the end.
+ *
+ * \return Zero on success, otherwise -EFAULT.
+ */
+static int ec_pcap_get_user(
+        const ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long pos, /**< Ring position. */
+        u8 __user *target, /**< User space target. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    unsigned long offset = pos & (pcap->size - 1);
+    size_t first = min_t(size_t, size, pcap->size - offset);
+
+    if (copy_to_user(target, pcap->data + offset, first)
+            || copy_to_user(target + first, pcap->data, size - first)) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Checks, if an EtherCAT frame contains a datagram of one of the given
+ * types.
+ *
+ * \return Non-zero, if the frame matches.
+ */
+static int ec_pcap_match_types(
+        u32 types, /**< Datagram type mask. */
+        const u8 *data, /**< Frame data including the Ethernet header. */
+        size_t size /**< Frame size. */
+        )
+{
+    size_t offset = ETH_HLEN + EC_FRAME_HEADER_SIZE;
+    u16 len_flags;
+    u8 type;
+
+    if (types == EC_PCAP_TYPES_ALL) {
+        return 1;
+    }
+
+    while (offset + EC_DATAGRAM_HEADER_SIZE <= size) {
+        type = data[offset];
+        if (type < 32 && (types & (1 << type))) {
+            return 1;
+        }
+
+        len_flags = EC_READ_U16(data + offset + 6);
+        if (!(len_flags & 0x8000)) { // last datagram
+            break;
+        }
+        offset += EC_DATAGRAM_HEADER_SIZE + (len_flags & 0x07FF)
+            + EC_DATAGRAM_FOOTER_SIZE;
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Records a frame.
+ *
+ * Called from the master's send and receive path only, so there is never
+ * more than one writer at a time. Never blocks; the oldest records are
+ * dropped, if there is not enough room. Waiting readers are woken up by
+ * ec_pcap_work().
+ */
+void ec_pcap_record(
+        ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned int direction, /**< #EC_PCAP_TX or #EC_PCAP_RX. */
+        const struct timespec64 *ts, /**< Timestamp. */
+        const void *data, /**< Frame data including the Ethernet header. */
+        size_t size /**< Frame size. */
+        )
+{
+    pcaprec_hdr_t hdr, old;
+    unsigned long head, tail, need;
+    u32 snaplen;
+
+    if (!(READ_ONCE(pcap->directions) & direction)
+            || !ec_pcap_match_types(READ_ONCE(pcap->types), data, size)) {
+        pcap->filtered++;
+        return;
+    }
+
+    snaplen = READ_ONCE(pcap->snaplen);
+    hdr.ts_sec = ts->tv_sec;
+    hdr.ts_nsec = ts->tv_nsec;
+    hdr.incl_len = snaplen && size > snaplen ? snaplen : size;
+    hdr.orig_len = size;
+
+    need = sizeof(hdr) + hdr.incl_len;
+    if (unlikely(need > pcap->size)) {
+        pcap->filtered++;
+        return;
+    }
+
+    head = pcap->head;
+    tail = pcap->tail;
+    if (head - tail + need > pcap->size) {
+        do {
+            ec_pcap_get(pcap, tail, &old, sizeof(old));
+            tail += sizeof(old) + old.incl_len;
+            pcap->overwritten++;
+        } while (head - tail + need > pcap->size);
+
+        // readers must see the new tail before any overwritten data
+        WRITE_ONCE(pcap->tail, tail);
+        smp_wmb();
+    }
+
+    ec_pcap_put(pcap, head, &hdr, sizeof(hdr));
+    ec_pcap_put(pcap, head + sizeof(hdr), data, hdr.incl_len);
+
+    // publish the record
+    smp_wmb();
+    WRITE_ONCE(pcap->head, head + need);
+    pcap->frames++;
+}
+
+/****************************************************************************/
+
+/** Worker waking up the readers, if there are new records.
+ *
+ * Runs once per jiffy, as long as readers are waiting.
+ */
+static void ec_pcap_work(
+        struct work_struct *work /**< Work structure. */
+        )
+{
+    ec_pcap_t *pcap = container_of(work, ec_pcap_t, work.work);
+    unsigned long head = READ_ONCE(pcap->head);
+
+    if (head != pcap->notified) {
+        pcap->notified = head;
+        wake_up_interruptible(&pcap->wait);
+    }
+
+    if (waitqueue_active(&pcap->wait)) {
+        schedule_delayed_work(&pcap->work, 1);
+    }
+}
+
+/****************************************************************************/
+
+/** Makes sure, that waiting readers are woken up on new records.
+ *
+ * Called by a reader after adding itself to the wait queue. Starts the
+ * worker, if it is not running.
+ */
+void ec_pcap_watch(
+        ec_pcap_t *pcap /**< Capture ring. */
+        )
+{
+    schedule_delayed_work(&pcap->work, 1);
+}
+
+/****************************************************************************/
+
+/** Returns the number of bytes available for a reader.
+ *
+ * \return Number of bytes between the reader position (or the oldest record,
+ *         if that was overwritten) and the newest record.
+ */
+unsigned long ec_pcap_pending(
+        const ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long pos /**< Reader position. */
+        )
+{
+    unsigned long head = READ_ONCE(pcap->head);
+    unsigned long tail = READ_ONCE(pcap->tail);
+
+    if ((long) (pos - tail) < 0) {
+        pos = tail;
+    }
+
+    return head - pos;
+}
+
+/****************************************************************************/
+
+/** Copies complete records from the ring to user space.
+ *
+ * Records, that were overwritten before they could be read, are skipped and
+ * accounted in \a lost. On success, \a pos is advanced behind the last
+ * copied record.
+ *
+ * \retval 0 Success (\a copied may be zero, if there are no new records).
+ * \retval -ENOSPC The next record does not fit into \a size bytes.
+ * \retval -EAGAIN The writer overwrote the records on every attempt.
+ * \retval -EFAULT Copying to user space failed.
+ */
+int ec_pcap_read(
+        ec_pcap_t *pcap, /**< Capture ring. */
+        unsigned long *pos, /**< Reader position. */
+        u8 __user *target, /**< User space target. */
+        size_t size, /**< Size of \a target. */
+        size_t *copied, /**< Number of bytes copied. */
+        unsigned long *lost /**< Number of bytes skipped. */
+        )
+{
+    unsigned long head, tail, start, end, next;
+    pcaprec_hdr_t hdr;
+    unsigned int attempt;
+
+    *copied = 0;
+    *lost = 0;
+
+    for (attempt = 0; attempt < EC_PCAP_READ_ATTEMPTS; attempt++) {
+        head = READ_ONCE(pcap->head);
+        smp_rmb();
+        tail = READ_ONCE(pcap->tail);
+
+        start = *pos;
+        if ((long) (start - tail) < 0) {
+            *lost += tail - start;
+            start = tail;
+        }
+        if ((long) (head - start) < 0) { // writer passed the head read above
+            *pos = start;
+            continue;
+        }
+
+        // collect as many complete records as fit into the target
+        end = start;
+        while (end != head) {
+            ec_pcap_get(pcap, end, &hdr, sizeof(hdr));
+            next = end + sizeof(hdr) + hdr.incl_len;
+            if ((long) (head - next) < 0 || next - start > size) {
+                break;
+            }
+            end = next;
+        }
+
+        if (end != start && ec_pcap_get_user(pcap, start, target,
+                    end - start)) {
+            return -EFAULT;
+        }
+
+        // check, that the writer did not overwrite the records meanwhile
+        smp_rmb();
+        tail = READ_ONCE(pcap->tail);
+        if ((long) (start - tail) < 0) {
+            *pos = start;
+            continue;
+        }
+
+        *pos = end;
+        if (end == start && end != head) {
+            return -ENOSPC;
+        }
+
+        *copied = end - start;
+        return 0;
+    }
+
+    return -EAGAIN;
+}
+
+/****************************************************************************/
+
+/** Fills in the pcap global header for the ring's records.
+ */
+void ec_pcap_header(
+        const ec_pcap_t *pcap, /**< Capture ring. */
+        pcap_hdr_t *hdr /**< Global header. */
+        )
+{
+    u32 snaplen = READ_ONCE(pcap->snaplen);
+
+    hdr->magic_number = EC_PCAP_MAGIC_NSEC;
+    hdr->version_major = 2;
+    hdr->version_minor = 4;
+    hdr->thiszone = 0;
+    hdr->sigfigs = 0;
+    hdr->snaplen = snaplen && snaplen < EC_PCAP_MAX_SNAPLEN ?
+        snaplen : EC_PCAP_MAX_SNAPLEN;
+    hdr->network = 1; // LINKTYPE_ETHERNET
+}
+
+/****************************************************************************/
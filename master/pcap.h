@@ -0,0 +1,124 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Frame capture ring.
+*/
+
+/****************************************************************************/
+
+#ifndef __EC_PCAP_H__
+#define __EC_PCAP_H__
+
+#include <linux/types.h>
+#include <linux/time.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+
+#include "globals.h"
+
+/****************************************************************************/
+
+/** pcap global header.
+ */
+typedef struct {
+    u32 magic_number;   /* magic number */
+    u16 version_major;  /* major version number */
+    u16 version_minor;  /* minor version number */
+    s32 thiszone;       /* GMT to local correction */
+    u32 sigfigs;        /* accuracy of timestamps */
+    u32 snaplen;        /* max length of captured packets, in octets */
+    u32 network;        /* data link type */
+} pcap_hdr_t;
+
+/****************************************************************************/
+
+/** pcap packet header.
+ */
+typedef struct {
+    u32 ts_sec;         /* timestamp seconds */
+    u32 ts_nsec;        /* timestamp nanoseconds */
+    u32 incl_len;       /* number of octets of packet saved in file */
+    u32 orig_len;       /* actual length of packet */
+} pcaprec_hdr_t;
+
+/****************************************************************************/
+
+/** Magic number of pcap files with nanosecond timestamps. */
+#define EC_PCAP_MAGIC_NSEC 0xa1b23c4d
+
+/** Largest snapshot length announced in the pcap global header. */
+#define EC_PCAP_MAX_SNAPLEN 65535
+
+/****************************************************************************/
+
+/** Frame capture ring.
+ *
+ * The ring holds complete pcap records (header and frame data). Positions
+ * are free-running byte counters, the ring offset is the position modulo
+ * \a size, which is a power of two.
+ *
+ * There is a single writer, the master's send and receive path, which never
+ * blocks: If there is not enough room for a new record, the oldest records
+ * are dropped by advancing \a tail. Readers do not take any locks either.
+ * They copy the records between their position and \a head and check
+ * afterwards, that \a tail did not pass their position in the meantime.
+ *
+ * The writer does not wake up readers, because that takes the lock of the
+ * wait queue in realtime context. Instead, a worker checks \a head once per
+ * jiffy, while readers are waiting (see ec_pcap_watch()).
+ */
+typedef struct {
+    u8 *data; /**< Ring memory, or NULL if capturing is disabled. */
+    unsigned long size; /**< Ring size in bytes (power of two). */
+    unsigned long head; /**< Position behind the newest record. */
+    unsigned long tail; /**< Position of the oldest complete record. */
+    unsigned long start; /**< Position, from which on snapshots are
+                           taken. */
+    u32 snaplen; /**< Maximum number of bytes captured per frame, or zero
+                   for complete frames. */
+    u32 directions; /**< Captured directions (#EC_PCAP_TX, #EC_PCAP_RX). */
+    u32 types; /**< Bit mask of captured datagram types (bit n for type n).
+                 A frame is captured, if any of its datagrams matches. */
+    u64 frames; /**< Number of captured frames. */
+    u64 filtered; /**< Number of frames rejected by the filters. */
+    u64 overwritten; /**< Number of records dropped to make room. */
+    wait_queue_head_t wait; /**< Readers waiting for new records. */
+    struct delayed_work work; /**< Worker waking up the readers. */
+    unsigned long notified; /**< \a head at the last wakeup. */
+} ec_pcap_t;
+
+/****************************************************************************/
+
+int ec_pcap_init(ec_pcap_t *, unsigned long);
+void ec_pcap_clear(ec_pcap_t *);
+void ec_pcap_record(ec_pcap_t *, unsigned int, const struct timespec64 *,
+        const void *, size_t);
+void ec_pcap_watch(ec_pcap_t *);
+unsigned long ec_pcap_pending(const ec_pcap_t *, unsigned long);
+int ec_pcap_read(ec_pcap_t *, unsigned long *, u8 __user *, size_t,
+        size_t *, unsigned long *);
+void ec_pcap_header(const ec_pcap_t *, pcap_hdr_t *);
+
+/****************************************************************************/
+
+#endif
@@ -154,6 +154,10 @@ int ec_rtdm_open(
     ctx->ioctl_ctx.requested = 0;
     ctx->ioctl_ctx.process_data = NULL;
     ctx->ioctl_ctx.process_data_size = 0;
+    ctx->ioctl_ctx.cmd_ring = NULL;
+    ctx->ioctl_ctx.cmd_ring_tail = 0;
+    ctx->ioctl_ctx.pcap_pos = 0;
+    ctx->ioctl_ctx.pcap_streaming = 0;
 
 #if DEBUG
     EC_MASTER_INFO(rtdm_dev->master, "RTDM device %s opened.\n",
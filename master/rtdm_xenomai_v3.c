@@ -61,6 +61,10 @@ static int ec_rtdm_open(struct rtdm_fd *fd, int oflags)
 	ctx->ioctl_ctx.requested = 0;
 	ctx->ioctl_ctx.process_data = NULL;
 	ctx->ioctl_ctx.process_data_size = 0;
+	ctx->ioctl_ctx.cmd_ring = NULL;
+	ctx->ioctl_ctx.cmd_ring_tail = 0;
+	ctx->ioctl_ctx.pcap_pos = 0;
+	ctx->ioctl_ctx.pcap_streaming = 0;
 
 #if DEBUG_RTDM
 	EC_MASTER_INFO(rtdm_dev->master, "RTDM device %s opened.\n",
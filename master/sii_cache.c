@@ -0,0 +1,402 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Persistent SII cache.
+
+   The SII images of known slaves can be exported to userspace as a blob and
+   loaded again after a module reload, so that the bus scan does not have to
+   read the complete EEPROM of these slaves. All values are little endian:
+
+   - Header: magic (32 bit), version (32 bit), entry count (32 bit),
+     reserved (32 bit).
+   - Per entry: CRC-32 over the first #EC_SII_CACHE_CRC_WORDS words
+     (32 bit), number of words (32 bit), SII words, padded to 32 bit.
+*/
+
+/****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/crc32.h>
+
+#include "master.h"
+#include "slave.h"
+#include "sii_cache.h"
+
+/****************************************************************************/
+
+/** Size of the blob header in byte. */
+#define EC_SII_CACHE_HEADER_SIZE 16
+
+/** Size of an entry header in byte. */
+#define EC_SII_CACHE_ENTRY_HEADER_SIZE 8
+
+/** Size of an entry in the blob in byte. */
+#define EC_SII_CACHE_ENTRY_SIZE(NWORDS) \
+    (EC_SII_CACHE_ENTRY_HEADER_SIZE + (((NWORDS) * 2 + 3) & ~3))
+
+/****************************************************************************/
+
+/** Calculates the CRC of the leading SII words.
+ *
+ * \return CRC-32 over the first #EC_SII_CACHE_CRC_WORDS words.
+ */
+uint32_t ec_sii_cache_crc(
+        const uint16_t *words /**< SII contents. */
+        )
+{
+    return crc32_le(~0, (const unsigned char *) words,
+            EC_SII_CACHE_CRC_WORDS * 2) ^ ~0;
+}
+
+/****************************************************************************/
+
+/** Checks, if SII contents can be identified uniquely.
+ *
+ * This is the same condition that is used for re-using SII images in
+ * memory.
+ *
+ * \return Non-zero, if the alias or the serial number is set.
+ */
+static int ec_sii_cache_identifiable(
+        const uint16_t *words /**< SII contents. */
+        )
+{
+    return EC_READ_U16(words + EC_ALIAS_SII_OFFSET) != 0
+        || EC_READ_U32(words + EC_SERIAL_SII_OFFSET) != 0;
+}
+
+/****************************************************************************/
+
+/** Loads a persistent SII cache blob.
+ *
+ * The current entries are replaced. Entries with a CRC mismatch are
+ * skipped. The caller must hold the master semaphore.
+ *
+ * \return Number of loaded entries, or a negative error code.
+ */
+int ec_sii_cache_load(
+        ec_master_t *master, /**< EtherCAT master. */
+        const uint8_t *data, /**< Blob. */
+        size_t size /**< Size of \a data in byte. */
+        )
+{
+    LIST_HEAD(entries);
+    ec_sii_cache_entry_t *entry, *next;
+    const uint8_t *pos = data + EC_SII_CACHE_HEADER_SIZE;
+    uint32_t i, count, crc;
+    size_t nwords;
+    int loaded = 0, ret;
+
+    if (size < EC_SII_CACHE_HEADER_SIZE
+            || EC_READ_U32(data) != EC_SII_CACHE_MAGIC) {
+        EC_MASTER_ERR(master, "Invalid SII cache data.\n");
+        return -EINVAL;
+    }
+
+    if (EC_READ_U32(data + 4) != EC_SII_CACHE_VERSION) {
+        EC_MASTER_ERR(master, "Unsupported SII cache version %u.\n",
+                EC_READ_U32(data + 4));
+        return -EINVAL;
+    }
+
+    count = EC_READ_U32(data + 8);
+
+    for (i = 0; i < count; i++) {
+        if (pos + EC_SII_CACHE_ENTRY_HEADER_SIZE > data + size) {
+            ret = -EINVAL;
+            goto out_truncated;
+        }
+
+        crc = EC_READ_U32(pos);
+        nwords = EC_READ_U32(pos + 4);
+
+        if (nwords < EC_SII_CACHE_CRC_WORDS || nwords > EC_MAX_SII_SIZE) {
+            EC_MASTER_ERR(master, "Invalid SII size %zu in SII cache"
+                    " entry %u.\n", nwords, i);
+            ret = -EINVAL;
+            goto out_free;
+        }
+
+        if (pos + EC_SII_CACHE_ENTRY_SIZE(nwords) > data + size) {
+            ret = -EINVAL;
+            goto out_truncated;
+        }
+
+        if (ec_sii_cache_crc((const uint16_t *)
+                    (pos + EC_SII_CACHE_ENTRY_HEADER_SIZE)) != crc) {
+            EC_MASTER_WARN(master, "CRC mismatch in SII cache entry %u."
+                    " Skipping.\n", i);
+            pos += EC_SII_CACHE_ENTRY_SIZE(nwords);
+            continue;
+        }
+
+        if (!(entry = kmalloc(sizeof(*entry) + nwords * 2, GFP_KERNEL))) {
+            EC_MASTER_ERR(master, "Failed to allocate SII cache entry.\n");
+            ret = -ENOMEM;
+            goto out_free;
+        }
+
+        entry->crc = crc;
+        entry->nwords = nwords;
+        memcpy(entry->words, pos + EC_SII_CACHE_ENTRY_HEADER_SIZE,
+                nwords * 2);
+        list_add_tail(&entry->list, &entries);
+        loaded++;
+
+        pos += EC_SII_CACHE_ENTRY_SIZE(nwords);
+    }
+
+    ec_sii_cache_clear(master);
+    list_splice(&entries, &master->sii_cache);
+
+    EC_MASTER_DBG(master, 1, "Loaded %i SII cache entries.\n", loaded);
+    return loaded;
+
+out_truncated:
+    EC_MASTER_ERR(master, "SII cache data truncated in entry %u.\n", i);
+out_free:
+    list_for_each_entry_safe(entry, next, &entries, list) {
+        list_del(&entry->list);
+        kfree(entry);
+    }
+    return ret;
+}
+
+/****************************************************************************/
+
+/** Appends an entry to a persistent SII cache blob.
+ *
+ * \return Size of the entry in byte.
+ */
+static size_t ec_sii_cache_put(
+        uint8_t *pos, /**< Entry position, or NULL to calculate the size. */
+        const uint16_t *words, /**< SII contents. */
+        size_t nwords /**< Size of \a words. */
+        )
+{
+    size_t size = EC_SII_CACHE_ENTRY_SIZE(nwords);
+
+    if (pos) {
+        memset(pos, 0, size);
+        EC_WRITE_U32(pos, ec_sii_cache_crc(words));
+        EC_WRITE_U32(pos + 4, nwords);
+        memcpy(pos + EC_SII_CACHE_ENTRY_HEADER_SIZE, words, nwords * 2);
+    }
+
+    return size;
+}
+
+/****************************************************************************/
+
+/** Checks, if a cache entry is superseded by an SII image in memory.
+ *
+ * \return Non-zero, if an SII image with the same identity exists.
+ */
+static int ec_sii_cache_superseded(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const ec_sii_cache_entry_t *entry /**< Cache entry. */
+        )
+{
+    const ec_sii_image_t *sii_image;
+
+    list_for_each_entry(sii_image, &master->sii_images, list) {
+        if (sii_image->words
+                && sii_image->nwords >= EC_SII_CACHE_CRC_WORDS
+                && !memcmp(sii_image->words, entry->words,
+                    EC_SII_CACHE_CRC_WORDS * 2)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Saves the SII images and the loaded cache entries to a blob.
+ *
+ * Only SII images of slaves that can be identified uniquely are saved. If
+ * \a data is NULL or \a size is too small, only the required size is
+ * calculated. The caller must hold the master semaphore.
+ *
+ * \return Required size of the blob in byte.
+ */
+size_t ec_sii_cache_save(
+        const ec_master_t *master, /**< EtherCAT master. */
+        uint8_t *data, /**< Blob memory, or NULL. */
+        size_t size /**< Size of \a data in byte. */
+        )
+{
+    const ec_sii_image_t *sii_image;
+    const ec_sii_cache_entry_t *entry;
+    size_t required = EC_SII_CACHE_HEADER_SIZE;
+    uint32_t count = 0;
+    uint8_t *pos = NULL;
+    int pass;
+
+    // first pass calculates the size, second pass fills the blob
+    for (pass = 0; pass < 2; pass++) {
+        if (pass) {
+            if (!data || size < required) {
+                break;
+            }
+            EC_WRITE_U32(data, EC_SII_CACHE_MAGIC);
+            EC_WRITE_U32(data + 4, EC_SII_CACHE_VERSION);
+            EC_WRITE_U32(data + 8, count);
+            EC_WRITE_U32(data + 12, 0);
+            pos = data + EC_SII_CACHE_HEADER_SIZE;
+        }
+
+        list_for_each_entry(sii_image, &master->sii_images, list) {
+            size_t entry_size;
+
+            if (!sii_image->words
+                    || sii_image->nwords < EC_SII_CACHE_CRC_WORDS
+                    || !ec_sii_cache_identifiable(sii_image->words)) {
+                continue;
+            }
+
+            entry_size = ec_sii_cache_put(pos,
+                    sii_image->words, sii_image->nwords);
+            if (pass) {
+                pos += entry_size;
+            } else {
+                required += entry_size;
+                count++;
+            }
+        }
+
+        list_for_each_entry(entry, &master->sii_cache, list) {
+            size_t entry_size;
+
+            if (ec_sii_cache_superseded(master, entry)) {
+                continue;
+            }
+
+            entry_size = ec_sii_cache_put(pos, entry->words, entry->nwords);
+            if (pass) {
+                pos += entry_size;
+            } else {
+                required += entry_size;
+                count++;
+            }
+        }
+    }
+
+    return required;
+}
+
+/****************************************************************************/
+
+/** Removes all persistent SII cache entries.
+ */
+void ec_sii_cache_clear(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_sii_cache_entry_t *entry, *next;
+
+    list_for_each_entry_safe(entry, next, &master->sii_cache, list) {
+        list_del(&entry->list);
+        kfree(entry);
+    }
+}
+
+/****************************************************************************/
+
+#ifdef EC_SII_CACHE
+
+/** Searches a cache entry matching the identity of a slave.
+ *
+ * The identity is determined by the SII identity scan. A match still has
+ * to be verified with ec_sii_cache_lookup().
+ *
+ * \return Matching cache entry, or NULL.
+ */
+const ec_sii_cache_entry_t *ec_sii_cache_find(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    const ec_sii_cache_entry_t *entry;
+
+    if (!slave->effective_alias && !slave->effective_serial_number) {
+        return NULL;
+    }
+
+    list_for_each_entry(entry, &master->sii_cache, list) {
+        const uint16_t *words = entry->words;
+
+        if (slave->effective_alias) {
+            if (slave->effective_alias ==
+                    EC_READ_U16(words + EC_ALIAS_SII_OFFSET) &&
+                    slave->effective_revision_number ==
+                    EC_READ_U32(words + EC_REVISION_SII_OFFSET)) {
+                return entry;
+            }
+        }
+        else if (slave->effective_vendor_id ==
+                EC_READ_U32(words + EC_VENDOR_SII_OFFSET) &&
+                slave->effective_product_code ==
+                EC_READ_U32(words + EC_PRODUCT_SII_OFFSET) &&
+                slave->effective_revision_number ==
+                EC_READ_U32(words + EC_REVISION_SII_OFFSET) &&
+                slave->effective_serial_number ==
+                EC_READ_U32(words + EC_SERIAL_SII_OFFSET)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+#endif
+
+/****************************************************************************/
+
+/** Searches a cache entry by the leading SII words of a slave.
+ *
+ * \return Cache entry, whose first #EC_SII_CACHE_CRC_WORDS words match, or
+ *         NULL.
+ */
+const ec_sii_cache_entry_t *ec_sii_cache_lookup(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const uint16_t *words /**< First SII words read from the slave. */
+        )
+{
+    const ec_sii_cache_entry_t *entry;
+    uint32_t crc = ec_sii_cache_crc(words);
+
+    list_for_each_entry(entry, &master->sii_cache, list) {
+        if (entry->crc == crc && !memcmp(entry->words, words,
+                    EC_SII_CACHE_CRC_WORDS * 2)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/****************************************************************************/
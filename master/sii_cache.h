@@ -0,0 +1,82 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ ****************************************************************************/
+
+/**
+   \file
+   Persistent SII cache.
+*/
+
+/****************************************************************************/
+
+#ifndef __EC_SII_CACHE_H__
+#define __EC_SII_CACHE_H__
+
+#include <linux/list.h>
+
+#include "globals.h"
+
+/****************************************************************************/
+
+/** Magic number of a persistent SII cache blob ("ESII"). */
+#define EC_SII_CACHE_MAGIC 0x49495345
+
+/** Version of the persistent SII cache blob format. */
+#define EC_SII_CACHE_VERSION 1
+
+/** Number of leading SII words covered by the CRC of a cache entry.
+ *
+ * These contain the alias, vendor ID, product code, revision number and
+ * serial number of the slave.
+ */
+#define EC_SII_CACHE_CRC_WORDS 16
+
+/** Maximum size of a persistent SII cache blob in byte. */
+#define EC_SII_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+/****************************************************************************/
+
+/** Persistent SII cache entry.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    uint32_t crc; /**< CRC-32 over the first #EC_SII_CACHE_CRC_WORDS words. */
+    size_t nwords; /**< Size of the SII contents in words. */
+    uint16_t words[]; /**< SII contents. */
+} ec_sii_cache_entry_t;
+
+/****************************************************************************/
+
+uint32_t ec_sii_cache_crc(const uint16_t *);
+
+int ec_sii_cache_load(ec_master_t *, const uint8_t *, size_t);
+size_t ec_sii_cache_save(const ec_master_t *, uint8_t *, size_t);
+void ec_sii_cache_clear(ec_master_t *);
+
+#ifdef EC_SII_CACHE
+const ec_sii_cache_entry_t *ec_sii_cache_find(const ec_master_t *,
+        const ec_slave_t *);
+#endif
+const ec_sii_cache_entry_t *ec_sii_cache_lookup(const ec_master_t *,
+        const uint16_t *);
+
+/****************************************************************************/
+
+#endif
@@ -124,6 +124,8 @@ void ec_slave_init(
     slave->base_dc_range = EC_DC_32;
     slave->has_dc_system_time = 0;
     slave->transmission_delay = 0U;
+    ec_dc_stats_reset(&slave->dc_stats);
+    ec_esc_stats_reset(&slave->esc_stats);
 
     slave->vendor_words = NULL;
     slave->sii_image = NULL;
@@ -148,6 +150,9 @@ void ec_slave_init(
 
     slave->read_mbox_busy = 0;
     rt_mutex_init(&slave->mbox_sem);
+    slave->mbox_status_mapped = 0;
+    slave->mbox_status_check = NULL;
+    slave->mbox_status_seq = 0;
 
 #ifdef EC_EOE
     ec_mbox_data_init(&slave->mbox_eoe_frag_data);
@@ -345,6 +350,12 @@ void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
     ec_mbox_data_clear(&slave->mbox_voe_data);
     ec_mbox_data_clear(&slave->mbox_mbg_data);
 
+    // release the external datagram of a pending mailbox check
+    if (slave->mbox_status_check) {
+        slave->mbox_status_check->state = EC_DATAGRAM_ERROR;
+        slave->mbox_status_check = NULL;
+    }
+
     ec_fsm_slave_clear(&slave->fsm);
 }
 
@@ -47,6 +47,8 @@
 #include "sync.h"
 #include "sdo.h"
 #include "fsm_slave.h"
+#include "latency.h"
+#include "esc_stats.h"
 
 /*****************************************************************************/
 
@@ -261,6 +263,10 @@ struct ec_slave
                                   delay measurement. */
     uint32_t transmission_delay; /**< DC system time transmission delay
                                    (offset from reference clock). */
+    ec_dc_stats_t dc_stats; /**< System time difference statistics, see
+                              ec_master_dc_monitor_queue(). */
+    ec_esc_stats_t esc_stats; /**< ESC error counter statistics, see
+                                ec_master_esc_monitor_queue(). */
 
     // Slave information interface
     uint16_t *vendor_words; /**< First 16 words of SII image. */
@@ -282,6 +288,12 @@ struct ec_slave
     ec_fsm_slave_t fsm; /**< Slave state machine. */
 
     uint8_t read_mbox_busy; /**< Flag set during a mailbox read request. */
+    uint8_t mbox_status_mapped; /**< The sync manager 1 status is mapped into
+                                  the mailbox status area. */
+    ec_datagram_t *mbox_status_check; /**< Mailbox check datagram waiting for
+                                        the mailbox status, or NULL. */
+    unsigned int mbox_status_seq; /**< Number of mailbox status datagrams
+                                    sent before the check was prepared. */
     struct rt_mutex mbox_sem; /**< Semaphore protecting the check_mbox variable. */
 
 #ifdef EC_EOE
@@ -154,7 +154,8 @@ Command::Command(const string &name, const string &briefDesc):
     verbosity(Normal),
     emergency(false),
     force(false),
-    reset(false)
+    reset(false),
+    follow(false)
 {
 }
 
@@ -229,6 +230,13 @@ void Command::setReset(bool r)
 
 /*****************************************************************************/
 
+void Command::setFollow(bool f)
+{
+    follow = f;
+};
+
+/*****************************************************************************/
+
 void Command::setOutputFile(const string &f)
 {
     outputFile = f;
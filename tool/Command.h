@@ -116,6 +116,9 @@ class Command
         void setReset(bool);
         bool getReset() const;
 
+        void setFollow(bool);
+        bool getFollow() const;
+
         void setOutputFile(const string &);
         const string &getOutputFile() const;
 
@@ -164,6 +167,7 @@ class Command
         bool emergency;
         bool force;
         bool reset;
+        bool follow;
         string outputFile;
         string skin;
 
@@ -221,6 +225,13 @@ inline bool Command::getReset() const
 
 /****************************************************************************/
 
+inline bool Command::getFollow() const
+{
+    return follow;
+}
+
+/****************************************************************************/
+
 inline const string &Command::getOutputFile() const
 {
     return outputFile;
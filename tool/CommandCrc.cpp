@@ -28,6 +28,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <string.h>
 using namespace std;
 
 #include "CommandCrc.h"
@@ -59,6 +60,14 @@ string CommandCrc::helpString(const string &binaryBaseName) const
         << "FWD - Forwarded RX Error Counter       0x308, 0x309, 0x30a, 0x30b"
         << endl
         << "NXT - Next slave" << endl
+        << endl
+        << "While the ESC monitor is enabled (see the 'errors' command), it"
+        << endl
+        << "clears the counters, before they saturate. The accumulated counts"
+        << endl
+        << "of the monitor are shown then, and 'reset' resets these instead"
+        << endl
+        << "of the registers." << endl
         << endl;
 
     return str.str();
@@ -97,30 +106,34 @@ void CommandCrc::execute(const StringVector &args)
     ec_ioctl_master_t master;
     m.getMaster(&master);
 
-    uint8_t data[REG_SIZE];
-    ec_ioctl_slave_reg_t io;
-    io.emergency = 0;
-    io.address = 0x0300;
-    io.size = REG_SIZE;
-    io.data = data;
+    if (!master.slave_count) {
+        return;
+    }
 
-    if (reset) {
-        for (int j = 0; j < REG_SIZE; j++) {
-            data[j] = 0x00;
-        }
+    vector<uint8_t> data(master.slave_count * REG_SIZE, 0x00);
+    vector<ec_esc_stats_t> stats(master.slave_count);
 
-        for (unsigned int i = 0; i < master.slave_count; i++) {
+    // the ESC monitor owns the counters, while it is enabled
+    ec_ioctl_esc_monitor_t monitor =
+        m.getSlaveEscStats(&stats.front(), 0, reset);
+    bool monitored = monitor.interval != 0;
 
-            io.slave_position = i;
-            try {
-                m.writeReg(&io);
-            } catch (MasterDeviceException &e) {
-                throw e;
-            }
+    if (monitored) {
+        for (unsigned int i = 1; i < master.slave_count; i++) {
+            m.getSlaveEscStats(&stats[i], i, reset);
         }
+    } else {
+        sweepCounters(m, master.slave_count, reset, data);
+    }
+
+    if (reset) {
         return;
     }
 
+    if (monitored) {
+        cout << "Counts accumulated by the ESC monitor." << endl;
+    }
+
     cout << "   |";
     for (unsigned int port = 0; port < EC_MAX_PORTS; port++) {
         cout << "Port " << port << "         |";
@@ -138,23 +151,26 @@ void CommandCrc::execute(const StringVector &args)
         ec_ioctl_slave_t slave;
         m.getSlave(&slave, i);
 
-        io.slave_position = i;
-        try {
-            m.readReg(&io);
-        } catch (MasterDeviceException &e) {
-            throw e;
-        }
+        const uint8_t *regs = &data[i * REG_SIZE];
 
         cout << setw(3) << i << "|";
         for (int port = 0; port < 4; port++) {
+            const ec_esc_port_stats_t &ps = stats[i].ports[port];
+
             if (slave.ports[port].link.loop_closed) {
                 cout << "               |";
                 continue;
             }
 
-            cout << setw(3) << (unsigned int) io.data[ 0 + port * 2]; // CRC
-            cout << setw(4) << (unsigned int) io.data[ 1 + port * 2]; // PHY
-            cout << setw(4) << (unsigned int) io.data[ 8 + port]; // FWD
+            if (monitored) {
+                cout << setw(3) << ps.invalid_frames; // CRC
+                cout << setw(4) << ps.rx_errors; // PHY
+                cout << setw(4) << ps.forwarded_errors; // FWD
+            } else {
+                cout << setw(3) << (unsigned int) regs[ 0 + port * 2]; // CRC
+                cout << setw(4) << (unsigned int) regs[ 1 + port * 2]; // PHY
+                cout << setw(4) << (unsigned int) regs[ 8 + port]; // FWD
+            }
             if (slave.ports[port].next_slave == i - 1) {
                 cout << "   ↑";
             }
@@ -177,4 +193,49 @@ void CommandCrc::execute(const StringVector &args)
     }
 }
 
+/****************************************************************************/
+
+/** Reads, or clears, the error counter registers of all slaves with a single
+ * register sweep.
+ */
+void CommandCrc::sweepCounters(
+        MasterDevice &m,
+        unsigned int slaveCount,
+        bool reset,
+        vector<uint8_t> &data
+        )
+{
+    vector<uint16_t> positions(slaveCount);
+    vector<uint8_t> success(slaveCount);
+    ec_ioctl_reg_range_t range;
+    ec_ioctl_slave_reg_sweep_t io;
+
+    for (unsigned int i = 0; i < slaveCount; i++) {
+        positions[i] = i;
+    }
+
+    memset(&range, 0, sizeof(range));
+    range.address = 0x0300;
+    range.size = REG_SIZE;
+    range.dir = reset ? EC_DIR_OUTPUT : EC_DIR_INPUT;
+
+    io.slave_count = slaveCount;
+    io.range_count = 1;
+    io.slave_positions = &positions.front();
+    io.ranges = &range;
+    io.data = &data.front();
+    io.success = &success.front();
+
+    m.sweepRegs(&io);
+
+    for (unsigned int i = 0; i < slaveCount; i++) {
+        if (!success[i]) {
+            stringstream err;
+            err << "Failed to " << (reset ? "write" : "read")
+                << " register of slave " << i << ".";
+            throwCommandException(err);
+        }
+    }
+}
+
 /*****************************************************************************/
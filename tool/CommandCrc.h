@@ -42,6 +42,10 @@ class CommandCrc:
 
         string helpString(const string &) const;
         void execute(const StringVector &);
+
+    private:
+        void sweepCounters(MasterDevice &, unsigned int, bool,
+                vector<uint8_t> &);
 };
 
 /****************************************************************************/
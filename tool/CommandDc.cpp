@@ -0,0 +1,215 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+using namespace std;
+
+#include "CommandDc.h"
+#include "CommandLatency.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandDc::CommandDc():
+    Command("dc", "Output DC synchrony statistics per slave.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDc::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS] [INTERVAL]"
+        << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The DC monitor reads the system time difference register"
+        << endl
+        << "(0x092C) of one slave with DC support at a time, every INTERVAL"
+        << endl
+        << "calls of ecrt_master_sync_slave_clocks(). The slaves are read in"
+        << endl
+        << "turn, so with n DC slaves, each slave is read every n * INTERVAL"
+        << endl
+        << "application cycles. Without an argument, the statistics are"
+        << endl
+        << "shown. With an argument, the interval is set. Zero disables the"
+        << endl
+        << "monitor (default)." << endl
+        << endl
+        << "The statistics are in nanoseconds. Negative differences mean,"
+        << endl
+        << "that the local copy of the system time was smaller than the"
+        << endl
+        << "received one. The percentiles refer to the absolute values."
+        << endl
+        << endl
+        << "Arguments:" << endl
+        << "  INTERVAL is a number of calls. Zero disables the monitor."
+        << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of"
+        << endl
+        << "                         the 'slaves' command." << endl
+        << "  --reset    -r          Reset the statistics after reading"
+        << endl
+        << "                         them." << endl
+        << "  --verbose  -v          Output the histogram buckets." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDc::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    SlaveList slaves;
+    bool doIndent;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    masterIndices = getMasterIndices();
+
+    if (args.size()) {
+        stringstream str;
+        uint32_t interval;
+
+        str << args[0];
+        str >> resetiosflags(ios::basefield) // guess base from prefix
+            >> interval;
+        if (str.fail()) {
+            stringstream err;
+            err << "Invalid interval '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+
+        MasterIndexList::const_iterator mi;
+        for (mi = masterIndices.begin();
+                mi != masterIndices.end(); mi++) {
+            MasterDevice m(*mi);
+            m.open(MasterDevice::ReadWrite);
+            m.setDcMonitor(interval);
+        }
+        return;
+    }
+
+    doIndent = masterIndices.size() > 1;
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(getReset() ? MasterDevice::ReadWrite : MasterDevice::Read);
+        slaves = selectedSlaves(m);
+        uint32_t interval = 0;
+        bool header = false;
+
+        if (doIndent) {
+            cout << "Master" << dec << *mi << endl;
+        }
+
+        SlaveList::const_iterator si;
+        for (si = slaves.begin(); si != slaves.end(); si++) {
+            if (!si->has_dc_system_time) {
+                continue;
+            }
+
+            ec_dc_stats_t stats;
+            interval = m.getSlaveDcStats(&stats, si->position, getReset());
+
+            if (!header) {
+                cout << "  Pos      Count      Min      Avg      Max"
+                    << "     Last     |p99|  |p99.9|" << endl;
+                header = true;
+            }
+
+            showStats(*si, stats);
+        }
+
+        if (!header) {
+            cout << "No slaves with DC system time support." << endl;
+        } else if (!interval) {
+            cout << "The DC monitor is disabled." << endl;
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandDc::showStats(
+        const ec_ioctl_slave_t &slave,
+        const ec_dc_stats_t &stats
+        ) const
+{
+    const ec_latency_hist_t &hist = stats.hist;
+
+    cout << setw(5) << dec << slave.position
+        << setw(11) << hist.count;
+
+    if (!hist.count) {
+        cout << endl;
+        return;
+    }
+
+    cout << setw(9) << stats.min_ns
+        << setw(9) << (long long) llround((double) stats.sum_ns / hist.count)
+        << setw(9) << stats.max_ns
+        << setw(9) << stats.last_ns
+        << setw(10) << CommandLatency::percentile(hist, 0.99)
+        << setw(9) << CommandLatency::percentile(hist, 0.999)
+        << endl;
+
+    if (getVerbosity() != Verbose) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < EC_LATENCY_BUCKETS; i++) {
+        if (!hist.buckets[i]) {
+            continue;
+        }
+
+        cout << "  >= " << setw(10) << ec_latency_bucket_floor(i)
+            << " ns: " << hist.buckets[i] << endl;
+    }
+}
+
+/*****************************************************************************/
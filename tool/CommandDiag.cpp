@@ -59,6 +59,11 @@ string CommandDiag::helpString(const string &binaryBaseName) const
         << "  --position -p <pos>    Slave selection." << endl
         << "  --reset    -r          Resets all error registers in ESC." << endl
         << "  --verbose  -v          Verbose output error ESC registers of selected slave(s)." << endl
+        << endl
+        << "While the ESC monitor is enabled (see the 'errors' command), it" << endl
+        << "clears the error counters, before they saturate. The counts" << endl
+        << "accumulated by the monitor are shown then, and --reset resets" << endl
+        << "these instead of the registers." << endl
         << endl;
 
     return str.str();
@@ -85,45 +90,113 @@ void CommandDiag::execute(const StringVector &args)
             mi != masterIndices.end(); mi++) {
         MasterDevice m(*mi);
         m.open(MasterDevice::ReadWrite);
+        m.loadTopology();
         slaves = selectedSlaves(m);
 
         CheckallSlaves(m, slaves, doIndent);
     }
 }
 
-void CommandDiag::EscRegRead(MasterDevice &m, uint16_t slave_position, uint16_t address, uint8_t *data, size_t byteSize)
+/****************************************************************************/
+
+/** Reads the DL status and the error counters of all given slaves with a
+ * single register sweep.
+ *
+ * For each slave, \a data receives EscSweepSize bytes: the DL status
+ * register (0x110) followed by the error counters (0x300). Ranges that
+ * could not be transferred are zeroed.
+ */
+void CommandDiag::EscRegSweep(
+        MasterDevice &m,
+        const vector<uint16_t> &positions,
+        vector<uint8_t> &data,
+        bool clear /**< Clear the error counters. */
+        )
 {
-    ec_ioctl_slave_reg_t io;
+    ec_ioctl_reg_range_t ranges[2];
+    ec_ioctl_slave_reg_sweep_t io;
+    vector<uint8_t> success(positions.size() * 2);
+    vector<uint16_t> pos(positions);
+    unsigned int i, j;
+
+    data.assign(positions.size() * EscSweepSize, 0);
+    if (positions.empty()) {
+        return;
+    }
 
-    io.slave_position = slave_position;
-    io.address = address;
-    io.size = byteSize;
-    io.data = data;
-    io.emergency = false;
+    memset(ranges, 0, sizeof(ranges));
+    ranges[0].address = 0x110;
+    ranges[0].size = EscDlStatusSize;
+    ranges[0].dir = EC_DIR_INPUT;
+    ranges[1].address = 0x300;
+    ranges[1].size = EscErrorsSize;
+    // clear the counters while reading them; the data is zero already
+    ranges[1].dir = clear ? EC_DIR_BOTH : EC_DIR_INPUT;
+
+    io.slave_count = pos.size();
+    io.range_count = 2;
+    io.slave_positions = &pos.front();
+    io.ranges = ranges;
+    io.data = &data.front();
+    io.success = &success.front();
 
-    memset(data, 0, byteSize);
     try {
-        m.readReg(&io);
+        m.sweepRegs(&io);
     } catch (MasterDeviceException &e) {
-        fprintf(stderr, "EscRegRead %s slave = %i, address = %x, size = %zu\n", e.what(), io.slave_position, io.address, io.size);
+        fprintf(stderr, "EscRegSweep %s slaves = %zu\n",
+                e.what(), positions.size());
+        data.assign(positions.size() * EscSweepSize, 0);
+        return;
+    }
+
+    for (i = 0; i < positions.size(); i++) {
+        for (j = 0; j < 2; j++) {
+            if (success[i * 2 + j]) {
+                continue;
+            }
+            fprintf(stderr, "EscRegSweep failed slave = %i,"
+                    " address = %x, size = %u\n", positions[i],
+                    ranges[j].address, ranges[j].size);
+            memset(&data[i * EscSweepSize + (j ? EscDlStatusSize : 0)],
+                    0, ranges[j].size);
+        }
     }
 }
 
-void CommandDiag::EscRegReadWrite(MasterDevice &m, uint16_t slave_position, uint16_t address, uint8_t *data, size_t byteSize)
+/****************************************************************************/
+
+/** Fetches the statistics of the ESC monitor, if it is enabled.
+ *
+ * The monitor clears the error counters, before they saturate, so its
+ * accumulated counts replace the registers then. With --reset, the
+ * statistics are reset after reading them.
+ *
+ * \return True, if the monitor is enabled.
+ */
+bool CommandDiag::getEscStats(
+        MasterDevice &m,
+        const vector<uint16_t> &positions,
+        vector<ec_esc_stats_t> &stats
+        )
 {
-    ec_ioctl_slave_reg_t io;
+    ec_ioctl_esc_monitor_t monitor;
+    unsigned int i;
 
-    io.slave_position = slave_position;
-    io.address = address;
-    io.size = byteSize;
-    io.data = data;
-    io.emergency = false;
+    stats.resize(positions.size());
+    if (positions.empty()) {
+        return false;
+    }
 
-    try {
-        m.readWriteReg(&io);
-    } catch (MasterDeviceException &e) {
-        fprintf(stderr, "EscRegReadWrite %s slave = %i, address = %x, size = %zu\n", e.what(), io.slave_position, io.address, io.size);
+    monitor = m.getSlaveEscStats(&stats[0], positions[0], false);
+    if (!monitor.interval) {
+        return false;
+    }
+
+    for (i = 0; i < positions.size(); i++) {
+        m.getSlaveEscStats(&stats[i], positions[i], getReset());
     }
+
+    return true;
 }
 
 /****************************************************************************/
@@ -147,9 +220,24 @@ void CommandDiag::CheckallSlaves(
                  maxRelPosWidth = 0, maxStateWidth = 0,
                  maxESCerrorsWidth = 0;
     string indent(doIndent ? "  " : "");
+    vector<uint16_t> positions;
+    vector<uint8_t> regs;
+    vector<ec_esc_stats_t> stats;
+    bool monitored;
+    unsigned int k = 0;
 
     m.getMaster(&master);
 
+    for (i = 0; i < master.slave_count; i++) {
+        m.getSlave(&slave, i);
+        if (slaveInList(slave, slaves)) {
+            positions.push_back(i);
+        }
+    }
+
+    monitored = getEscStats(m, positions, stats);
+    EscRegSweep(m, positions, regs, getReset() && !monitored);
+
     lastAlias = 0;
     aliasIndex = 0;
     for (i = 0; i < master.slave_count; i++) {
@@ -161,9 +249,10 @@ void CommandDiag::CheckallSlaves(
         }
 
         if (slaveInList(slave, slaves)) {
-            int slave_position = i;
-            uint8_t dl_status[2];
-            uint8_t ecat_errors[0x14];
+            const uint8_t *dl_status = &regs[k * EscSweepSize];
+            const uint8_t *ecat_errors = dl_status + EscDlStatusSize;
+            const ec_esc_stats_t &escStats = stats[k];
+            k++;
 
             str << dec << i;
             info.pos = str.str();
@@ -192,14 +281,6 @@ void CommandDiag::CheckallSlaves(
                 str.str("");
             }
 
-            EscRegRead(m, slave_position, 0x110, dl_status, sizeof(dl_status));
-            if (getReset()) {
-                memset(ecat_errors, 0, sizeof(ecat_errors));
-                EscRegReadWrite(m, slave_position, 0x300, ecat_errors, sizeof(ecat_errors));
-            } else {
-                EscRegRead(m, slave_position, 0x300, ecat_errors, sizeof(ecat_errors));
-            }
-
             info.ESC_DL_Status = EC_READ_U16(dl_status);
             info.ESCerrors = 0;
 
@@ -210,11 +291,20 @@ void CommandDiag::CheckallSlaves(
                 /* some error registers are only availble when MII or EBUS port is present */
                 check_port += (slave.ports[i].desc == EC_PORT_MII) ? 1 : 0;
                 check_port += (slave.ports[i].desc == EC_PORT_EBUS) ? 1 : 0;
-                info.Invalid_Frame_Counter[i] = (check_port > 0) ? EC_READ_U8(&ecat_errors[i * 2]) : 0;
-                info.RX_Error_Counter[i] = (check_port > 0) ? EC_READ_U8(&ecat_errors[0x1 + (i * 2)]) : 0;
-                info.Forwarded_RX_Error_Counter[i] = (check_port > 1) ? EC_READ_U8(&ecat_errors[0x8 + i]) : 0;
-                info.ECAT_Processing_Unit_Error_Counter = (check_port > 1) && (i == 0) ? EC_READ_U8(&ecat_errors[0xC]) : 0;
-                info.Lost_Link_Counter[i] = (check_port > 1) ? EC_READ_U8(&ecat_errors[0x10 + i]) : 0;
+                if (monitored) {
+                    const ec_esc_port_stats_t &ps = escStats.ports[i];
+                    info.Invalid_Frame_Counter[i] = (check_port > 0) ? ps.invalid_frames : 0;
+                    info.RX_Error_Counter[i] = (check_port > 0) ? ps.rx_errors : 0;
+                    info.Forwarded_RX_Error_Counter[i] = (check_port > 1) ? ps.forwarded_errors : 0;
+                    info.ECAT_Processing_Unit_Error_Counter = (check_port > 1) && (i == 0) ? escStats.processing_unit_errors : 0;
+                    info.Lost_Link_Counter[i] = (check_port > 1) ? ps.lost_links : 0;
+                } else {
+                    info.Invalid_Frame_Counter[i] = (check_port > 0) ? EC_READ_U8(&ecat_errors[i * 2]) : 0;
+                    info.RX_Error_Counter[i] = (check_port > 0) ? EC_READ_U8(&ecat_errors[0x1 + (i * 2)]) : 0;
+                    info.Forwarded_RX_Error_Counter[i] = (check_port > 1) ? EC_READ_U8(&ecat_errors[0x8 + i]) : 0;
+                    info.ECAT_Processing_Unit_Error_Counter = (check_port > 1) && (i == 0) ? EC_READ_U8(&ecat_errors[0xC]) : 0;
+                    info.Lost_Link_Counter[i] = (check_port > 1) ? EC_READ_U8(&ecat_errors[0x10 + i]) : 0;
+                }
 
                 info.ESCerrors |= info.Invalid_Frame_Counter[i] ? 0x01 : 0x00;
                 info.ESCerrors |= info.RX_Error_Counter[i] ? 0x02 : 0x00;
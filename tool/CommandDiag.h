@@ -68,8 +68,16 @@ class CommandDiag:
     private:
         void CheckallSlaves(MasterDevice &, const SlaveList &, bool);
         static bool slaveInList(const ec_ioctl_slave_t &, const SlaveList &);
-        void EscRegRead(MasterDevice &, uint16_t, uint16_t, uint8_t*, size_t);
-        void EscRegReadWrite(MasterDevice &, uint16_t, uint16_t, uint8_t*, size_t);
+        void EscRegSweep(MasterDevice &, const vector<uint16_t> &,
+                vector<uint8_t> &, bool);
+        bool getEscStats(MasterDevice &, const vector<uint16_t> &,
+                vector<ec_esc_stats_t> &);
+
+        enum {
+            EscDlStatusSize = 2, /**< DL status register 0x110. */
+            EscErrorsSize = 0x14, /**< Error counters 0x300 to 0x313. */
+            EscSweepSize = EscDlStatusSize + EscErrorsSize
+        };
 };
 
 /****************************************************************************/
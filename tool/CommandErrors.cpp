@@ -0,0 +1,224 @@
+/*****************************************************************************
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandErrors.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandErrors::CommandErrors():
+    Command("errors", "Output ESC error statistics per slave port.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandErrors::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [INTERVAL [THRESHOLD]]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The ESC monitor reads the error counter registers (0x0300 to"
+        << endl
+        << "0x0313) of all slaves every INTERVAL milliseconds. The readings"
+        << endl
+        << "only use the space, that the cyclic datagrams leave in the"
+        << endl
+        << "frames. Counters close to saturation are cleared by the monitor,"
+        << endl
+        << "so the statistics are not limited to 255 errors. Without an"
+        << endl
+        << "argument, the statistics are shown. With arguments, the monitor"
+        << endl
+        << "is configured. Zero disables the monitor (default)." << endl
+        << endl
+        << "While the monitor is enabled, it owns the error counters: The"
+        << endl
+        << "'crc' and 'diag' commands show its accumulated counts instead of"
+        << endl
+        << "the registers, and their reset options reset the statistics."
+        << endl
+        << endl
+        << "A port raises an event, that is logged by the master, if it lost"
+        << endl
+        << "its link, or if its error rate reached THRESHOLD. The rate is"
+        << endl
+        << "calculated over windows of " << EC_ESC_RATE_WINDOW
+        << " seconds." << endl
+        << endl
+        << "Columns:" << endl
+        << "  CRC   Invalid frames (CRC errors)." << endl
+        << "  PHY   Physical layer RX errors." << endl
+        << "  FWD   Forwarded errors (detected by a previous slave)." << endl
+        << "  Lost  Lost links." << endl
+        << "  Rate  CRC and PHY errors per minute in the last window." << endl
+        << "  Ev    Number of events." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  INTERVAL  is the time between two sweeps in ms." << endl
+        << "  THRESHOLD is a number of errors per minute. Zero (default)"
+        << endl
+        << "            disables the rate events." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of"
+        << endl
+        << "                         the 'slaves' command." << endl
+        << "  --reset    -r          Reset the statistics after reading"
+        << endl
+        << "                         them." << endl
+        << "  --verbose  -v          Output reading and slave-wide" << endl
+        << "                         counters." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandErrors::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    SlaveList slaves;
+    bool doIndent;
+
+    if (args.size() > 2) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most two arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    masterIndices = getMasterIndices();
+
+    if (args.size()) {
+        uint32_t values[2] = {0, 0};
+
+        for (unsigned int i = 0; i < args.size(); i++) {
+            stringstream str;
+
+            str << args[i];
+            str >> resetiosflags(ios::basefield) // guess base from prefix
+                >> values[i];
+            if (str.fail()) {
+                stringstream err;
+                err << "Invalid " << (i ? "threshold" : "interval")
+                    << " '" << args[i] << "'!";
+                throwInvalidUsageException(err);
+            }
+        }
+
+        MasterIndexList::const_iterator mi;
+        for (mi = masterIndices.begin();
+                mi != masterIndices.end(); mi++) {
+            MasterDevice m(*mi);
+            m.open(MasterDevice::ReadWrite);
+            m.setEscMonitor(values[0], values[1]);
+        }
+        return;
+    }
+
+    doIndent = masterIndices.size() > 1;
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(getReset() ? MasterDevice::ReadWrite : MasterDevice::Read);
+        slaves = selectedSlaves(m);
+        ec_ioctl_esc_monitor_t monitor = {0, 0};
+
+        if (doIndent) {
+            cout << "Master" << dec << *mi << endl;
+        }
+
+        if (slaves.size()) {
+            cout << "  Pos  Port      CRC      PHY      FWD   Lost"
+                << "   Rate     Ev" << endl;
+        }
+
+        SlaveList::const_iterator si;
+        for (si = slaves.begin(); si != slaves.end(); si++) {
+            ec_esc_stats_t stats;
+            monitor = m.getSlaveEscStats(&stats, si->position, getReset());
+            showStats(*si, stats);
+        }
+
+        if (!monitor.interval) {
+            cout << "The ESC monitor is disabled." << endl;
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandErrors::showStats(
+        const ec_ioctl_slave_t &slave,
+        const ec_esc_stats_t &stats
+        ) const
+{
+    for (unsigned int port = 0; port < EC_MAX_PORTS; port++) {
+        const ec_esc_port_stats_t &ps = stats.ports[port];
+
+        if (slave.ports[port].desc == EC_PORT_NOT_IMPLEMENTED ||
+                slave.ports[port].desc == EC_PORT_NOT_CONFIGURED) {
+            continue;
+        }
+
+        cout << setw(5) << dec << slave.position
+            << setw(6) << port
+            << setw(9) << ps.invalid_frames
+            << setw(9) << ps.rx_errors
+            << setw(9) << ps.forwarded_errors
+            << setw(7) << ps.lost_links
+            << setw(7) << ps.rate
+            << setw(7) << ps.events
+            << endl;
+    }
+
+    if (getVerbosity() != Verbose) {
+        return;
+    }
+
+    cout << "       Readings: " << stats.readings
+        << ", failed: " << stats.failures
+        << ", cleared: " << stats.clears << endl
+        << "       Processing unit errors: " << stats.processing_unit_errors
+        << ", PDI errors: " << stats.pdi_errors << endl;
+}
+
+/*****************************************************************************/
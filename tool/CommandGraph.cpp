@@ -135,6 +135,7 @@ void CommandGraph::execute(const StringVector &args)
 
     MasterDevice m(getSingleMasterIndex());
     m.open(MasterDevice::Read);
+    m.loadTopology();
     m.getMaster(&master);
 
     for (unsigned int i = 0; i < master.slave_count; i++) {
@@ -0,0 +1,187 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandLatency.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandLatency::CommandLatency():
+    Command("latency", "Output cyclic latency histograms.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandLatency::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master records histograms of the following times during"
+        << endl
+        << "the operation phase (all in microseconds):" << endl
+        << "  rtt       Datagram round-trip time from sending to receiving."
+        << endl
+        << "  send      Interval between calls of ecrt_master_send()." << endl
+        << "  process   Time spent in ecrt_domain_process()." << endl
+        << "  queue     Time spent in ecrt_domain_queue()." << endl
+        << endl
+        << "The histogram buckets have a relative resolution of "
+        << 100.0 / (1 << EC_LATENCY_SUB_BITS) << " %." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --reset    -r  Reset the histograms after reading them."
+        << endl
+        << "  --verbose  -v  Output the histogram buckets." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandLatency::execute(const StringVector &args)
+{
+    static const char *names[EC_LATENCY_COUNT] = {
+        "rtt", "send", "process", "queue"
+    };
+    MasterIndexList masterIndices;
+    bool doIndent;
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    masterIndices = getMasterIndices();
+    doIndent = masterIndices.size() > 1;
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(getReset() ? MasterDevice::ReadWrite : MasterDevice::Read);
+
+        if (doIndent) {
+            cout << "Master" << dec << *mi << endl;
+        }
+
+        cout << "          Count      Min      Avg      Max"
+            << "      p50      p99    p99.9   p99.99" << endl;
+
+        for (unsigned int type = 0; type < EC_LATENCY_COUNT; type++) {
+            ec_latency_hist_t hist;
+            m.getLatency(&hist, type, getReset());
+            showHistogram(names[type], hist);
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandLatency::showHistogram(
+        const string &name,
+        const ec_latency_hist_t &hist
+        ) const
+{
+    cout << setw(7) << left << name << right
+        << setw(10) << hist.count;
+
+    if (!hist.count) {
+        cout << endl;
+        return;
+    }
+
+    cout << fixed << setprecision(1)
+        << setw(9) << hist.min_ns / 1000.0
+        << setw(9) << (double) hist.sum_ns / hist.count / 1000.0
+        << setw(9) << hist.max_ns / 1000.0
+        << setw(9) << percentile(hist, 0.5) / 1000.0
+        << setw(9) << percentile(hist, 0.99) / 1000.0
+        << setw(9) << percentile(hist, 0.999) / 1000.0
+        << setw(9) << percentile(hist, 0.9999) / 1000.0
+        << endl;
+
+    if (getVerbosity() != Verbose) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < EC_LATENCY_BUCKETS; i++) {
+        if (!hist.buckets[i]) {
+            continue;
+        }
+
+        cout << "  >= " << setw(12) << ec_latency_bucket_floor(i) / 1000.0
+            << " us: " << hist.buckets[i] << endl;
+    }
+}
+
+/****************************************************************************/
+
+/** Returns the lower bound of the bucket containing a percentile.
+ *
+ * The value is limited to the recorded minimum and maximum.
+ */
+uint32_t CommandLatency::percentile(
+        const ec_latency_hist_t &hist,
+        double fraction
+        )
+{
+    uint64_t target = (uint64_t) (fraction * hist.count), sum = 0;
+    uint32_t value = hist.max_ns;
+
+    for (unsigned int i = 0; i < EC_LATENCY_BUCKETS; i++) {
+        sum += hist.buckets[i];
+        if (sum > target) {
+            value = ec_latency_bucket_floor(i);
+            break;
+        }
+    }
+
+    if (value < hist.min_ns) {
+        value = hist.min_ns;
+    }
+    if (value > hist.max_ns) {
+        value = hist.max_ns;
+    }
+
+    return value;
+}
+
+/*****************************************************************************/
@@ -30,6 +30,9 @@
  ****************************************************************************/
 
 #include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cctype>
 using namespace std;
 
 #include "CommandPcap.h"
@@ -37,6 +40,14 @@ using namespace std;
 
 /*****************************************************************************/
 
+/** Datagram type names, indexed by the datagram type. */
+static const char *datagramTypes[] = {
+    "NONE", "APRD", "APWR", "APRW", "FPRD", "FPWR", "FPRW", "BRD", "BWR",
+    "BRW", "LRD", "LWR", "LRW", "ARMW", "FRMW"
+};
+
+/*****************************************************************************/
+
 CommandPcap::CommandPcap():
     Command("pcap", "Output binary pcap capture data.")
 {
@@ -48,12 +59,40 @@ string CommandPcap::helpString(const string &binaryBaseName) const
 {
     stringstream str;
 
-    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [KEY=VALUE ...]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
+        << "The master captures the sent and received frames into a ring"
+        << endl
+        << "of pcap_size bytes (module parameter). If the ring is full, the"
+        << endl
+        << "oldest frames are overwritten. Without --follow, the frames in"
+        << endl
+        << "the ring are output once." << endl
+        << endl
+        << "Arguments set the capture filters:" << endl
+        << "  snaplen=N       Capture at most N bytes per frame, 0 for all."
+        << endl
+        << "  dir=tx|rx|all   Capture sent and/or received frames." << endl
+        << "  types=LIST|all  Capture frames containing at least one"
+        << endl
+        << "                  datagram of the comma-separated types, for"
+        << endl
+        << "                  example 'LRW,BRD'." << endl
+        << endl
         << "Command-specific options:" << endl
-        << "  --reset  -r   Flushes the retrieved pcap data and continues logging." << endl
+        << "  --reset       -r         Flushes the retrieved pcap data and"
+        << endl
+        << "                           continues logging." << endl
+        << "  --follow      -F         Stream the frames continuously as"
+        << endl
+        << "                           they are captured." << endl
+        << "  --output-file -o <file>  Write to <file> instead of stdout."
+        << endl
+        << "  --verbose     -v         Output capture statistics to stderr."
+        << endl
         << endl;
 
     return str.str();
@@ -64,46 +103,236 @@ string CommandPcap::helpString(const string &binaryBaseName) const
 void CommandPcap::execute(const StringVector &args)
 {
     MasterIndexList masterIndices;
+    ofstream file;
+    ostream *out = &cout;
 
-    if (args.size() > 1) {
+    masterIndices = getMasterIndices();
+
+    if (getFollow() && masterIndices.size() != 1) {
         stringstream err;
-        err << "'" << getName() << "' takes max one argument!";
+        err << "--follow requires exactly one master!";
         throwInvalidUsageException(err);
     }
 
-    masterIndices = getMasterIndices();
+    if (!getOutputFile().empty() && getOutputFile() != "-") {
+        file.open(getOutputFile().c_str(),
+                ios::out | ios::trunc | ios::binary);
+        if (!file.good()) {
+            stringstream err;
+            err << "Failed to open '" << getOutputFile() << "'";
+            throwCommandException(err);
+        }
+        out = &file;
+    }
+
     MasterIndexList::const_iterator mi;
     for (mi = masterIndices.begin();
             mi != masterIndices.end(); mi++) {
         ec_ioctl_master_t io;
         MasterDevice m(*mi);
-        m.open(MasterDevice::Read);
+        m.open(args.size() ? MasterDevice::ReadWrite : MasterDevice::Read);
         m.getMaster(&io);
 
-        outputPcapData(m, io.pcap_size);
+        if (!io.pcap_size) {
+            throwCommandException("Pcap logging is not enabled;"
+                    " set PCAP_SIZE_MB and restart master.");
+        }
+
+        if (args.size()) {
+            configure(m, args);
+        }
+
+        if (getVerbosity() == Verbose) {
+            outputStatistics(m);
+        }
+
+        if (getFollow()) {
+            followPcapData(m, *out);
+        } else {
+            outputPcapData(m, io.pcap_size, *out);
+        }
     }
 }
 
 /****************************************************************************/
 
+void CommandPcap::configure(
+        MasterDevice &m,
+        const StringVector &args
+        )
+{
+    ec_ioctl_pcap_config_t config;
+    StringVector::const_iterator ai;
+
+    m.getPcapConfig(&config);
+
+    for (ai = args.begin(); ai != args.end(); ai++) {
+        string::size_type pos = ai->find('=');
+        string key = ai->substr(0, pos);
+        string value = pos == string::npos ? "" : ai->substr(pos + 1);
+        stringstream err;
+
+        for (string::iterator ci = value.begin(); ci != value.end(); ci++) {
+            *ci = toupper(*ci);
+        }
+
+        if (key == "snaplen") {
+            stringstream str;
+            str << value;
+            str >> resetiosflags(ios::basefield) // guess base from prefix
+                >> config.snaplen;
+            if (str.fail() || value.empty()) {
+                err << "Invalid snaplen '" << value << "'!";
+                throwInvalidUsageException(err);
+            }
+        } else if (key == "dir") {
+            if (value == "TX") {
+                config.directions = EC_PCAP_TX;
+            } else if (value == "RX") {
+                config.directions = EC_PCAP_RX;
+            } else if (value == "ALL") {
+                config.directions = EC_PCAP_TX | EC_PCAP_RX;
+            } else {
+                err << "Invalid direction '" << value << "'!";
+                throwInvalidUsageException(err);
+            }
+        } else if (key == "types") {
+            config.types = parseTypes(value);
+        } else {
+            err << "Invalid argument '" << *ai << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    m.setPcapConfig(&config);
+}
+
+/****************************************************************************/
+
+uint32_t CommandPcap::parseTypes(const string &value)
+{
+    stringstream str(value);
+    string name;
+    uint32_t types = 0;
+    unsigned int i;
+
+    if (value == "ALL") {
+        return EC_PCAP_TYPES_ALL;
+    }
+
+    while (getline(str, name, ',')) {
+        for (i = 0; i < sizeof(datagramTypes) / sizeof(datagramTypes[0]);
+                i++) {
+            if (name == datagramTypes[i]) {
+                break;
+            }
+        }
+        if (i == sizeof(datagramTypes) / sizeof(datagramTypes[0])) {
+            stringstream err;
+            err << "Invalid datagram type '" << name << "'!";
+            throwInvalidUsageException(err);
+        }
+        types |= 1 << i;
+    }
+
+    if (!types) {
+        stringstream err;
+        err << "No datagram types given!";
+        throwInvalidUsageException(err);
+    }
+
+    return types;
+}
+
+/****************************************************************************/
+
+void CommandPcap::outputStatistics(
+        MasterDevice &m
+        )
+{
+    ec_ioctl_pcap_config_t config;
+    unsigned int i;
+
+    m.getPcapConfig(&config);
+
+    cerr << "Ring size: " << config.size << " bytes" << endl
+        << "Snapshot length: ";
+    if (config.snaplen) {
+        cerr << config.snaplen << " bytes" << endl;
+    } else {
+        cerr << "unlimited" << endl;
+    }
+    cerr << "Directions:"
+        << (config.directions & EC_PCAP_TX ? " TX" : "")
+        << (config.directions & EC_PCAP_RX ? " RX" : "") << endl
+        << "Datagram types:";
+    if (config.types == EC_PCAP_TYPES_ALL) {
+        cerr << " all";
+    } else {
+        for (i = 0; i < sizeof(datagramTypes) / sizeof(datagramTypes[0]);
+                i++) {
+            if (config.types & (1 << i)) {
+                cerr << " " << datagramTypes[i];
+            }
+        }
+    }
+    cerr << endl
+        << "Captured frames: " << config.frames << endl
+        << "Filtered frames: " << config.filtered << endl
+        << "Overwritten frames: " << config.overwritten << endl;
+}
+
+/****************************************************************************/
+
 void CommandPcap::outputPcapData(
         MasterDevice &m,
-        unsigned int pcap_size
+        unsigned int pcap_size,
+        ostream &out
         )
 {
     ec_ioctl_pcap_data_t data;
     unsigned char pcap_reset = getReset();
     vector<unsigned char> pcap_data;
 
-    if (!pcap_size) {
-        throwCommandException("Pcap logging is not enabled; set PCAP_SIZE_MB and restart master.");
-    }
-      
     pcap_data.resize(pcap_size);
     m.getPcap(&data, pcap_reset, pcap_data.size(), pcap_data.data());
 
-    cout.write(reinterpret_cast<const char*>(pcap_data.data()), data.data_size);
-    cout.flush();
+    out.write(reinterpret_cast<const char*>(pcap_data.data()),
+            data.data_size);
+    out.flush();
+}
+
+/****************************************************************************/
+
+void CommandPcap::followPcapData(
+        MasterDevice &m,
+        ostream &out
+        )
+{
+    ec_ioctl_pcap_data_t header;
+    ec_ioctl_pcap_read_t data;
+    vector<unsigned char> pcap_data(BufferSize);
+
+    // the snapshot ioctl always returns the global header first
+    m.getPcap(&header, 0, PcapHeaderSize, pcap_data.data());
+    out.write(reinterpret_cast<const char*>(pcap_data.data()),
+            header.data_size);
+    out.flush();
+
+    while (out.good()) {
+        m.readPcap(&data, pcap_data.size(), pcap_data.data());
+
+        if (data.lost) {
+            cerr << "Warning: " << data.lost << " bytes of capture data"
+                << " were overwritten before they could be read." << endl;
+        }
+
+        out.write(reinterpret_cast<const char*>(pcap_data.data()),
+                data.data_size);
+        out.flush();
+    }
+
+    throwCommandException("Failed to write pcap data.");
 }
 
 /****************************************************************************/
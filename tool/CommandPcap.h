@@ -44,7 +44,16 @@ class CommandPcap:
         void execute(const StringVector &);
 
     protected:
-        void outputPcapData(MasterDevice &, unsigned int);
+        enum {
+            PcapHeaderSize = 24, /**< Size of the pcap global header. */
+            BufferSize = 0x20000 /**< Read buffer size for --follow. */
+        };
+
+        void configure(MasterDevice &, const StringVector &);
+        static uint32_t parseTypes(const string &);
+        void outputStatistics(MasterDevice &);
+        void outputPcapData(MasterDevice &, unsigned int, ostream &);
+        void followPcapData(MasterDevice &, ostream &);
 };
 
 /****************************************************************************/
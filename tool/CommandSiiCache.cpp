@@ -0,0 +1,178 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2026  Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+using namespace std;
+
+#include "CommandSiiCache.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandSiiCache::CommandSiiCache():
+    Command("sii_cache", "Save or load the persistent SII cache.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandSiiCache::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] <save|load> <FILENAME>" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The SII contents of all slaves that can be identified" << endl
+        << "uniquely (by alias or serial number) are saved. After a" << endl
+        << "module reload, loading the cache lets the bus scan skip" << endl
+        << "reading the EEPROM of these slaves. A cache entry is only" << endl
+        << "used, if the first 16 SII words of the slave still match." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  FILENAME is the path of the cache file. If it is '-'," << endl
+        << "           data are written to stdout or read from stdin."
+        << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master selection. See the help of" << endl
+        << "                       the 'master' command." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandSiiCache::execute(const StringVector &args)
+{
+    stringstream err;
+
+    if (args.size() != 2) {
+        err << "'" << getName() << "' takes exactly two arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args[0] == "save") {
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::Read);
+        save(m, args[1]);
+    } else if (args[0] == "load") {
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::ReadWrite);
+        load(m, args[1]);
+    } else {
+        err << "Invalid action '" << args[0] << "'!";
+        throwInvalidUsageException(err);
+    }
+}
+
+/****************************************************************************/
+
+void CommandSiiCache::save(MasterDevice &m, const string &fileName)
+{
+    stringstream err;
+    ec_ioctl_sii_cache_t data;
+    vector<uint8_t> buffer;
+    ofstream file;
+
+    // query the required size first; it may grow in the meantime
+    data.size = 0;
+    data.data = NULL;
+    m.saveSiiCache(&data);
+
+    do {
+        buffer.resize(data.size);
+        data.data = &buffer[0];
+        m.saveSiiCache(&data);
+    } while (data.size > buffer.size());
+
+    if (fileName == "-") {
+        cout.write((const char *) &buffer[0], data.size);
+    } else {
+        file.open(fileName.c_str(), ofstream::out | ofstream::binary);
+        if (file.fail()) {
+            err << "Failed to open '" << fileName << "'!";
+            throwCommandException(err);
+        }
+        file.write((const char *) &buffer[0], data.size);
+        file.close();
+    }
+
+    if (getVerbosity() == Verbose) {
+        cerr << "Saved " << data.count << " SII cache entries." << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandSiiCache::load(MasterDevice &m, const string &fileName)
+{
+    stringstream err;
+    ec_ioctl_sii_cache_t data;
+    vector<uint8_t> buffer;
+    ifstream file;
+
+    if (fileName == "-") {
+        buffer.assign(istreambuf_iterator<char>(cin),
+                istreambuf_iterator<char>());
+    } else {
+        file.open(fileName.c_str(), ifstream::in | ifstream::binary);
+        if (file.fail()) {
+            err << "Failed to open '" << fileName << "'!";
+            throwCommandException(err);
+        }
+        buffer.assign(istreambuf_iterator<char>(file),
+                istreambuf_iterator<char>());
+        file.close();
+    }
+
+    if (buffer.empty()) {
+        err << "No SII cache data!";
+        throwCommandException(err);
+    }
+
+    data.size = buffer.size();
+    data.data = &buffer[0];
+    m.loadSiiCache(&data);
+
+    if (getVerbosity() == Verbose) {
+        cerr << "Loaded " << data.count << " SII cache entries." << endl;
+    }
+}
+
+/*****************************************************************************/
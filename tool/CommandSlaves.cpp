@@ -125,6 +125,7 @@ void CommandSlaves::execute(const StringVector &args)
             mi != masterIndices.end(); mi++) {
         MasterDevice m(*mi);
         m.open(MasterDevice::Read);
+        m.loadTopology();
         slaves = selectedSlaves(m);
 
         if (getVerbosity() == Verbose) {
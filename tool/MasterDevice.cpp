@@ -45,7 +45,8 @@ using namespace std;
 MasterDevice::MasterDevice(unsigned int index):
     index(index),
     masterCount(0U),
-    fd(-1)
+    fd(-1),
+    topologyLoaded(false)
 {
 }
 
@@ -101,6 +102,8 @@ void MasterDevice::close()
         ::close(fd);
         fd = -1;
     }
+
+    topologyLoaded = false;
 }
 
 /****************************************************************************/
@@ -285,8 +288,238 @@ void MasterDevice::getPcap(ec_ioctl_pcap_data_t *data,
 
 /****************************************************************************/
 
+void MasterDevice::getPcapConfig(ec_ioctl_pcap_config_t *config)
+{
+    config->set = 0;
+
+    if (ioctl(fd, EC_IOCTL_PCAP_CONFIG, config) < 0) {
+        stringstream err;
+        err << "Failed to get pcap configuration: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::setPcapConfig(ec_ioctl_pcap_config_t *config)
+{
+    config->set = 1;
+
+    if (ioctl(fd, EC_IOCTL_PCAP_CONFIG, config) < 0) {
+        stringstream err;
+        err << "Failed to set pcap configuration: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::readPcap(ec_ioctl_pcap_read_t *data,
+        unsigned int dataSize, unsigned char *mem)
+{
+    data->target = mem;
+    data->size = dataSize;
+    data->nonblock = 0;
+
+    if (ioctl(fd, EC_IOCTL_PCAP_READ, data) < 0) {
+        if (errno == EAGAIN) { // records overwritten while reading
+            data->data_size = 0;
+            data->lost = 0;
+            return;
+        }
+        stringstream err;
+        err << "Failed to read pcap data: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getLatency(ec_latency_hist_t *hist, unsigned int type,
+        bool reset)
+{
+    ec_ioctl_latency_t data;
+
+    data.type = type;
+    data.reset = reset;
+    data.hist = hist;
+
+    if (ioctl(fd, EC_IOCTL_LATENCY, &data) < 0) {
+        stringstream err;
+        err << "Failed to get latency histogram: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+uint32_t MasterDevice::getSlaveDcStats(ec_dc_stats_t *stats,
+        uint16_t slavePosition, bool reset)
+{
+    ec_ioctl_slave_dc_stats_t data;
+
+    data.slave_position = slavePosition;
+    data.reset = reset;
+    data.stats = stats;
+
+    if (ioctl(fd, EC_IOCTL_SLAVE_DC_STATS, &data) < 0) {
+        stringstream err;
+        err << "Failed to get DC statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+
+    return data.interval;
+}
+
+/****************************************************************************/
+
+ec_ioctl_esc_monitor_t MasterDevice::getSlaveEscStats(ec_esc_stats_t *stats,
+        uint16_t slavePosition, bool reset)
+{
+    ec_ioctl_slave_esc_stats_t data;
+
+    data.slave_position = slavePosition;
+    data.reset = reset;
+    data.stats = stats;
+
+    if (ioctl(fd, EC_IOCTL_SLAVE_ESC_STATS, &data) < 0) {
+        stringstream err;
+        err << "Failed to get ESC error statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+
+    return data.monitor;
+}
+
+/****************************************************************************/
+
+/** Loads a snapshot of all slaves, sync managers, PDOs and PDO entries.
+ *
+ * Afterwards, getSlave(), getSync(), getPdo() and getPdoEntry() are served
+ * from the snapshot instead of issuing an ioctl() each.
+ */
+void MasterDevice::loadTopology()
+{
+    ec_ioctl_topology_t data;
+    ec_ioctl_topology_header_t header;
+    vector<uint8_t> buffer;
+    const uint8_t *cur;
+    unsigned int i, sync = 0, pdo = 0, entry = 0;
+
+    data.version = EC_IOCTL_TOPOLOGY_VERSION;
+    data.size = 0;
+    data.data = NULL;
+
+    // retry, if the bus was re-scanned between the calls
+    do {
+        buffer.resize(data.size);
+        data.data = buffer.empty() ? NULL : &buffer.front();
+        data.size = buffer.size();
+
+        if (ioctl(fd, EC_IOCTL_TOPOLOGY, &data) < 0) {
+            stringstream err;
+            err << "Failed to get topology: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+    } while (data.size > buffer.size());
+
+    memcpy(&header, &buffer.front(), sizeof(header));
+    if (header.version != EC_IOCTL_TOPOLOGY_VERSION) {
+        stringstream err;
+        err << "Unsupported topology format version " << header.version;
+        throw MasterDeviceException(err);
+    }
+
+    cur = &buffer.front() + sizeof(header);
+    topoSlaves.resize(header.slave_count);
+    topoSyncs.resize(header.sync_count);
+    topoPdos.resize(header.pdo_count);
+    topoEntries.resize(header.entry_count);
+    if (header.slave_count) {
+        memcpy(&topoSlaves.front(), cur,
+                header.slave_count * sizeof(ec_ioctl_slave_t));
+        cur += header.slave_count * sizeof(ec_ioctl_slave_t);
+    }
+    if (header.sync_count) {
+        memcpy(&topoSyncs.front(), cur,
+                header.sync_count * sizeof(ec_ioctl_slave_sync_t));
+        cur += header.sync_count * sizeof(ec_ioctl_slave_sync_t);
+    }
+    if (header.pdo_count) {
+        memcpy(&topoPdos.front(), cur,
+                header.pdo_count * sizeof(ec_ioctl_slave_sync_pdo_t));
+        cur += header.pdo_count * sizeof(ec_ioctl_slave_sync_pdo_t);
+    }
+    if (header.entry_count) {
+        memcpy(&topoEntries.front(), cur,
+                header.entry_count * sizeof(ec_ioctl_slave_sync_pdo_entry_t));
+    }
+
+    firstSync.resize(topoSlaves.size());
+    for (i = 0; i < topoSlaves.size(); i++) {
+        firstSync[i] = sync;
+        sync += topoSlaves[i].sync_count;
+    }
+    firstPdo.resize(topoSyncs.size());
+    for (i = 0; i < topoSyncs.size(); i++) {
+        firstPdo[i] = pdo;
+        pdo += topoSyncs[i].pdo_count;
+    }
+    firstEntry.resize(topoPdos.size());
+    for (i = 0; i < topoPdos.size(); i++) {
+        firstEntry[i] = entry;
+        entry += topoPdos[i].entry_count;
+    }
+
+    if (sync != header.sync_count || pdo != header.pdo_count
+            || entry != header.entry_count) {
+        throw MasterDeviceException("Inconsistent topology snapshot.");
+    }
+
+    topologyLoaded = true;
+}
+
+/****************************************************************************/
+
+const ec_ioctl_slave_sync_t *MasterDevice::cachedSync(
+        uint16_t slaveIndex,
+        uint8_t syncIndex
+        ) const
+{
+    if (!topologyLoaded || slaveIndex >= topoSlaves.size()
+            || syncIndex >= topoSlaves[slaveIndex].sync_count) {
+        return NULL;
+    }
+
+    return &topoSyncs[firstSync[slaveIndex] + syncIndex];
+}
+
+/****************************************************************************/
+
+const ec_ioctl_slave_sync_pdo_t *MasterDevice::cachedPdo(
+        uint16_t slaveIndex,
+        uint8_t syncIndex,
+        uint8_t pdoPos
+        ) const
+{
+    const ec_ioctl_slave_sync_t *sync = cachedSync(slaveIndex, syncIndex);
+
+    if (!sync || pdoPos >= sync->pdo_count) {
+        return NULL;
+    }
+
+    return &topoPdos[firstPdo[sync - &topoSyncs.front()] + pdoPos];
+}
+
+/****************************************************************************/
+
 void MasterDevice::getSlave(ec_ioctl_slave_t *slave, uint16_t slaveIndex)
 {
+    if (topologyLoaded && slaveIndex < topoSlaves.size()) {
+        *slave = topoSlaves[slaveIndex];
+        return;
+    }
+
     slave->position = slaveIndex;
 
     if (ioctl(fd, EC_IOCTL_SLAVE, slave)) {
@@ -326,6 +559,13 @@ void MasterDevice::getSync(
         uint8_t syncIndex
         )
 {
+    const ec_ioctl_slave_sync_t *cached = cachedSync(slaveIndex, syncIndex);
+
+    if (cached) {
+        *sync = *cached;
+        return;
+    }
+
     sync->slave_position = slaveIndex;
     sync->sync_index = syncIndex;
 
@@ -345,6 +585,14 @@ void MasterDevice::getPdo(
         uint8_t pdoPos
         )
 {
+    const ec_ioctl_slave_sync_pdo_t *cached =
+        cachedPdo(slaveIndex, syncIndex, pdoPos);
+
+    if (cached) {
+        *pdo = *cached;
+        return;
+    }
+
     pdo->slave_position = slaveIndex;
     pdo->sync_index = syncIndex;
     pdo->pdo_pos = pdoPos;
@@ -366,6 +614,14 @@ void MasterDevice::getPdoEntry(
         uint8_t entryPos
         )
 {
+    const ec_ioctl_slave_sync_pdo_t *pdo =
+        cachedPdo(slaveIndex, syncIndex, pdoPos);
+
+    if (pdo && entryPos < pdo->entry_count) {
+        *entry = topoEntries[firstEntry[pdo - &topoPdos.front()] + entryPos];
+        return;
+    }
+
     entry->slave_position = slaveIndex;
     entry->sync_index = syncIndex;
     entry->pdo_pos = pdoPos;
@@ -444,6 +700,32 @@ void MasterDevice::writeSii(
 
 /****************************************************************************/
 
+void MasterDevice::loadSiiCache(
+        ec_ioctl_sii_cache_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SII_CACHE_LOAD, data) < 0) {
+        stringstream err;
+        err << "Failed to load SII cache: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::saveSiiCache(
+        ec_ioctl_sii_cache_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SII_CACHE_SAVE, data) < 0) {
+        stringstream err;
+        err << "Failed to save SII cache: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::readReg(
         ec_ioctl_slave_reg_t *data
         )
@@ -483,6 +765,19 @@ void MasterDevice::readWriteReg(
 
 /****************************************************************************/
 
+void MasterDevice::sweepRegs(
+        ec_ioctl_slave_reg_sweep_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SLAVE_REG_SWEEP, data) < 0) {
+        stringstream err;
+        err << "Failed to sweep registers: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::readFoe(
         ec_ioctl_slave_foe_t *data
         )
@@ -520,6 +815,33 @@ void MasterDevice::setDebug(unsigned int debugLevel)
 
 /****************************************************************************/
 
+void MasterDevice::setDcMonitor(uint32_t interval)
+{
+    if (ioctl(fd, EC_IOCTL_DC_MONITOR, &interval) < 0) {
+        stringstream err;
+        err << "Failed to set DC monitor interval: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::setEscMonitor(uint32_t interval, uint32_t threshold)
+{
+    ec_ioctl_esc_monitor_t data;
+
+    data.interval = interval;
+    data.threshold = threshold;
+
+    if (ioctl(fd, EC_IOCTL_ESC_MONITOR, &data) < 0) {
+        stringstream err;
+        err << "Failed to configure ESC monitor: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::rescan()
 {
     if (ioctl(fd, EC_IOCTL_MASTER_RESCAN, 0) < 0) {
@@ -32,6 +32,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 using namespace std;
 
 #include "ecrt.h"
@@ -142,6 +143,14 @@ class MasterDevice
                 unsigned char *);
         void getPcap(ec_ioctl_pcap_data_t *, unsigned char, unsigned int,
                 unsigned char *);
+        void getPcapConfig(ec_ioctl_pcap_config_t *);
+        void setPcapConfig(ec_ioctl_pcap_config_t *);
+        void readPcap(ec_ioctl_pcap_read_t *, unsigned int, unsigned char *);
+        void getLatency(ec_latency_hist_t *, unsigned int, bool);
+        uint32_t getSlaveDcStats(ec_dc_stats_t *, uint16_t, bool);
+        ec_ioctl_esc_monitor_t getSlaveEscStats(ec_esc_stats_t *, uint16_t,
+                bool);
+        void loadTopology();
         void getSlave(ec_ioctl_slave_t *, uint16_t);
         void getSync(ec_ioctl_slave_sync_t *, uint16_t, uint8_t);
         void getPdo(ec_ioctl_slave_sync_pdo_t *, uint16_t, uint8_t, uint8_t);
@@ -151,10 +160,15 @@ class MasterDevice
         void getSdoEntry(ec_ioctl_slave_sdo_entry_t *, uint16_t, int, uint8_t);
         void readSii(ec_ioctl_slave_sii_t *);
         void writeSii(ec_ioctl_slave_sii_t *);
+        void loadSiiCache(ec_ioctl_sii_cache_t *);
+        void saveSiiCache(ec_ioctl_sii_cache_t *);
         void readReg(ec_ioctl_slave_reg_t *);
         void writeReg(ec_ioctl_slave_reg_t *);
         void readWriteReg(ec_ioctl_slave_reg_t *);
+        void sweepRegs(ec_ioctl_slave_reg_sweep_t *);
         void setDebug(unsigned int);
+        void setDcMonitor(uint32_t);
+        void setEscMonitor(uint32_t, uint32_t);
         void rescan();
         void sdoDownload(ec_ioctl_slave_sdo_download_t *);
         void sdoUpload(ec_ioctl_slave_sdo_upload_t *);
@@ -179,6 +193,20 @@ class MasterDevice
         unsigned int index;
         unsigned int masterCount;
         int fd;
+
+        /** Topology snapshot, see loadTopology(). */
+        bool topologyLoaded;
+        vector<ec_ioctl_slave_t> topoSlaves;
+        vector<ec_ioctl_slave_sync_t> topoSyncs;
+        vector<ec_ioctl_slave_sync_pdo_t> topoPdos;
+        vector<ec_ioctl_slave_sync_pdo_entry_t> topoEntries;
+        vector<unsigned int> firstSync; /**< Per slave. */
+        vector<unsigned int> firstPdo; /**< Per sync manager. */
+        vector<unsigned int> firstEntry; /**< Per PDO. */
+
+        const ec_ioctl_slave_sync_t *cachedSync(uint16_t, uint8_t) const;
+        const ec_ioctl_slave_sync_pdo_t *cachedPdo(uint16_t, uint8_t,
+                uint8_t) const;
 };
 
 /****************************************************************************/
@@ -40,10 +40,12 @@ using namespace std;
 #include "CommandCrc.h"
 #include "CommandCStruct.h"
 #include "CommandData.h"
+#include "CommandDc.h"
 #include "CommandDebug.h"
 #include "CommandDiag.h"
 #include "CommandDomains.h"
 #include "CommandDownload.h"
+#include "CommandErrors.h"
 #ifdef EC_EOE
 #include "CommandEoe.h"
 #include "CommandEoeAddIf.h"
@@ -55,6 +57,7 @@ using namespace std;
 #ifdef EC_EOE
 # include "CommandIp.h"
 #endif
+#include "CommandLatency.h"
 #include "CommandMaster.h"
 #include "CommandPcap.h"
 #include "CommandPdos.h"
@@ -64,6 +67,7 @@ using namespace std;
 #include "CommandReboot.h"
 #include "CommandRescan.h"
 #include "CommandSdos.h"
+#include "CommandSiiCache.h"
 #include "CommandSiiRead.h"
 #include "CommandSiiWrite.h"
 #include "CommandSlaves.h"
@@ -96,6 +100,7 @@ bool force = false;
 bool emergency = false;
 bool helpRequested = false;
 bool reset = false;
+bool follow = false;
 string outputFile;
 string skin;
 
@@ -164,6 +169,7 @@ void getOptions(int argc, char **argv)
         {"emergency",   no_argument,       NULL, 'e'},
         {"force",       no_argument,       NULL, 'f'},
         {"reset",       no_argument,       NULL, 'r'},
+        {"follow",      no_argument,       NULL, 'F'},
         {"quiet",       no_argument,       NULL, 'q'},
         {"verbose",     no_argument,       NULL, 'v'},
         {"help",        no_argument,       NULL, 'h'},
@@ -171,7 +177,7 @@ void getOptions(int argc, char **argv)
     };
 
     do {
-        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efrqvh", longOptions, NULL);
+        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efrFqvh", longOptions, NULL);
 
         switch (c) {
             case 'm':
@@ -214,6 +220,10 @@ void getOptions(int argc, char **argv)
                 reset = true;
                 break;
 
+            case 'F':
+                follow = true;
+                break;
+
             case 'q':
                 verbosity = Command::Quiet;
                 break;
@@ -306,10 +316,12 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandCrc());
     commandList.push_back(new CommandCStruct());
     commandList.push_back(new CommandData());
+    commandList.push_back(new CommandDc());
     commandList.push_back(new CommandDebug());
     commandList.push_back(new CommandDiag());
     commandList.push_back(new CommandDomains());
     commandList.push_back(new CommandDownload());
+    commandList.push_back(new CommandErrors());
 #ifdef EC_EOE
     commandList.push_back(new CommandEoe());
     commandList.push_back(new CommandEoeAddIf());
@@ -321,6 +333,7 @@ int main(int argc, char **argv)
 #ifdef EC_EOE
     commandList.push_back(new CommandIp());
 #endif
+    commandList.push_back(new CommandLatency());
     commandList.push_back(new CommandMaster());
     commandList.push_back(new CommandPcap());
     commandList.push_back(new CommandPdos());
@@ -330,6 +343,7 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandReboot());
     commandList.push_back(new CommandRescan());
     commandList.push_back(new CommandSdos());
+    commandList.push_back(new CommandSiiCache());
     commandList.push_back(new CommandSiiRead());
     commandList.push_back(new CommandSiiWrite());
     commandList.push_back(new CommandSlaves());
@@ -360,6 +374,7 @@ int main(int argc, char **argv)
                     cmd->setEmergency(emergency);
                     cmd->setForce(force);
                     cmd->setReset(reset);
+                    cmd->setFollow(follow);
                     cmd->execute(commandArgs);
                 } catch (InvalidUsageException &e) {
                     cerr << e.what() << endl << endl;